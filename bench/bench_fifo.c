@@ -0,0 +1,110 @@
+/*
+ * Cost of the IP FIFO copy loops (QSPI_Fifo_Fill/QSPI_Fifo_Drain).
+ *
+ * Usage: qspi_fifo_bench [-n iterations]
+ *
+ * The loops run against a fake 128-byte FIFO window in ordinary memory and
+ * are built with QSPI_NO_RECORDER, so only the copy is measured, including the
+ * unaligned word loads and stores on buffer offsets 1..3. Each case selects
+ * one path:
+ *   bulk  whole watermark chunks (8-byte multiples, the TX bulk branch)
+ *   words word multiples below the FIFO window
+ *   tail  sizes with 1..3 trailing bytes packed into one last word
+ *
+ * Output is CSV after a '#' header:
+ *   dir,path,size,align,iterations,cycles_per_byte,ns_per_byte
+ * cycles are cycles_now() ticks (the TSC on x86, the generic timer on ARM).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cycles.h"
+#include "qspi_fifo.h"
+#include "utils.h"
+
+#define BENCH_ITERATIONS 20000
+#define BENCH_ALIGNMENTS 4
+#define FIFO_WORDS       32
+#define FIFO_PHYS        0x30BB0180
+
+static uint32_t fifo[FIFO_WORDS];
+static uint8_t  buffer[FIFO_WORDS * 4 + BENCH_ALIGNMENTS];
+
+static const struct
+{
+    const char *path;
+    size_t      size;
+} cases[] = {
+    {"bulk", 8}, {"bulk", 32}, {"bulk", 64}, {"bulk", 128},
+    {"words", 4}, {"words", 12}, {"words", 60}, {"words", 124},
+    {"tail", 1}, {"tail", 3}, {"tail", 7}, {"tail", 63}, {"tail", 127},
+};
+
+static void run(int fill, const char *path, size_t size, size_t align, size_t iterations)
+{
+    uint8_t *data = buffer + align;
+
+    uint64_t c0 = cycles_now(), t0 = now_ns();
+    for (size_t i = 0; i < iterations; i++)
+    {
+        if (fill)
+        {
+            QSPI_Fifo_Fill(fifo, FIFO_PHYS, data, size);
+        }
+        else
+        {
+            QSPI_Fifo_Drain(fifo, FIFO_PHYS, data, size);
+        }
+    }
+    uint64_t c1 = cycles_now(), t1 = now_ns();
+
+    double bytes = (double)size * (double)iterations;
+    printf("%s,%s,%zu,%zu,%zu,%.3f,%.3f\n", fill ? "tx" : "rx", path, size, align, iterations, (double)(c1 - c0) / bytes,
+           (double)(t1 - t0) / bytes);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t iterations = BENCH_ITERATIONS;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            iterations = strtoul(argv[++i], NULL, 0);
+        }
+        else
+        {
+            printf("Usage: %s [-n iterations]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (iterations == 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < sizeof(buffer); i++)
+    {
+        buffer[i] = (uint8_t)i;
+    }
+
+    printf("# fifo_bytes=%d iterations=%zu\n", FIFO_WORDS * 4, iterations);
+    printf("dir,path,size,align,iterations,cycles_per_byte,ns_per_byte\n");
+
+    for (int fill = 1; fill >= 0; fill--)
+    {
+        for (size_t c = 0; c < lengthof(cases); c++)
+        {
+            for (size_t align = 0; align < BENCH_ALIGNMENTS; align++)
+            {
+                run(fill, cases[c].path, cases[c].size, align, iterations);
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,321 @@
+/*
+ * Throughput and latency of the driver entry points.
+ *
+ * Usage: qspi_bench [--hw [--wr seq]] [-n iterations] [-o op] [-p]
+ *
+ * Runs against the simulated register block unless --hw is given, in which
+ * case /dev/mem is mapped and the FPGA LUT is loaded like qspi_tool does.
+ * The write ops send the byte pattern through a LUT sequence to the FPGA, on
+ * hardware they only run with --wr naming a sequence whose target tolerates
+ * it; without it they are skipped.
+ * Every payload size from 4 bytes to QSPI_MAX_TRANSFER_SIZE (powers of two
+ * plus one odd size per step) is measured at buffer offsets 0..3.
+ *
+ * Output is one CSV line per case after a '#' header, so runs of different
+ * releases can be diffed or loaded into a spreadsheet:
+ *   op,size,align,iterations,ns_mean,ns_p50,ns_p90,ns_p99,ns_max,mb_per_s
+ * With -p, each op is followed by '#' lines with the transfer_blocking()
+ * phase histograms (see qspi_phase.h), in cycles over all its cases.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cycles.h"
+#include "fpga_interface.h"
+#include "qspi.h"
+#include "qspi_phase.h"
+#include "slog.h"
+
+#define BENCH_ITERATIONS 2000
+#define BENCH_ALIGNMENTS 4
+#define BENCH_ADDRESS    0x1000
+
+/* Not exported by qspi.h, the raw transfer without logging or status capture */
+int transfer_blocking(FlexSPI_Type *fspi, flexspi_transfer_t *xfer);
+
+typedef int (*bench_op_t)(uint8_t *buffer, size_t size);
+
+static FlexSPI_Type *bench_fspi;
+static uint8_t       bench_wr_seq = FPGA_LUT_IDX_WR_GENERIC_CMD; // Only sent as is to the simulated registers
+
+/* The register block is only known when simulated, QSPI_Transfer() wraps the same call on hardware */
+static int raw_transfer(flexspi_transfer_t *xfer)
+{
+    return bench_fspi != NULL ? transfer_blocking(bench_fspi, xfer) : QSPI_Transfer(xfer);
+}
+
+static int op_read(uint8_t *buffer, size_t size)
+{
+    return QSPI_Read(BENCH_ADDRESS, buffer, size);
+}
+
+static int op_write(uint8_t *buffer, size_t size)
+{
+    return QSPI_Write(BENCH_ADDRESS, bench_wr_seq, buffer, size);
+}
+
+static int op_read_sample(uint8_t *buffer, size_t size)
+{
+    return QSPI_ReadSample(BENCH_ADDRESS, buffer, size);
+}
+
+static int op_transfer_read(uint8_t *buffer, size_t size)
+{
+    flexspi_transfer_t xfer;
+    memset(&xfer, 0, sizeof(xfer));
+    xfer.deviceAddress = BENCH_ADDRESS;
+    xfer.port          = kFlexSPI_PortA1;
+    xfer.cmdType       = kFLEXSPI_Read;
+    xfer.seqIndex      = FPGA_LUT_IDX_RD_SAMPLE;
+    xfer.SeqNumber     = 1;
+    xfer.data          = (uint32_t *)(void *)buffer;
+    xfer.dataSize      = size;
+    return raw_transfer(&xfer);
+}
+
+static int op_transfer_write(uint8_t *buffer, size_t size)
+{
+    flexspi_transfer_t xfer;
+    memset(&xfer, 0, sizeof(xfer));
+    xfer.deviceAddress = BENCH_ADDRESS;
+    xfer.port          = kFlexSPI_PortA1;
+    xfer.cmdType       = kFLEXSPI_Write;
+    xfer.seqIndex      = bench_wr_seq;
+    xfer.SeqNumber     = 1;
+    xfer.data          = (uint32_t *)(void *)buffer;
+    xfer.dataSize      = size;
+    return raw_transfer(&xfer);
+}
+
+static const struct
+{
+    const char *name;
+    bench_op_t  fn;
+    int         writes; // Sends the payload to the FPGA
+} bench_ops[] = {
+    {"read", op_read, 0},
+    {"write", op_write, 1},
+    {"read_sample", op_read_sample, 0},
+    {"transfer_read", op_transfer_read, 0},
+    {"transfer_write", op_transfer_write, 1},
+};
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t percentile(const uint64_t *sorted, size_t count, unsigned pct)
+{
+    size_t index = (count * pct + 99) / 100;
+    return sorted[index ? index - 1 : 0];
+}
+
+static int run_case(const char *name, bench_op_t fn, size_t size, size_t align, uint8_t *buffer, uint64_t *samples, size_t iterations)
+{
+    uint8_t *data = buffer + align;
+    uint64_t total = 0;
+
+    // Warm up caches and branch predictors before sampling
+    for (size_t i = 0; i < iterations / 10 + 1; i++)
+    {
+        if (fn(data, size) != 0)
+        {
+            fprintf(stderr, "%s failed (size %zu, align %zu)\n", name, size, align);
+            return -1;
+        }
+    }
+
+    for (size_t i = 0; i < iterations; i++)
+    {
+        uint64_t start = now_ns();
+        fn(data, size);
+        samples[i] = now_ns() - start;
+        total += samples[i];
+    }
+
+    qsort(samples, iterations, sizeof(*samples), compare_u64);
+
+    double mean = (double)total / (double)iterations;
+    printf("%s,%zu,%zu,%zu,%.1f,%llu,%llu,%llu,%llu,%.2f\n", name, size, align, iterations, mean,
+           (unsigned long long)percentile(samples, iterations, 50), (unsigned long long)percentile(samples, iterations, 90),
+           (unsigned long long)percentile(samples, iterations, 99), (unsigned long long)samples[iterations - 1],
+           mean > 0 ? (double)size * 1000.0 / mean : 0.0);
+    return 0;
+}
+
+static void print_phases(const char *name)
+{
+    for (qspi_phase_t phase = 0; phase < QSPI_PHASE_COUNT; phase++)
+    {
+        qspi_phase_summary_t summary;
+        QSPI_Phase_Summary(phase, &summary);
+        printf("# phase op=%s phase=%s count=%llu p50=%llu p90=%llu p99=%llu max=%llu\n", name, QSPI_Phase_Name(phase),
+               (unsigned long long)summary.count, (unsigned long long)summary.p50, (unsigned long long)summary.p90,
+               (unsigned long long)summary.p99, (unsigned long long)summary.max);
+    }
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [--hw [--wr seq]] [-n iterations] [-o op] [-p]\n", prog);
+    printf("  --hw             Use the FlexSPI controller instead of the simulated registers\n");
+    printf("  --wr seq         LUT sequence of the write ops, required for them on hardware\n");
+    printf("  -n iterations    Timed calls per case (default %d)\n", BENCH_ITERATIONS);
+    printf("  -o op            Only run one of:");
+    for (size_t i = 0; i < lengthof(bench_ops); i++)
+    {
+        printf(" %s", bench_ops[i].name);
+    }
+    printf("\n");
+    printf("  -p               Print the phase histograms of each op\n");
+}
+
+int main(int argc, char *argv[])
+{
+    int         hardware   = 0;
+    size_t      iterations = BENCH_ITERATIONS;
+    const char *only       = NULL;
+    int         phases     = 0;
+    int         wr_seq     = -1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--hw") == 0)
+        {
+            hardware = 1;
+        }
+        else if (strcmp(argv[i], "--wr") == 0 && i + 1 < argc)
+        {
+            char         *end;
+            unsigned long seq = strtoul(argv[++i], &end, 0);
+            if (*end != '\0' || seq >= FPGA_OPCODE_IDX_COUNT)
+            {
+                fprintf(stderr, "Invalid LUT sequence for --wr: %s\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+            wr_seq = (int)seq;
+        }
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            iterations = strtoul(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            only = argv[++i];
+        }
+        else if (strcmp(argv[i], "-p") == 0)
+        {
+            phases = 1;
+        }
+        else
+        {
+            usage(argv[0]);
+            return strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    if (iterations == 0)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (wr_seq >= 0)
+    {
+        bench_wr_seq = (uint8_t)wr_seq;
+    }
+
+    // The FPGA forwards whatever a write sequence carries, the pattern must not reach an arbitrary target
+    int skip_writes = hardware && wr_seq < 0;
+    for (size_t op = 0; op < lengthof(bench_ops) && skip_writes && only != NULL; op++)
+    {
+        if (bench_ops[op].writes && strcmp(only, bench_ops[op].name) == 0)
+        {
+            fprintf(stderr, "%s on hardware needs --wr, pick a sequence that is safe to write\n", only);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Logging stays off so the numbers cover the driver, not slog
+    slog_init("qspi_bench", 0, 0);
+
+    if (hardware)
+    {
+        QSPI_Init();
+        if (!QSPI_IsInitialized())
+        {
+            fprintf(stderr, "QSPI initialization failed, run as root on the target\n");
+            slog_destroy();
+            return EXIT_FAILURE;
+        }
+        QSPI_SetupLut((uint32_t *)fpga_lut, sizeof(fpga_lut));
+    }
+    else
+    {
+        bench_fspi = QSPI_InitSimulated();
+    }
+
+    uint8_t  *buffer  = malloc(QSPI_MAX_TRANSFER_SIZE + BENCH_ALIGNMENTS);
+    uint64_t *samples = malloc(iterations * sizeof(*samples));
+    if (buffer == NULL || samples == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        free(buffer);
+        free(samples);
+        QSPI_DeInit();
+        slog_destroy();
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < QSPI_MAX_TRANSFER_SIZE + BENCH_ALIGNMENTS; i++)
+    {
+        buffer[i] = (uint8_t)i;
+    }
+
+    int ret = EXIT_SUCCESS;
+
+    printf("# backend=%s iterations=%zu max_size=%d wr_seq=%u\n", hardware ? "hardware" : "simulated", iterations, QSPI_MAX_TRANSFER_SIZE,
+           bench_wr_seq);
+    if (skip_writes)
+    {
+        printf("# write ops skipped, pass --wr to run them on hardware\n");
+    }
+    printf("op,size,align,iterations,ns_mean,ns_p50,ns_p90,ns_p99,ns_max,mb_per_s\n");
+
+    for (size_t op = 0; op < lengthof(bench_ops) && ret == EXIT_SUCCESS; op++)
+    {
+        if ((only != NULL && strcmp(only, bench_ops[op].name) != 0) || (skip_writes && bench_ops[op].writes))
+        {
+            continue;
+        }
+
+        QSPI_Phase_Reset();
+        for (size_t size = 4; size <= QSPI_MAX_TRANSFER_SIZE && ret == EXIT_SUCCESS; size *= 2)
+        {
+            size_t odd = size + size / 2 + 1;
+
+            for (size_t align = 0; align < BENCH_ALIGNMENTS && ret == EXIT_SUCCESS; align++)
+            {
+                if (run_case(bench_ops[op].name, bench_ops[op].fn, size, align, buffer, samples, iterations) != 0 ||
+                    (odd <= QSPI_MAX_TRANSFER_SIZE && run_case(bench_ops[op].name, bench_ops[op].fn, odd, align, buffer, samples, iterations) != 0))
+                {
+                    ret = EXIT_FAILURE;
+                }
+            }
+        }
+
+        if (phases)
+        {
+            print_phases(bench_ops[op].name);
+        }
+    }
+
+    free(buffer);
+    free(samples);
+    QSPI_DeInit();
+    slog_destroy();
+    return ret;
+}
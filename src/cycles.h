@@ -0,0 +1,66 @@
+#ifndef CYCLES_H
+#define CYCLES_H
+
+#include <stdint.h>
+#include <time.h>
+
+/* CLOCK_MONOTONIC in nanoseconds, for wall time spans of benchmarks and sweeps */
+static inline uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * Cheapest monotonic timestamp of the platform: the generic timer on AArch64,
+ * the TSC on x86, CLOCK_MONOTONIC nanoseconds elsewhere.
+ */
+static inline uint64_t cycles_now(void)
+{
+#if defined(__aarch64__)
+    uint64_t value;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#elif defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return now_ns();
+#endif
+}
+
+/* Ticks per second of cycles_now(), 0 when unknown (TSC) */
+static inline uint64_t cycles_freq(void)
+{
+#if defined(__aarch64__)
+    uint64_t value;
+    __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(value));
+    return value;
+#elif defined(__x86_64__) || defined(__i386__)
+    return 0;
+#else
+    return 1000000000ULL;
+#endif
+}
+
+/* cycles_freq(), measured against CLOCK_MONOTONIC over 10 ms when the counter rate is not architectural */
+static inline uint64_t cycles_calibrate(void)
+{
+    uint64_t hz = cycles_freq();
+    if (hz != 0)
+    {
+        return hz;
+    }
+
+    struct timespec pause = {0, 10 * 1000 * 1000}, t0, t1;
+    uint64_t        c0 = cycles_now();
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    nanosleep(&pause, NULL);
+    uint64_t c1 = cycles_now();
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    double ns = (double)(t1.tv_sec - t0.tv_sec) * 1e9 + (double)(t1.tv_nsec - t0.tv_nsec);
+    return ns > 0 ? (uint64_t)((double)(c1 - c0) * 1e9 / ns) : 0;
+}
+
+#endif // CYCLES_H
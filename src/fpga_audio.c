@@ -0,0 +1,274 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "fpga_audio.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <time.h>
+
+#include "qspi.h"
+
+#include "slog.h"
+
+#define NSEC_PER_SEC 1000000000LL
+
+typedef struct
+{
+    fpga_audio_config_t cfg;
+    int32_t            *ring;     // capacity frames of cfg.channels values
+    int32_t            *silence;  // period_frames of zeros
+    uint32_t            capacity; // Power of two
+    uint32_t            max_fill; // Frames kept at most, pushes beyond are dropped
+    pthread_t           thread;
+
+    _Atomic uint64_t head; // Frames pushed
+    _Atomic uint64_t tail; // Frames written to the sink
+    _Atomic int      running;
+
+    _Atomic uint64_t underruns;
+    _Atomic uint64_t overruns;
+} fpga_audio_t;
+
+static fpga_audio_t audio;
+
+static size_t frame_bytes(const fpga_audio_t *a)
+{
+    return a->cfg.channels * sizeof(int32_t);
+}
+
+static int write_all(int fd, struct iovec *iov, int cnt)
+{
+    while (cnt > 0)
+    {
+        ssize_t n = writev(fd, iov, cnt);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -errno;
+        }
+
+        while (cnt > 0 && (size_t)n >= iov->iov_len)
+        {
+            n -= (ssize_t)iov->iov_len;
+            iov++;
+            cnt--;
+        }
+        if (cnt > 0)
+        {
+            iov->iov_base = (uint8_t *)iov->iov_base + n;
+            iov->iov_len -= (size_t)n;
+        }
+    }
+    return 0;
+}
+
+/* Writes one period: buffered frames first (none unless drain), silence for
+   whatever is missing. Sets *underrun when silence was inserted. */
+static int write_period(fpga_audio_t *a, int drain, int *underrun)
+{
+    uint64_t tail  = atomic_load_explicit(&a->tail, memory_order_relaxed);
+    uint64_t head  = atomic_load_explicit(&a->head, memory_order_acquire);
+    uint32_t want  = a->cfg.period_frames;
+    uint32_t avail = (uint32_t)(head - tail) < want ? (uint32_t)(head - tail) : want;
+
+    if (!drain)
+    {
+        avail = 0;
+    }
+    *underrun = avail < want;
+
+    struct iovec iov[3];
+    int          cnt   = 0;
+    uint32_t     start = (uint32_t)tail & (a->capacity - 1);
+    uint32_t     first = avail < a->capacity - start ? avail : a->capacity - start;
+
+    if (first > 0)
+    {
+        iov[cnt++] = (struct iovec){&a->ring[start * a->cfg.channels], first * frame_bytes(a)};
+    }
+    if (avail > first)
+    {
+        iov[cnt++] = (struct iovec){a->ring, (avail - first) * frame_bytes(a)};
+    }
+    if (avail < want)
+    {
+        iov[cnt++] = (struct iovec){a->silence, (want - avail) * frame_bytes(a)};
+        atomic_fetch_add_explicit(&a->underruns, want - avail, memory_order_relaxed);
+    }
+
+    int ret = write_all(a->cfg.fd, iov, cnt);
+    atomic_store_explicit(&a->tail, tail + avail, memory_order_release);
+    return ret;
+}
+
+static void *writer_thread(void *arg)
+{
+    fpga_audio_t   *a      = arg;
+    int64_t         period = (int64_t)a->cfg.period_frames * NSEC_PER_SEC / a->cfg.rate_hz;
+    int             primed  = 0;
+    int             started = 0;
+    struct timespec next;
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (atomic_load_explicit(&a->running, memory_order_relaxed))
+    {
+        uint64_t fill = atomic_load_explicit(&a->head, memory_order_acquire) - atomic_load_explicit(&a->tail, memory_order_relaxed);
+
+        if (!primed && fill >= a->cfg.latency_frames)
+        {
+            slogd("Audio bridge primed with %llu frames", (unsigned long long)fill);
+            primed  = 1;
+            started = 1;
+        }
+
+        /* After an underrun the sink keeps getting silence until latency_frames
+           are buffered again, otherwise the delay would shrink to the jitter. */
+        if (started)
+        {
+            int underrun;
+            int ret = write_period(a, primed, &underrun);
+            if (primed && underrun)
+            {
+                slogd("Audio bridge underrun, re-priming");
+                primed = 0;
+            }
+            if (ret != 0)
+            {
+                sloge("Audio sink write failed: %s", strerror(-ret));
+                atomic_store(&a->running, 0);
+                break;
+            }
+        }
+
+        next.tv_nsec += period;
+        while (next.tv_nsec >= NSEC_PER_SEC)
+        {
+            next.tv_nsec -= NSEC_PER_SEC;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+
+    return NULL;
+}
+
+int FPGA_McASP_Configure(const fpga_mcasp_cfg_t *cfg)
+{
+    assert(cfg != NULL);
+
+    slogi("McASP config: %u Hz, %u channels, %u bit slots, format %u", cfg->sample_rate, cfg->channels, cfg->slot_bits, cfg->format);
+
+    fpga_mcasp_cfg_t payload = *cfg;
+    return QSPI_Write(0, FPGA_LUT_IDX_WR_MCASP_CFG, (uint8_t *)&payload, sizeof(payload));
+}
+
+int FPGA_Audio_Start(const fpga_audio_config_t *cfg)
+{
+    assert(cfg != NULL);
+
+    if (atomic_load(&audio.running))
+    {
+        return -EBUSY;
+    }
+    FPGA_Audio_Stop(); // Reaps a writer that stopped on a sink error
+    if (cfg->fd < 0 || cfg->rate_hz == 0 || cfg->channels == 0 || cfg->channels > MAX_AN_CH || cfg->period_frames == 0)
+    {
+        return -EINVAL;
+    }
+
+    memset(&audio, 0, sizeof(audio));
+    audio.cfg      = *cfg;
+    audio.max_fill = cfg->latency_frames + cfg->period_frames;
+    audio.capacity = 1;
+    while (audio.capacity < audio.max_fill)
+    {
+        audio.capacity <<= 1;
+    }
+
+    audio.ring    = calloc(audio.capacity, frame_bytes(&audio));
+    audio.silence = calloc(cfg->period_frames, frame_bytes(&audio));
+    if (audio.ring == NULL || audio.silence == NULL)
+    {
+        free(audio.ring);
+        free(audio.silence);
+        audio.ring    = NULL;
+        audio.silence = NULL;
+        return -ENOMEM;
+    }
+
+    atomic_store(&audio.running, 1);
+    int ret = pthread_create(&audio.thread, NULL, writer_thread, &audio);
+    if (ret != 0)
+    {
+        atomic_store(&audio.running, 0);
+        free(audio.ring);
+        free(audio.silence);
+        audio.ring    = NULL;
+        audio.silence = NULL;
+        return -ret;
+    }
+
+    slogi("Audio bridge started: %u Hz, %u channels, %u frames latency", cfg->rate_hz, cfg->channels, cfg->latency_frames);
+    return 0;
+}
+
+int FPGA_Audio_Push(const fpga_sample_t *sample)
+{
+    assert(sample != NULL);
+
+    uint64_t head = atomic_load_explicit(&audio.head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&audio.tail, memory_order_acquire);
+
+    if (!atomic_load_explicit(&audio.running, memory_order_relaxed))
+    {
+        return -ENODEV;
+    }
+    if (head - tail >= audio.max_fill)
+    {
+        atomic_fetch_add_explicit(&audio.overruns, 1, memory_order_relaxed);
+        return -ENOSPC;
+    }
+
+    uint32_t slot = (uint32_t)head & (audio.capacity - 1);
+    memcpy(&audio.ring[slot * audio.cfg.channels], sample->smp, frame_bytes(&audio));
+    atomic_store_explicit(&audio.head, head + 1, memory_order_release);
+
+    return 0;
+}
+
+void FPGA_Audio_Stop(void)
+{
+    if (audio.ring == NULL)
+    {
+        return;
+    }
+
+    atomic_store(&audio.running, 0);
+    pthread_join(audio.thread, NULL);
+
+    free(audio.ring);
+    free(audio.silence);
+    audio.ring    = NULL;
+    audio.silence = NULL;
+}
+
+void FPGA_Audio_GetStats(fpga_audio_stats_t *stats)
+{
+    assert(stats != NULL);
+
+    stats->frames_in  = atomic_load(&audio.head);
+    stats->frames_out = atomic_load(&audio.tail) + atomic_load(&audio.underruns);
+    stats->underruns  = atomic_load(&audio.underruns);
+    stats->overruns   = atomic_load(&audio.overruns);
+}
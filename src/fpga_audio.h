@@ -0,0 +1,60 @@
+#ifndef FPGA_AUDIO_H
+#define FPGA_AUDIO_H
+
+#include <stdint.h>
+
+#include "fpga_interface.h"
+
+/*
+ * McASP configuration and audio-rate bridge for the acquisition channels.
+ *
+ * The acquisition thread hands every sample to FPGA_Audio_Push(), which copies
+ * the channel values into a lock-free frame ring. A writer thread drains the
+ * ring at the configured frame rate into a file descriptor as interleaved
+ * S32_LE frames, straight from the ring memory. The sink can be a file, a FIFO
+ * or a pipe into e.g. `aplay -D hw:Loopback -f S32_LE -c <channels> -r <rate>`.
+ *
+ * Output starts once latency_frames are buffered and the fill level is kept
+ * there: an empty ring produces silence until latency_frames are buffered
+ * again and a full ring drops new frames, so the delay between acquisition
+ * and sink stays fixed.
+ */
+
+typedef struct
+{
+    int      fd;             // Sink, owned by the caller
+    uint32_t rate_hz;        // Frame rate
+    uint8_t  channels;       // First N analog channels, up to MAX_AN_CH
+    uint32_t latency_frames; // Buffering between acquisition and sink
+    uint32_t period_frames;  // Frames written per wakeup
+} fpga_audio_config_t;
+
+typedef struct
+{
+    uint64_t frames_in;
+    uint64_t frames_out;
+    uint64_t underruns; // Frames of silence inserted
+    uint64_t overruns;  // Frames dropped because the ring was full
+} fpga_audio_stats_t;
+
+/**
+ * @brief Sends the McASP configuration to the FPGA with WR_MCASP_CFG.
+ *
+ * @return 0 on success, non-zero otherwise.
+ */
+int FPGA_McASP_Configure(const fpga_mcasp_cfg_t *cfg);
+
+int FPGA_Audio_Start(const fpga_audio_config_t *cfg);
+
+/**
+ * @brief Queues the channels of one sample. Never blocks.
+ *
+ * @return 0 on success, -ENOSPC when the frame was dropped, -ENODEV when not started.
+ */
+int FPGA_Audio_Push(const fpga_sample_t *sample);
+
+void FPGA_Audio_Stop(void);
+
+void FPGA_Audio_GetStats(fpga_audio_stats_t *stats);
+
+#endif // FPGA_AUDIO_H
@@ -0,0 +1,160 @@
+#include "fpga_clock.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+#include "fpga_interface.h"
+#include "qspi_sched.h"
+
+#include "slog.h"
+
+#define NSEC_PER_SEC 1000000000LL
+
+typedef struct
+{
+    fpga_clock_config_t cfg;
+    fpga_clock_status_t status;
+    double              drift_ppb; // Integral term
+    int64_t             next_ns;   // Monotonic time of the next measurement
+    int                 busy;      // A read or write is still queued
+
+    fpga_mst_clk_t     now;
+    fpga_mst_clk_adj_t adj;
+    qspi_sched_req_t   read_req;
+    qspi_sched_req_t   write_req;
+} fpga_clock_t;
+
+static fpga_clock_t clk;
+
+static int64_t clock_ns(clockid_t id)
+{
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (int64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static int64_t system_reference(void *ctx)
+{
+    (void)ctx;
+    return clock_ns(CLOCK_REALTIME);
+}
+
+static double clamp(double value, double limit)
+{
+    return value > limit ? limit : (value < -limit ? -limit : value);
+}
+
+static void on_write(qspi_sched_req_t *req, int result)
+{
+    (void)req;
+    if (result != 0)
+    {
+        slogw("WR_MST_CLK failed: %d", result);
+    }
+    clk.busy = 0;
+}
+
+static void on_read(qspi_sched_req_t *req, int result)
+{
+    (void)req;
+    int64_t ref = clk.cfg.reference(clk.cfg.reference_ctx);
+
+    if (result != 0)
+    {
+        slogw("RD_MST_CLK failed: %d", result);
+        clk.busy = 0;
+        return;
+    }
+
+    int64_t offset = (int64_t)clk.now.sec * NSEC_PER_SEC + clk.now.nsec - ref;
+    double  dt     = clk.cfg.interval_ms / 1000.0;
+
+    double ppb = 0;
+
+    memset(&clk.adj, 0, sizeof(clk.adj));
+    if (offset > clk.cfg.step_threshold_ns || offset < -clk.cfg.step_threshold_ns)
+    {
+        // Too far off to slew in reasonable time, step and restart the integrator
+        clk.adj.step_ns = (int32_t)clamp((double)-offset, (double)INT32_MAX);
+        clk.drift_ppb   = 0;
+        clk.status.steps++;
+    }
+    else
+    {
+        clk.drift_ppb = clamp(clk.drift_ppb + clk.cfg.ki * offset / dt, clk.cfg.max_ppb);
+        ppb           = clamp(clk.cfg.kp * offset / dt + clk.drift_ppb, clk.cfg.max_ppb);
+    }
+    clk.adj.freq_ppb = (int32_t)-ppb;
+
+    clk.status.offset_ns = offset;
+    clk.status.freq_ppb  = clk.adj.freq_ppb;
+    clk.status.samples++;
+    slogd("Master clock offset %lld ns, trim %d ppb, step %d ns", (long long)offset, clk.adj.freq_ppb, clk.adj.step_ns);
+
+    if (QSPI_Sched_Submit(&clk.write_req) != 0)
+    {
+        clk.busy = 0;
+    }
+}
+
+static void init_req(qspi_sched_req_t *req, flexspi_command_type_t type, uint8_t seq, void *data, uint16_t size, qspi_sched_cb_t done)
+{
+    memset(req, 0, sizeof(*req));
+    req->cls            = QSPI_SCHED_IDLE;
+    req->done           = done;
+    req->xfer.port      = kFlexSPI_PortA1;
+    req->xfer.cmdType   = type;
+    req->xfer.seqIndex  = seq;
+    req->xfer.SeqNumber = 1;
+    req->xfer.data      = data;
+    req->xfer.dataSize  = size;
+}
+
+int FPGA_Clock_Init(const fpga_clock_config_t *cfg)
+{
+    assert(cfg != NULL);
+
+    // A zero threshold steps every sample, negative gains or limits run away instead of converging
+    if (cfg->interval_ms == 0 || cfg->step_threshold_ns <= 0 || cfg->max_ppb <= 0 ||
+        !isfinite(cfg->kp) || !isfinite(cfg->ki) || cfg->kp < 0 || cfg->ki < 0)
+    {
+        return -EINVAL;
+    }
+
+    memset(&clk, 0, sizeof(clk));
+    clk.cfg = *cfg;
+    if (clk.cfg.reference == NULL)
+    {
+        clk.cfg.reference = system_reference;
+    }
+
+    init_req(&clk.read_req, kFLEXSPI_Read, FPGA_LUT_IDX_RD_MST_CLK, &clk.now, sizeof(clk.now), on_read);
+    init_req(&clk.write_req, kFLEXSPI_Write, FPGA_LUT_IDX_WR_MST_CLK, &clk.adj, sizeof(clk.adj), on_write);
+    clk.next_ns = clock_ns(CLOCK_MONOTONIC);
+    return 0;
+}
+
+void FPGA_Clock_Poll(void)
+{
+    int64_t now = clock_ns(CLOCK_MONOTONIC);
+
+    if (clk.busy || clk.cfg.interval_ms == 0 || now < clk.next_ns)
+    {
+        return;
+    }
+
+    clk.next_ns = now + (int64_t)clk.cfg.interval_ms * 1000000;
+    if (QSPI_Sched_Submit(&clk.read_req) == 0)
+    {
+        clk.busy = 1;
+    }
+}
+
+void FPGA_Clock_GetStatus(fpga_clock_status_t *status)
+{
+    assert(status != NULL);
+    *status = clk.status;
+}
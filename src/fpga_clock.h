@@ -0,0 +1,55 @@
+#ifndef FPGA_CLOCK_H
+#define FPGA_CLOCK_H
+
+#include <stdint.h>
+
+/*
+ * FPGA master clock discipline.
+ *
+ * Every interval the FPGA master clock is read with RD_MST_CLK and compared to
+ * a reference (system time by default, or a PPS-derived time). A PI controller
+ * turns the offset into a frequency trim, large offsets are stepped, and the
+ * correction is written with WR_MST_CLK. Both commands are queued in the idle
+ * class of the bus scheduler, so they only use bus time left over by the
+ * acquisition. FPGA_Clock_Poll() must run on the thread that calls
+ * QSPI_Sched_Dispatch().
+ */
+
+/* Returns the reference time in nanoseconds */
+typedef int64_t (*fpga_clock_ref_t)(void *ctx);
+
+typedef struct
+{
+    uint32_t         interval_ms;       // Time between two measurements
+    double           kp;                // Proportional gain
+    double           ki;                // Integral gain
+    int64_t          step_threshold_ns; // Larger offsets are stepped instead of slewed
+    int32_t          max_ppb;           // Frequency trim limit
+    fpga_clock_ref_t reference;         // NULL uses CLOCK_REALTIME
+    void            *reference_ctx;
+} fpga_clock_config_t;
+
+typedef struct
+{
+    int64_t  offset_ns; // FPGA time minus reference at the last measurement
+    int32_t  freq_ppb;  // Trim currently applied
+    uint32_t samples;   // Measurements taken
+    uint32_t steps;     // Phase steps applied
+} fpga_clock_status_t;
+
+/**
+ * @brief Resets the controller and schedules the first measurement.
+ *
+ * @return 0 on success, -EINVAL for a zero interval, a step threshold or
+ *         max_ppb not above 0, or a negative or non-finite gain.
+ */
+int FPGA_Clock_Init(const fpga_clock_config_t *cfg);
+
+/**
+ * @brief Queues the next measurement once the interval elapsed. Never blocks.
+ */
+void FPGA_Clock_Poll(void);
+
+void FPGA_Clock_GetStatus(fpga_clock_status_t *status);
+
+#endif // FPGA_CLOCK_H
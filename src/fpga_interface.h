@@ -52,6 +52,29 @@ typedef struct {
   uint32_t dummy2;
 } fpga_sample_t;
 
+/* RD_MST_CLK payload: FPGA master clock time */
+typedef struct {
+  uint32_t sec;
+  uint32_t nsec;
+} fpga_mst_clk_t;
+
+/* WR_MST_CLK payload: frequency trim and phase step applied by the FPGA */
+typedef struct {
+  int32_t freq_ppb;
+  int32_t step_ns;
+} fpga_mst_clk_adj_t;
+
+/* WR_MCASP_CFG payload */
+typedef struct {
+  uint32_t sample_rate; // Frame rate in Hz
+  uint8_t channels;     // Active TDM slots
+  uint8_t slot_bits;    // 16, 24 or 32
+  uint8_t format;       // fpga_mcasp_format_t
+  uint8_t enable;
+} fpga_mcasp_cfg_t;
+
+typedef enum { FPGA_MCASP_I2S = 0, FPGA_MCASP_TDM, FPGA_MCASP_LEFT_J } fpga_mcasp_format_t;
+
 // clang-format off
 extern const uint32_t fpga_lut[FPGA_OPCODE_IDX_COUNT * 4];
 // clang-format on
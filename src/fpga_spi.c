@@ -0,0 +1,151 @@
+#include "fpga_spi.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "fpga_interface.h"
+#include "qspi.h"
+
+#include "slog.h"
+
+#define FPGA_SPI_HEADER_SIZE sizeof(fpga_spi_header_t)
+#define FPGA_SPI_MAX_LEN     (QSPI_MAX_TRANSFER_SIZE - FPGA_SPI_HEADER_SIZE)
+
+static const uint8_t wr_seq[FPGA_SPI_BUS_COUNT] = {FPGA_LUT_IDX_WR_SPI1, FPGA_LUT_IDX_WR_SPI2};
+static const uint8_t rd_seq[FPGA_SPI_BUS_COUNT] = {FPGA_LUT_IDX_RD_SPI1, FPGA_LUT_IDX_RD_SPI2};
+
+static int validate(const fpga_spi_transfer_t *xfers, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (xfers[i].len > FPGA_SPI_MAX_LEN)
+        {
+            slogw("SPI transfer %zu too long: %u > %zu", i, xfers[i].len, FPGA_SPI_MAX_LEN);
+            return -EMSGSIZE;
+        }
+        if (xfers[i].bits_per_word != 0 && xfers[i].bits_per_word != 8)
+        {
+            slogw("SPI transfer %zu: %u bits per word not supported", i, xfers[i].bits_per_word);
+            return -EINVAL;
+        }
+    }
+    return 0;
+}
+
+/* Frames as many leading transfers as fit into one WR command and one RD command. */
+static size_t pack_batch(const fpga_spi_transfer_t *xfers, size_t count, uint8_t *pkt, size_t *pkt_len, size_t *rx_len)
+{
+    size_t n, used = 0, rx = 0;
+
+    for (n = 0; n < count; n++)
+    {
+        const fpga_spi_transfer_t *x = &xfers[n];
+        size_t need    = FPGA_SPI_HEADER_SIZE + x->len;
+        size_t rx_need = x->rx_buf ? x->len : 0;
+
+        if (used + need > QSPI_MAX_TRANSFER_SIZE || rx + rx_need > QSPI_MAX_TRANSFER_SIZE)
+        {
+            break;
+        }
+
+        uint8_t flags = (x->cs_change ? FPGA_SPI_FLAG_CS_CHANGE : 0) | (x->rx_buf ? FPGA_SPI_FLAG_RX : 0);
+
+        pkt[used++] = (uint8_t)(x->len & 0xFF);
+        pkt[used++] = (uint8_t)(x->len >> 8);
+        pkt[used++] = flags;
+        pkt[used++] = (uint8_t)(x->delay_usecs > UINT8_MAX ? UINT8_MAX : x->delay_usecs);
+
+        if (x->tx_buf)
+        {
+            memcpy(&pkt[used], (const void *)(uintptr_t)x->tx_buf, x->len);
+        }
+        else
+        {
+            memset(&pkt[used], 0, x->len);
+        }
+        used += x->len;
+        rx += rx_need;
+    }
+
+    *pkt_len = used;
+    *rx_len  = rx;
+    return n;
+}
+
+static void scatter_rx(const fpga_spi_transfer_t *xfers, size_t count, const uint8_t *rx)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (xfers[i].rx_buf)
+        {
+            memcpy((void *)(uintptr_t)xfers[i].rx_buf, rx, xfers[i].len);
+            rx += xfers[i].len;
+        }
+    }
+}
+
+int FPGA_SPI_Transfer(fpga_spi_bus_t bus, const fpga_spi_transfer_t *xfers, size_t count)
+{
+    // uint32_t backing keeps the FIFO copy loops on aligned words
+    uint32_t pkt[QSPI_MAX_TRANSFER_SIZE / sizeof(uint32_t)];
+    uint32_t rx[QSPI_MAX_TRANSFER_SIZE / sizeof(uint32_t)];
+    int      total = 0;
+
+    if (bus >= FPGA_SPI_BUS_COUNT || (xfers == NULL && count > 0))
+    {
+        return -EINVAL;
+    }
+    if (!QSPI_IsInitialized())
+    {
+        return -ENODEV;
+    }
+
+    int ret = validate(xfers, count);
+    if (ret != 0)
+    {
+        return ret;
+    }
+
+    while (count > 0)
+    {
+        size_t pkt_len, rx_len;
+        size_t batch = pack_batch(xfers, count, (uint8_t *)pkt, &pkt_len, &rx_len);
+        assert(batch > 0);
+
+        slogt("SPI%d batch: %zu transfers, %zu bytes out, %zu bytes in", bus + 1, batch, pkt_len, rx_len);
+
+        if (QSPI_Write(0, wr_seq[bus], (uint8_t *)pkt, pkt_len) != 0)
+        {
+            return -EIO;
+        }
+
+        if (rx_len > 0)
+        {
+            flexspi_transfer_t xfer;
+            memset(&xfer, 0, sizeof(xfer));
+            xfer.port      = kFlexSPI_PortA1;
+            xfer.cmdType   = kFLEXSPI_Read;
+            xfer.seqIndex  = rd_seq[bus];
+            xfer.SeqNumber = 1;
+            xfer.data      = rx;
+            xfer.dataSize  = rx_len;
+
+            if (QSPI_Transfer(&xfer) != 0)
+            {
+                return -EIO;
+            }
+            scatter_rx(xfers, batch, (const uint8_t *)rx);
+        }
+
+        for (size_t i = 0; i < batch; i++)
+        {
+            total += (int)xfers[i].len;
+        }
+        xfers += batch;
+        count -= batch;
+    }
+
+    return total;
+}
@@ -0,0 +1,53 @@
+#ifndef FPGA_SPI_H
+#define FPGA_SPI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * SPI passthrough to the SPI masters inside the FPGA (WR_SPIx / RD_SPIx).
+ *
+ * Transfers are described like struct spi_ioc_transfer, so spidev code ports by
+ * swapping the struct and the ioctl for FPGA_SPI_Transfer(). Consecutive
+ * transfers are packed into one WR_SPIx IP command, each one framed by a
+ * fpga_spi_header_t, and the received bytes of the whole batch are fetched
+ * with a single RD_SPIx command.
+ */
+
+typedef enum
+{
+    FPGA_SPI_BUS1 = 0,
+    FPGA_SPI_BUS2,
+    FPGA_SPI_BUS_COUNT
+} fpga_spi_bus_t;
+
+typedef struct
+{
+    uint64_t tx_buf;        // Bytes to shift out, 0 to send zeros
+    uint64_t rx_buf;        // Bytes shifted in, 0 to discard them
+    uint32_t len;           // Transfer length in bytes
+    uint32_t speed_hz;      // Ignored, the FPGA SPI clock is fixed
+    uint16_t delay_usecs;   // Delay after the transfer, clamped to 255
+    uint8_t  bits_per_word; // Only 0 (default) and 8 are supported
+    uint8_t  cs_change;     // Deassert chip select after this transfer
+} fpga_spi_transfer_t;
+
+/* Frame header in front of every transfer in a WR_SPIx payload (little endian). */
+typedef struct
+{
+    uint16_t len;
+    uint8_t  flags;
+    uint8_t  delay_usecs;
+} fpga_spi_header_t;
+
+#define FPGA_SPI_FLAG_CS_CHANGE (1 << 0)
+#define FPGA_SPI_FLAG_RX        (1 << 1)
+
+/**
+ * @brief Executes a sequence of SPI transfers on one FPGA SPI bus.
+ *
+ * @return Total number of bytes transferred, or a negative errno value.
+ */
+int FPGA_SPI_Transfer(fpga_spi_bus_t bus, const fpga_spi_transfer_t *xfers, size_t count);
+
+#endif // FPGA_SPI_H
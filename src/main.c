@@ -1,3 +1,4 @@
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -9,6 +10,9 @@
 #include <unistd.h>
 
 #include "fpga_interface.h"
+#include "qspi_metrics.h"
+#include "qspi_sweep.h"
+#include "qspi_trace.h"
 
 #define VERSION "0.1.5"
 
@@ -35,20 +39,305 @@ static int parse_flags(int argc, char *argv[])
         {
             flags &= ~SLOG_INFO;
         }
+        else if (strcmp(argv[i], "--no-trace") == 0)
+        {
+            flags &= ~SLOG_TRACE;
+        }
         else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
         {
             printf("Usage: %s [options]\n", argv[0]);
+            printf("       %s sweep [sweep options] [options]\n", argv[0]);
             printf("Options:\n");
             printf("  --no-debug       Disable debug logging\n");
             printf("  --no-info        Disable info logging\n");
+            printf("  --no-trace       Disable trace logging (register and transfer tracing)\n");
+            printf("  --trace <file>   Write a Chrome/Perfetto trace of the bus operations\n");
+            printf("  --metrics        Publish the bus counters in shared memory for tools/qspi_metrics\n");
             printf("  -nl              Disable all logging\n");
             printf("  -h, --help      Show this help message\n");
+            printf("Sweep options (lists are comma separated):\n");
+            printf("  --mux <list>     Clock mux values (default 2)\n");
+            printf("  --pre <list>     Pre-divider values (default 0)\n");
+            printf("  --post <list>    Post-divider values (default 7,5,3,1)\n");
+            printf("  --txwm <list>    IP TX FIFO watermarks in 64-bit entries (default 1,4,8,16)\n");
+            printf("  --rxwm <list>    IP RX FIFO watermarks in 64-bit entries (default 1,4,8,16)\n");
+            printf("  --bytes <n>      Payload of each command (default 256)\n");
+            printf("  -n <n>           Write/read pairs per setting (default 100)\n");
+            printf("  --addr <addr>    Device address of the workload (default 0)\n");
+            printf("  --wr <seq>       LUT sequence of the writes (required on hardware, WR_SPI1 with --sim)\n");
+            printf("  --rd <seq>       LUT sequence of the reads (required on hardware, RD_SPI1 with --sim)\n");
+            printf("  --verify         Compare the read data with the written data (needs a loopback pair)\n");
+            printf("  --sim            Run against the simulated register block\n");
             exit(EXIT_SUCCESS);
         }
     }
     return flags;
 }
 
+static const char *parse_trace(int argc, char *argv[])
+{
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], "--trace") == 0)
+        {
+            return argv[i + 1];
+        }
+    }
+    return NULL;
+}
+
+static int has_option(int argc, char *argv[], const char *opt)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], opt) == 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Counters of this run readable by tools/qspi_metrics until the driver is torn down */
+static void publish_metrics(void)
+{
+    int err = QSPI_Metrics_Publish();
+    if (err != 0)
+    {
+        slogw("Metrics not published: %s", strerror(-err));
+    }
+}
+
+/* Starts recording a trace for path, returns path or NULL when tracing is unavailable */
+static const char *start_trace(const char *path)
+{
+    if (path != NULL && QSPI_Trace_Start(1 << 16) != 0)
+    {
+        slogw("Tracing unavailable");
+        return NULL;
+    }
+    return path;
+}
+
+static void save_trace(const char *path)
+{
+    if (path == NULL)
+    {
+        return;
+    }
+    QSPI_Trace_Stop();
+    if (QSPI_Trace_Save(path) != 0)
+    {
+        slogw("Failed to write trace to %s", path);
+    }
+    QSPI_Trace_Free();
+}
+
+static int parse_number(const char *opt, const char *arg, uint32_t max, uint32_t *value)
+{
+    char         *end;
+    unsigned long v;
+
+    errno = 0;
+    v     = arg != NULL ? strtoul(arg, &end, 0) : 0;
+    if (arg == NULL || end == arg || *end != '\0' || errno != 0 || v > max)
+    {
+        fprintf(stderr, "Invalid value for %s: %s\n", opt, arg != NULL ? arg : "(none)");
+        return -1;
+    }
+    *value = (uint32_t)v;
+    return 0;
+}
+
+static int parse_sweep(int argc, char *argv[], qspi_sweep_config_t *cfg, int *simulated)
+{
+    QSPI_Sweep_Defaults(cfg);
+    *simulated = 0;
+
+    for (int i = 2; i < argc; i++)
+    {
+        const char        *opt  = argv[i];
+        const char        *arg  = i + 1 < argc ? argv[i + 1] : NULL;
+        qspi_sweep_list_t *list = NULL;
+        uint32_t           value;
+
+        if (strcmp(opt, "--verify") == 0)
+        {
+            cfg->verify = 1;
+            continue;
+        }
+        if (strcmp(opt, "--sim") == 0)
+        {
+            *simulated = 1;
+            continue;
+        }
+        if (strcmp(opt, "-nl") == 0 || strcmp(opt, "--no-debug") == 0 || strcmp(opt, "--no-info") == 0 || strcmp(opt, "--no-trace") == 0)
+        {
+            continue; // Handled by parse_flags()
+        }
+        if (strcmp(opt, "--metrics") == 0)
+        {
+            continue; // Handled by run_sweep()
+        }
+
+        if (strcmp(opt, "--mux") == 0)
+        {
+            list = &cfg->mux;
+        }
+        else if (strcmp(opt, "--pre") == 0)
+        {
+            list = &cfg->pre;
+        }
+        else if (strcmp(opt, "--post") == 0)
+        {
+            list = &cfg->post;
+        }
+        else if (strcmp(opt, "--txwm") == 0)
+        {
+            list = &cfg->tx_wm;
+        }
+        else if (strcmp(opt, "--rxwm") == 0)
+        {
+            list = &cfg->rx_wm;
+        }
+        else if (strcmp(opt, "--trace") == 0)
+        {
+            i++; // Handled by parse_trace(), recorded by run_sweep()
+            continue;
+        }
+        else if (strcmp(opt, "--bytes") == 0)
+        {
+            if (parse_number(opt, arg, QSPI_MAX_TRANSFER_SIZE, &cfg->bytes) != 0)
+            {
+                return -1;
+            }
+            i++;
+            continue;
+        }
+        else if (strcmp(opt, "-n") == 0)
+        {
+            if (parse_number(opt, arg, UINT32_MAX, &cfg->iterations) != 0)
+            {
+                return -1;
+            }
+            i++;
+            continue;
+        }
+        else if (strcmp(opt, "--addr") == 0)
+        {
+            if (parse_number(opt, arg, UINT32_MAX, &cfg->addr) != 0)
+            {
+                return -1;
+            }
+            i++;
+            continue;
+        }
+        else if (strcmp(opt, "--wr") == 0 || strcmp(opt, "--rd") == 0)
+        {
+            if (parse_number(opt, arg, FPGA_OPCODE_IDX_COUNT - 1, &value) != 0)
+            {
+                return -1;
+            }
+            *(strcmp(opt, "--wr") == 0 ? &cfg->wr_seq : &cfg->rd_seq) = (uint8_t)value;
+            i++;
+            continue;
+        }
+        else
+        {
+            fprintf(stderr, "Unknown sweep option: %s\n", opt);
+            return -1;
+        }
+
+        if (QSPI_Sweep_ParseList(arg, list) != 0)
+        {
+            fprintf(stderr, "Invalid list for %s: %s\n", opt, arg != NULL ? arg : "(none)");
+            return -1;
+        }
+        i++;
+    }
+
+    if (cfg->wr_seq == QSPI_SWEEP_SEQ_NONE || cfg->rd_seq == QSPI_SWEEP_SEQ_NONE)
+    {
+        if (!*simulated)
+        {
+            // The FPGA forwards the written pattern to whatever the sequence addresses
+            fprintf(stderr, "Sweep on hardware needs --wr and --rd, pick a sequence pair that is safe to write\n");
+            return -1;
+        }
+        if (cfg->wr_seq == QSPI_SWEEP_SEQ_NONE)
+        {
+            cfg->wr_seq = FPGA_LUT_IDX_WR_SPI1;
+        }
+        if (cfg->rd_seq == QSPI_SWEEP_SEQ_NONE)
+        {
+            cfg->rd_seq = FPGA_LUT_IDX_RD_SPI1;
+        }
+    }
+    return 0;
+}
+
+static int run_sweep(int argc, char *argv[], uint16_t nFlags, const char *pTrace)
+{
+    qspi_sweep_config_t cfg;
+    int                 simulated;
+
+    if (parse_sweep(argc, argv, &cfg, &simulated) != 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    // Every transfer logs at info level and below, which would dominate the timing
+    slog_init("qspi_tool", nFlags & ~(SLOG_INFO | SLOG_DEBUG | SLOG_TRACE), 0);
+
+    if (simulated)
+    {
+        QSPI_InitSimulated();
+    }
+    else
+    {
+        QSPI_Init();
+    }
+    if (!QSPI_IsInitialized())
+    {
+        slogf("QSPI initialization failed");
+        slog_destroy();
+        return EXIT_FAILURE;
+    }
+    QSPI_SetupLut((uint32_t *)fpga_lut, sizeof(fpga_lut));
+    if (has_option(argc, argv, "--metrics"))
+    {
+        publish_metrics();
+    }
+
+    size_t               max     = QSPI_Sweep_Count(&cfg);
+    qspi_sweep_result_t *results = calloc(max ? max : 1, sizeof(*results));
+    int                  count   = -ENOMEM;
+
+    if (results != NULL)
+    {
+        pTrace = start_trace(pTrace);
+        count  = QSPI_Sweep_Run(&cfg, results, max);
+        save_trace(pTrace);
+    }
+
+    if (count >= 0)
+    {
+        printf("# bytes=%u iterations=%u wr_seq=%u rd_seq=%u verify=%d backend=%s\n", cfg.bytes, cfg.iterations, cfg.wr_seq, cfg.rd_seq, cfg.verify,
+               simulated ? "simulated" : "hw");
+        QSPI_Sweep_Print(stdout, results, (size_t)count);
+    }
+    else
+    {
+        slogf("Sweep failed: %s", strerror(-count));
+    }
+
+    free(results);
+    QSPI_Metrics_Unpublish();
+    QSPI_DeInit();
+    slog_destroy();
+    return count >= 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 const uint32_t test_lut[] = {
     [0] = FLEXSPI_LUT_SEQ(LUT_CMD, kFlexSPI_4PAD, 0x8F, LUT_READ, kFlexSPI_4PAD, LUT_DUMMY),
     [1] = 0,
@@ -58,7 +347,13 @@ const uint32_t test_lut[] = {
 
 int main(int argc, char *argv[])
 {
-    uint16_t nFlags = parse_flags(argc, argv);
+    uint16_t    nFlags = parse_flags(argc, argv);
+    const char *pTrace = parse_trace(argc, argv);
+
+    if (argc > 1 && strcmp(argv[1], "sweep") == 0)
+    {
+        return run_sweep(argc, argv, nFlags, pTrace);
+    }
 
     assert(QSPI_IsInitialized() == 0 && "QSPI should not be initialized at the start");
     slog_init("qspi_tool", nFlags, 0);
@@ -76,10 +371,27 @@ int main(int argc, char *argv[])
     }
     slogi("QSPI initialized successfully");
 
+    // Reads the status block after every transfer, so only with trace logging
+    if (SLOG_ENABLED(SLOG_TRACE))
+    {
+        QSPI_Status_Subscribe(QSPI_Status_Log, NULL);
+    }
+
+    if (has_option(argc, argv, "--metrics"))
+    {
+        publish_metrics();
+    }
+
+    pTrace = start_trace(pTrace);
+
     if(QSPI_Write(0xCAFECAFE, 0,NULL , 0) != 0) {
         slogf("QSPI write failed");
     }
 
+    save_trace(pTrace);
+
+    QSPI_Metrics_Unpublish();
+    QSPI_Status_Unsubscribe(QSPI_Status_Log, NULL);
     QSPI_DeInit();
     slog_destroy();
     return EXIT_SUCCESS;
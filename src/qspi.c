@@ -4,7 +4,9 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <pthread.h>
 #include <signal.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -15,6 +17,11 @@
 
 #include "flexspi.h"
 #include "fpga_interface.h"
+#include "qspi_fifo.h"
+#include "qspi_metrics.h"
+#include "qspi_phase.h"
+#include "qspi_recorder.h"
+#include "qspi_trace.h"
 #include "utils.h"
 
 #include "slog.h"
@@ -32,6 +39,15 @@
 
 #define LOG_REGISTER(VIRT, PHY) slogt("0x%0lX (0x%0lX): 0x%08X", PHY, VIRT, PTR_U32VALUE(VIRT));
 
+/* Register accessors, every access lands in the flight recorder (qspi_recorder.h) */
+#define FSPI_PHYS(FSPI, REG)        (FLEXSPI_BASE + (uint32_t)((uintptr_t)&(FSPI)->REG - (uintptr_t)(FSPI)))
+#define FSPI_READ(FSPI, REG)        mmio_read(&(FSPI)->REG, FSPI_PHYS(FSPI, REG))
+#define FSPI_WRITE(FSPI, REG, VAL)  mmio_write(&(FSPI)->REG, FSPI_PHYS(FSPI, REG), (VAL))
+#define FSPI_PEEK(FSPI, REG)        mmio_peek(&(FSPI)->REG)
+#define FSPI_POLLED(FSPI, REG, FIRST, LAST, SPINS) QSPI_Recorder_Poll(FSPI_PHYS(FSPI, REG), (FIRST), (LAST), (SPINS))
+#define FSPI_SET(FSPI, REG, BITS)   FSPI_WRITE(FSPI, REG, FSPI_READ(FSPI, REG) | (BITS))
+#define FSPI_CLEAR(FSPI, REG, BITS) FSPI_WRITE(FSPI, REG, FSPI_READ(FSPI, REG) & ~(BITS))
+
 #define REG(BASE, OFFSET)      (void *)(UINT64(BASE) + UINT64(OFFSET))
 #define VIRT_REG(VIRT, OFFSET) REG((VIRT), (OFFSET))
 #define CCM_REG(OFFSET)        REG(CCM_BASE, (OFFSET))
@@ -53,7 +69,18 @@ typedef struct QSPI_Context
     int           page_size;
     int           init_done;
     int           lut_seted;
+    int           simulated;
+    uint32_t      clk_mux;  // Current QSPI_CLK_ROOT settings
+    uint32_t      pre_div;
+    uint32_t      post_div;
+    uint32_t      tx_wm;    // IP FIFO watermarks in 64-bit entries, programmed with every command
+    uint32_t      rx_wm;
+    int           wm_adaptive; // QSPI_WATERMARK_ADAPTIVE, else the fixed tx_wm/rx_wm
+    uint32_t      sim_faults;  // INTR error bits every simulated command raises, QSPI_SimulateFault()
+    uint32_t      last_seq;    // LUT sequence of the last command, pending errors belong to it
+    int           err_counted; // The pending INTR error is already in the metrics
     FlexSPI_Type *flexspi;
+    void         *ccm;      // CCM registers inside map_ccm, NULL when not mapped
     void         *map_fspi;
     void         *map_ccm;
     void         *map_rdc;
@@ -66,17 +93,34 @@ typedef enum CommandSeequence
     CMD_WRITE = 0,
 } CommandSeequence;
 
+/* Clock set up by QSPI_Init(), QSPI_SetClock() changes it at runtime */
 static const uint32_t pre_div  = 0;   // Pre-divider value (1-8)
 static const uint32_t post_div = 0x7; // Post-divider value (1-64
 static const uint32_t clk_mux  = 0x2; // Clock mux value (see _ccm_rootmux_xxx enumeration)
 
+#define CLK_MUX_MAX  0x7
+#define PRE_DIV_MAX  0x7
+#define POST_DIV_MAX 0x3F
+
+typedef struct
+{
+    pthread_mutex_t  lock;
+    _Atomic int      count;
+    qspi_status_cb_t cb[QSPI_STATUS_SUBSCRIBERS_MAX];
+    void            *ctx[QSPI_STATUS_SUBSCRIBERS_MAX];
+    qspi_status_t    prev;
+} QSPI_StatusSubscribers;
+
 static QSPI_Context qspi_ctx;
+static FlexSPI_Type qspi_sim_regs;
+static QSPI_StatusSubscribers qspi_status = {.lock = PTHREAD_MUTEX_INITIALIZER};
 
 static void segfault_sigaction(int signal, siginfo_t *si, void *arg)
 {
-    (void)signal;
     (void)arg;
-    slogf("Caught segfault at address %p", si->si_addr);
+    // Dump first, the teardown below is not async-signal-safe
+    QSPI_Recorder_DumpFile();
+    slogf("Caught %s at address %p", signal == SIGBUS ? "bus error" : "segfault", si->si_addr);
     QSPI_DeInit();
     slog_destroy();
     exit(EXIT_FAILURE);
@@ -110,32 +154,45 @@ static int request_flexspi_memory(QSPI_Context *ctx)
     return 0;
 }
 
+static void clock_set(QSPI_Context *ctx, uint32_t mux, uint32_t pre, uint32_t post)
+{
+    assert(ctx != NULL);
+    assert(ctx->ccm != NULL);
+    uint32_t value;
+
+    value = CLK_ROOT_EN | MUX_CLK_ROOT_SELECT(mux) | PRE_PODF(pre) | POST_PODF(post);
+
+    mmio_write(VIRT_REG(ctx->ccm, QSPI_CLK_ROOT), CCM_BASE + QSPI_CLK_ROOT, value);
+    // PTR_U32VALUE(VIRT_REG(ccm_base, QSPI_CLK_ROOT)) = 0x07000002;
+    value = mmio_read(VIRT_REG(ctx->ccm, QSPI_CLK_ROOT), CCM_BASE + QSPI_CLK_ROOT);
+    mmio_write(VIRT_REG(ctx->ccm, QSPI_CLK_ROOT), CCM_BASE + QSPI_CLK_ROOT, value | CLK_ROOT_EN);
+    LOG_REGISTER(VIRT_REG(ctx->ccm, QSPI_CLK_ROOT), REG(CCM_BASE, QSPI_CLK_ROOT));
+
+    ctx->clk_mux  = mux;
+    ctx->pre_div  = pre;
+    ctx->post_div = post;
+}
+
 static void clock_init(QSPI_Context *ctx, uint32_t mux, uint32_t pre, uint32_t post)
 {
     assert(ctx != NULL);
     assert(ctx->fd >= 0);
-    void    *ccm_base;
-    uint32_t value;
 
     if (map_memory(&ctx->map_ccm, ctx->fd, CCM_BASE, PAGE_SIZE_64K, ctx->page_size) != 0)
     {
         slogf("Failed to mmap CCM base: %s", strerror(errno));
+        ctx->map_ccm = NULL;
         return;
     }
 
-    ccm_base = (void *)(UINT64(ctx->map_ccm) + UINT64(CCM_BASE & (ctx->page_size - 1)));
+    ctx->ccm = (void *)(UINT64(ctx->map_ccm) + UINT64(CCM_BASE & (ctx->page_size - 1)));
 
     /* Domain clocks needed all the time */
-    PTR_U32VALUE(VIRT_REG(ccm_base, CCM_CCGR47)) = 0x3;
+    mmio_write(VIRT_REG(ctx->ccm, CCM_CCGR47), CCM_BASE + CCM_CCGR47, 0x3);
     // PTR_U32VALUE(VIRT_REG(ccm_base, CCM_CCGR47)) = 0xC;
-    LOG_REGISTER(VIRT_REG(ccm_base, CCM_CCGR47), REG(CCM_BASE, CCM_CCGR47));
-
-    value = CLK_ROOT_EN | MUX_CLK_ROOT_SELECT(mux) | PRE_PODF(pre) | POST_PODF(post);
+    LOG_REGISTER(VIRT_REG(ctx->ccm, CCM_CCGR47), REG(CCM_BASE, CCM_CCGR47));
 
-    PTR_U32VALUE(VIRT_REG(ccm_base, QSPI_CLK_ROOT)) = value;
-    // PTR_U32VALUE(VIRT_REG(ccm_base, QSPI_CLK_ROOT)) = 0x07000002;
-    PTR_U32VALUE(VIRT_REG(ccm_base, QSPI_CLK_ROOT)) |= CLK_ROOT_EN;
-    LOG_REGISTER(VIRT_REG(ccm_base, QSPI_CLK_ROOT), REG(CCM_BASE, QSPI_CLK_ROOT));
+    clock_set(ctx, mux, pre, post);
 }
 
 void iomux_init(QSPI_Context *ctx)
@@ -152,140 +209,197 @@ void iomux_init(QSPI_Context *ctx)
 
     iomux_base = (void *)(UINT64(ctx->map_iomux) + UINT64(IOMUXC_BASE & (ctx->page_size - 1)));
 
-    PTR_U32VALUE(VIRT_REG(iomux_base, IOMUXC_OFFSET_FLEXSPI_A_SCLK)) = IOMUXC_ALT1 | IOMUXC_SION; // FLEXSPI_A_SCLK
-    PTR_U32VALUE(VIRT_REG(iomux_base, IOMUXC_OFFSET_FLEXSPI_A_SS0_B)) = IOMUXC_ALT1 | IOMUXC_SION; // FLEXSPI_A_SS0_B
-    PTR_U32VALUE(VIRT_REG(iomux_base, IOMUXC_OFFSET_FLEXSPI_A_DATA0)) = IOMUXC_ALT1 | IOMUXC_SION; // FLEXSPI_A_DATA0
-    PTR_U32VALUE(VIRT_REG(iomux_base, IOMUXC_OFFSET_FLEXSPI_A_DATA1)) = IOMUXC_ALT1 | IOMUXC_SION; // FLEXSPI_A_DATA1
-    PTR_U32VALUE(VIRT_REG(iomux_base, IOMUXC_OFFSET_FLEXSPI_A_DATA2)) = IOMUXC_ALT1 | IOMUXC_SION; // FLEXSPI_A_DATA2
-    PTR_U32VALUE(VIRT_REG(iomux_base, IOMUXC_OFFSET_FLEXSPI_A_DATA3)) = IOMUXC_ALT1 | IOMUXC_SION; // FLEXSPI_A_DATA3
+    mmio_write(VIRT_REG(iomux_base, IOMUXC_OFFSET_FLEXSPI_A_SCLK), IOMUXC_BASE + IOMUXC_OFFSET_FLEXSPI_A_SCLK, IOMUXC_ALT1 | IOMUXC_SION); // FLEXSPI_A_SCLK
+    mmio_write(VIRT_REG(iomux_base, IOMUXC_OFFSET_FLEXSPI_A_SS0_B), IOMUXC_BASE + IOMUXC_OFFSET_FLEXSPI_A_SS0_B, IOMUXC_ALT1 | IOMUXC_SION); // FLEXSPI_A_SS0_B
+    mmio_write(VIRT_REG(iomux_base, IOMUXC_OFFSET_FLEXSPI_A_DATA0), IOMUXC_BASE + IOMUXC_OFFSET_FLEXSPI_A_DATA0, IOMUXC_ALT1 | IOMUXC_SION); // FLEXSPI_A_DATA0
+    mmio_write(VIRT_REG(iomux_base, IOMUXC_OFFSET_FLEXSPI_A_DATA1), IOMUXC_BASE + IOMUXC_OFFSET_FLEXSPI_A_DATA1, IOMUXC_ALT1 | IOMUXC_SION); // FLEXSPI_A_DATA1
+    mmio_write(VIRT_REG(iomux_base, IOMUXC_OFFSET_FLEXSPI_A_DATA2), IOMUXC_BASE + IOMUXC_OFFSET_FLEXSPI_A_DATA2, IOMUXC_ALT1 | IOMUXC_SION); // FLEXSPI_A_DATA2
+    mmio_write(VIRT_REG(iomux_base, IOMUXC_OFFSET_FLEXSPI_A_DATA3), IOMUXC_BASE + IOMUXC_OFFSET_FLEXSPI_A_DATA3, IOMUXC_ALT1 | IOMUXC_SION); // FLEXSPI_A_DATA3
+
+}
+
+#define FLEXSPI_IPTXFCR_WTR_MASK  (0x1FC)
+#define FLEXSPI_IPTXFCR_WTR_SHIFT (2U)
+#define FLEXSPI_IPRXFCR_RTR_MASK  (0x1FC)
+#define FLEXSPI_IPRXFCR_RTR_SHIFT (2U)
+#define FSPI_INTR_ERRORS           ((1U << 1) | (1U << 3)) // IPCMDGE | IPCMDERR
+#define FSPI_SIM_INTR_READY        ((1U << 7) | (1U << 6) | (1U << 0)) // IPRXWA | IPTXWE | IPCMDDONE
+#define FLEXSPI_IPRXFSTS_FILL_MASK (0xFFU) // Fill level in 64-bit entries
+#define FLEXSPI_IPTXFSTS_FILL_MASK (0xFFU)
+#define FLEXSPI_IPTXFIFO_ENTRIES   (QSPI_MAX_TRANSFER_SIZE / 8U) // IP TX FIFO size in 64-bit entries
+
+static inline uint64_t wait_done(qspi_wait_site_t site, uint64_t spins, uint64_t start)
+{
+    uint64_t end = cycles_now();
+    if (QSPI_Metrics_Wait(site, spins, end - start))
+    {
+        slogw_limit(5, 1000, "QSPI %s wait stalled for %llu cycles (%llu polls)", QSPI_Metrics_WaitName(site), (unsigned long long)(end - start),
+                    (unsigned long long)spins);
+    }
+    QSPI_Trace_Stall(site, start, end);
+    return end;
+}
 
+/*
+ * INTR is write-1-to-clear, so flags are acknowledged by writing only their
+ * bits: a read-modify-write would also clear every other pending flag, errors
+ * included. The simulated block is plain memory and gets the same semantics,
+ * with its ready flags asserting again right away.
+ */
+static inline void intr_ack(FlexSPI_Type *fspi, uint32_t bits)
+{
+    uint32_t pending = qspi_ctx.simulated ? fspi->INTR : 0U;
+
+    FSPI_WRITE(fspi, INTR, bits);
+    if (qspi_ctx.simulated)
+    {
+        fspi->INTR = (pending & ~bits) | FSPI_SIM_INTR_READY;
+    }
 }
 
+/* Acknowledges every pending INTR flag, errors included, and the status flags */
 static inline void clear_flags(FlexSPI_Type *fspi)
 {
     // slogt("Clearing flags");
-    fspi->INTR = fspi->INTR; // Clear IP command done interrupt
-    fspi->STS0 = fspi->STS0; // Clear status flags
-    fspi->STS1 = fspi->STS1; // Clear status flags
+    intr_ack(fspi, FSPI_READ(fspi, INTR));         // Clear IP command done interrupt
+    FSPI_WRITE(fspi, STS0, FSPI_READ(fspi, STS0)); // Clear status flags
+    FSPI_WRITE(fspi, STS1, FSPI_READ(fspi, STS1)); // Clear status flags
     // slogt("Flags cleared");
 }
-#define FLEXSPI_IPTXFCR_WTR_MASK  (0x1FC)
-#define FLEXSPI_IPTXFCR_WTR_SHIFT (2U)
-#define FLEXSPI_IPRXFCR_RTR_MASK  (0x1FC)
-#define FLEXSPI_IPRXFCR_RTR_SHIFT (2U)
 
-static int write_blocking(FlexSPI_Type *fspi, uint8_t *buffer, size_t size)
+/* Spins until one of the INTR bits in mask is set, accounting the wait against site.
+   Stores the last INTR value in intr, returns cycles_now() at the end. The
+   polls are not recorded one by one, the wait is a single recorder entry. */
+static inline uint64_t wait_intr(FlexSPI_Type *fspi, uint32_t mask, qspi_wait_site_t site, uint32_t *intr)
 {
-    assert(size <= (32 * 32));
-    uint32_t i         = 0, j;
-    uint32_t watermark = ((fspi->IPTXFCR & FLEXSPI_IPTXFCR_WTR_MASK) >> FLEXSPI_IPTXFCR_WTR_SHIFT) + 1;
+    uint64_t spins = 0;
+    uint64_t start = cycles_now();
+    uint32_t first = FSPI_PEEK(fspi, INTR);
+
+    for (*intr = first; 0 == (*intr & mask); *intr = FSPI_PEEK(fspi, INTR))
+    {
+        spins++;
+    }
 
-    // fspi->IPTXFCR |= 1; // Flush TX FIFO
+    FSPI_POLLED(fspi, INTR, first, *intr, spins);
+    return wait_done(site, spins, start);
+}
 
-    // Wait until TX FIFO is empty
-    while (0 != size)
+/* Spins until the IP TX FIFO has room for need entries, returns the free entries in room */
+static inline uint64_t wait_tx_room(FlexSPI_Type *fspi, uint32_t need, uint32_t *room)
+{
+    uint64_t spins = 0;
+    uint64_t start = cycles_now();
+    uint32_t first = FSPI_PEEK(fspi, IPTXFSTS);
+    uint32_t sts   = first;
+
+    for (;;)
     {
-        while (0 == (fspi->INTR & (1 << 6))) // bit6 = IPTXFEMPTY
+        uint32_t fill = sts & FLEXSPI_IPTXFSTS_FILL_MASK;
+        *room         = fill < FLEXSPI_IPTXFIFO_ENTRIES ? FLEXSPI_IPTXFIFO_ENTRIES - fill : 0U;
+        if (*room >= need)
         {
+            break;
         }
-        clear_flags(fspi);
-        // slogt("remining: %d", size);
-        if (size >= 8 * watermark)
-        {
-            for (i = 0U; i < 2U * watermark; i++)
-            {
-                fspi->TFDR[i] = *(uint32_t *)(void *)buffer;
-                buffer += 4U;
-            }
+        spins++;
+        sts = FSPI_PEEK(fspi, IPTXFSTS);
+    }
 
-            size = size - 8U * watermark;
-        }
-        else
+    FSPI_POLLED(fspi, IPTXFSTS, first, sts, spins);
+    return wait_done(QSPI_WAIT_TX_EMPTY, spins, start);
+}
+
+/* Spins until the IP RX FIFO holds at least size bytes, accounted like wait_intr() */
+static inline uint64_t wait_rx_fill(FlexSPI_Type *fspi, size_t size)
+{
+    uint64_t spins = 0;
+    uint64_t start = cycles_now();
+    uint32_t first = FSPI_PEEK(fspi, IPRXFSTS);
+    uint32_t sts;
+
+    for (sts = first; 8U * (sts & FLEXSPI_IPRXFSTS_FILL_MASK) < size; sts = FSPI_PEEK(fspi, IPRXFSTS))
+    {
+        spins++;
+    }
+
+    FSPI_POLLED(fspi, IPRXFSTS, first, sts, spins);
+    return wait_done(QSPI_WAIT_RX_WATERMARK, spins, start);
+}
+
+/* Each IPTXWE push moves one watermark level (8 * watermark bytes) from TFDR
+   into the FIFO. Rather than waiting for the watermark flag after every
+   chunk, the fill level tells how many levels fit and all of them are pushed
+   back to back, so the FIFO is topped up while the bus keeps draining it. */
+static int write_blocking(FlexSPI_Type *fspi, const uint8_t *buffer, size_t size, uint32_t watermark)
+{
+    assert(size <= QSPI_MAX_TRANSFER_SIZE);
+    size_t chunk = 8U * watermark;
+
+    uint64_t t = QSPI_Phase_Now();
+
+    while (0 != size)
+    {
+        uint32_t room;
+        uint64_t ready = wait_tx_room(fspi, watermark, &room);
+        QSPI_Phase_Record(QSPI_PHASE_FIFO_WAIT, ready - t);
+        t = ready;
+
+        do
         {
-            /* Write word aligned data into tx fifo. */
-            for (i = 0U; i < (size / 4U); i++)
-            {
-                fspi->TFDR[i] = *(uint32_t *)(void *)buffer;
-                buffer += 4U;
-            }
-
-            /* Adjust size by the amount processed. */
-            size -= 4U * i;
-
-            /* Write word un-aligned data into tx fifo. */
-            if (0x00U != size)
-            {
-                uint32_t tempVal = 0x00U;
-
-                for (j = 0U; j < size; j++)
-                {
-                    tempVal |= ((uint32_t)*buffer++ << (8U * j));
-                }
-
-                fspi->TFDR[i] = tempVal;
-            }
-
-            size = 0U;
-        }
-        /* Push a watermark level data into IP TX FIFO. */
-        fspi->INTR |= (1 << 6);
+            /* Word aligned data, then an un-aligned tail packed into one word. */
+            size_t n = size < chunk ? size : chunk;
+            buffer   = QSPI_Fifo_Fill(fspi->TFDR, FSPI_PHYS(fspi, TFDR), buffer, n);
+            size -= n;
+            room -= watermark;
+            /* Push a watermark level data into IP TX FIFO. */
+            intr_ack(fspi, 1U << 6);
+        } while (0 != size && room >= watermark);
+
+        t = QSPI_Phase_Mark(QSPI_PHASE_FIFO_COPY, t);
     }
     return 0;
 }
 
-static int read_blocking(FlexSPI_Type *fspi, uint8_t *buffer, size_t size)
+/* The watermark is in 64-bit entries: IPRXWA means 8 * watermark bytes are
+   available and acknowledging it pops that many, so each chunk drains all of
+   them. The tail below the watermark never raises IPRXWA, it is waited for on
+   the fill level instead. Only IPRXWA is acknowledged here, command errors
+   stay pending for the check after IPCMDDONE. */
+static int read_blocking(FlexSPI_Type *fspi, uint8_t *buffer, size_t size, uint32_t watermark)
 {
-    assert(size <= (32 * 32));
-    uint32_t i         = 0, j;
-    uint32_t watermark = ((fspi->IPRXFCR & FLEXSPI_IPRXFCR_RTR_MASK) >> FLEXSPI_IPRXFCR_RTR_SHIFT) + 1;
+    assert(size <= QSPI_MAX_TRANSFER_SIZE);
 
-    fspi->IPRXFCR |= 1; // Flush RX FIFO
+    uint64_t t = QSPI_Phase_Now();
 
-    // Wait until RX FIFO is not empty
     while (0 != size)
     {
-        while (0 == (fspi->INTR & (1 << 7))) // bit7 = IPRXFWMF
+        uint64_t ready;
+        if (size >= 8U * watermark)
+        {
+            uint32_t intr;
+            ready = wait_intr(fspi, 1 << 7, QSPI_WAIT_RX_WATERMARK, &intr); // bit7 = IPRXFWMF
+        }
+        else
         {
+            ready = wait_rx_fill(fspi, size);
         }
-        clear_flags(fspi);
+        QSPI_Phase_Record(QSPI_PHASE_FIFO_WAIT, ready - t);
+        t = ready;
         // slogt("remining: %d", size);
-        if (size >= 4 * watermark)
+        if (size >= 8U * watermark)
         {
-            for (i = 0U; i < watermark; i++)
-            {
-                *(uint32_t *)(void *)buffer = fspi->RFDR[i];
-                buffer += 4U;
-            }
-
-            size = size - 4U * watermark;
+            buffer = QSPI_Fifo_Drain(fspi->RFDR, FSPI_PHYS(fspi, RFDR), buffer, 8U * watermark);
+            size   = size - 8U * watermark;
         }
         else
         {
-            /* Read word aligned data from rx fifo. */
-            for (i = 0U; i < (size / 4U); i++)
-            {
-                *(uint32_t *)(void *)buffer = fspi->RFDR[i];
-                buffer += 4U;
-            }
-
-            /* Adjust size by the amount processed. */
-            size -= 4U * i;
-
-            /* Read word un-aligned data from rx fifo. */
-            if (0x00U != size)
-            {
-                uint32_t tempVal = fspi->RFDR[i];
-
-                for (j = 0U; j < size; j++)
-                {
-                    *buffer++ = (uint8_t)(tempVal >> (8U * j));
-                }
-            }
-
-            size = 0U;
+            /* Word aligned data, then the un-aligned tail from one word. */
+            buffer = QSPI_Fifo_Drain(fspi->RFDR, FSPI_PHYS(fspi, RFDR), buffer, size);
+            size   = 0U;
         }
-        /* Push a watermark level data into IP RX FIFO. */
-        fspi->INTR |= (1 << 7);
+        /* Pop a watermark level data from IP RX FIFO. */
+        intr_ack(fspi, 1U << 7);
+        t = QSPI_Phase_Mark(QSPI_PHASE_FIFO_COPY, t);
     }
     return 0;
 }
@@ -293,15 +407,15 @@ static int read_blocking(FlexSPI_Type *fspi, uint8_t *buffer, size_t size)
 static inline void lock_lut(FlexSPI_Type *fspi)
 {
     // Lock LUT after update
-    fspi->LUTKEY = FSPI_LUTKEY_VALUE;
-    fspi->LUTCR  = FSPI_LOCKER_LOCK;
+    FSPI_WRITE(fspi, LUTKEY, FSPI_LUTKEY_VALUE);
+    FSPI_WRITE(fspi, LUTCR, FSPI_LOCKER_LOCK);
 }
 
 static inline void unlock_lut(FlexSPI_Type *fspi)
 {
     // Unlock LUT for update
-    fspi->LUTKEY = FSPI_LUTKEY_VALUE;
-    fspi->LUTCR  = FSPI_LOCKER_UNLOCK;
+    FSPI_WRITE(fspi, LUTKEY, FSPI_LUTKEY_VALUE);
+    FSPI_WRITE(fspi, LUTCR, FSPI_LOCKER_UNLOCK);
 }
 
 #define INSTR(op, pads, opr) (((op) << 10) | ((pads) << 8) | (opr))
@@ -312,24 +426,43 @@ static inline void unlock_lut(FlexSPI_Type *fspi)
 #define LUT_INDEX_WRITE 4
 #define LUT_INDEX_WREN  8
 
+/* Watermarks for a transfer of size bytes in QSPI_WATERMARK_ADAPTIVE mode */
+static void adaptive_watermarks(size_t size, uint32_t *tx, uint32_t *rx)
+{
+    // One chunk of up to a full FIFO window each way, the fewer waits the better.
+    // A read below the watermark waits once for its fill level and drains in one pass.
+    uint32_t levels = (uint32_t)((size + 7U) / 8U);
+
+    levels = levels < 1U ? 1U : (levels > QSPI_WATERMARK_MAX ? QSPI_WATERMARK_MAX : levels);
+    *tx    = levels;
+    *rx    = levels;
+}
+
 int transfer_blocking(FlexSPI_Type *fspi, flexspi_transfer_t *xfer)
 {
     int result = 0;
 
     uint32_t configValue = 0;
+    uint64_t start       = cycles_now();
 
     /* Clear sequence pointer before sending data to external devices. */
-    fspi->FLSHCR2[xfer->port] |= (1 << 31);
+    FSPI_SET(fspi, FLSHCR2[xfer->port], 1U << 31);
 
     /* Clear former pending status before start this transfer. */
     clear_flags(fspi);
 
     /* Configure fspi address. */
-    fspi->IPCR0 = xfer->deviceAddress;
+    FSPI_WRITE(fspi, IPCR0, xfer->deviceAddress);
 
-    /* Reset fifos. */
-    fspi->IPTXFCR |= 1; // Flush TX FIFO
-    fspi->IPRXFCR |= 1; // Flush RX FIFO
+    /* Reset fifos and set their watermarks, DMA stays off. */
+    uint32_t tx_wm = qspi_ctx.tx_wm;
+    uint32_t rx_wm = qspi_ctx.rx_wm;
+    if (qspi_ctx.wm_adaptive)
+    {
+        adaptive_watermarks(xfer->dataSize, &tx_wm, &rx_wm);
+    }
+    FSPI_WRITE(fspi, IPTXFCR, ((tx_wm - 1U) << FLEXSPI_IPTXFCR_WTR_SHIFT) | 1U); // Flush TX FIFO
+    FSPI_WRITE(fspi, IPRXFCR, ((rx_wm - 1U) << FLEXSPI_IPRXFCR_RTR_SHIFT) | 1U); // Flush RX FIFO
 
     /* Configure data size. */
     if ((xfer->cmdType == kFLEXSPI_Read) || (xfer->cmdType == kFLEXSPI_Write) || (xfer->cmdType == kFLEXSPI_Config))
@@ -340,21 +473,27 @@ int transfer_blocking(FlexSPI_Type *fspi, flexspi_transfer_t *xfer)
 
     /* Configure sequence ID. */
     configValue |= (xfer->seqIndex << 16) | ((xfer->SeqNumber - 1U) << 24);
-    fspi->IPCR1 = configValue;
+    FSPI_WRITE(fspi, IPCR1, configValue);
+    uint64_t t = QSPI_Phase_Mark(QSPI_PHASE_SETUP, start);
 
     /* Start Transfer. */
-    fspi->IPCMD |= 1;
+    FSPI_SET(fspi, IPCMD, 1);
+    if (qspi_ctx.simulated)
+    {
+        fspi->INTR |= qspi_ctx.sim_faults; // Raised by the command, like the hardware does
+    }
+    QSPI_Phase_Mark(QSPI_PHASE_KICK, t);
 
     if ((xfer->cmdType == kFLEXSPI_Write) || (xfer->cmdType == kFLEXSPI_Config))
     {
         // slogt("Writing %d bytes...", xfer->dataSize);
-        result = write_blocking(fspi, (uint8_t *)xfer->data, xfer->dataSize);
+        result = write_blocking(fspi, (const uint8_t *)xfer->data, xfer->dataSize, tx_wm);
         // slogt("Write completed.");
     }
     else if (xfer->cmdType == kFLEXSPI_Read)
     {
         slogt("Reading %d bytes...", xfer->dataSize);
-        result = read_blocking(fspi, (uint8_t *)xfer->data, xfer->dataSize);
+        result = read_blocking(fspi, (uint8_t *)xfer->data, xfer->dataSize, rx_wm);
         slogt("Read completed.");
     }
     else
@@ -369,19 +508,177 @@ int transfer_blocking(FlexSPI_Type *fspi, flexspi_transfer_t *xfer)
     // LOG_REGISTER(&fspi->STS1, FLEXSPI_BASE + offsetof(FlexSPI_Type, STS1));
     // LOG_REGISTER(&fspi->STS2, FLEXSPI_BASE + offsetof(FlexSPI_Type, STS2));
     slogt("Waiting for command completion...");
-    while (0UL == (fspi->INTR & (1 << 0)))
+    t = QSPI_Phase_Now();
+    uint32_t intr;
+    QSPI_Phase_Record(QSPI_PHASE_DONE, wait_intr(fspi, 1 << 0, QSPI_WAIT_CMD_DONE, &intr) - t);
+
+    /* Errors stay pending for QSPI_Busy(), only a clean command acknowledges */
+    if (result == 0 && (intr & FSPI_INTR_ERRORS))
     {
+        slogw_limit(5, 1000, "QSPI command error: seq=%u, INTR=0x%08X", xfer->seqIndex, intr);
+        result = -EIO;
     }
-
-    /* Unless there is an error status already set, capture the latest one */
     if (result == 0)
     {
-        fspi->INTR |= (1 << 6); // Clear IPTXFEMPTY flag
+        intr_ack(fspi, 1U << 6); // Clear IPTXFEMPTY flag
     }
 
+    qspi_ctx.last_seq    = xfer->seqIndex;
+    qspi_ctx.err_counted = result != 0;
+
+    uint64_t end = cycles_now();
+    QSPI_Phase_Record(QSPI_PHASE_TOTAL, end - start);
+    QSPI_Metrics_Record(xfer->seqIndex, xfer->dataSize, result, end - start);
+    QSPI_Trace_Transfer(xfer->seqIndex, xfer->dataSize, result, start, end);
     return result;
 }
 
+static void read_status(FlexSPI_Type *fspi, qspi_status_t *status)
+{
+    status->cycles     = cycles_now();
+    status->intr       = FSPI_READ(fspi, INTR);
+    status->sts0       = FSPI_READ(fspi, STS0);
+    status->sts1       = FSPI_READ(fspi, STS1);
+    status->sts2       = FSPI_READ(fspi, STS2);
+    status->ahbspndsts = FSPI_READ(fspi, AHBSPNDSTS);
+    status->iprxfsts   = FSPI_READ(fspi, IPRXFSTS);
+    status->iptxfsts   = FSPI_READ(fspi, IPTXFSTS);
+}
+
+void QSPI_Status_Log(const qspi_status_t *cur, const qspi_status_t *prev, uint32_t changed, void *ctx)
+{
+    (void)ctx;
+
+    static const struct
+    {
+        const char *name;
+        size_t      offset;
+    } fields[] = {
+        {"INTR", offsetof(qspi_status_t, intr)},
+        {"STS0", offsetof(qspi_status_t, sts0)},
+        {"STS1", offsetof(qspi_status_t, sts1)},
+        {"STS2", offsetof(qspi_status_t, sts2)},
+        {"AHBSPNDSTS", offsetof(qspi_status_t, ahbspndsts)},
+        {"IPRXFSTS", offsetof(qspi_status_t, iprxfsts)},
+        {"IPTXFSTS", offsetof(qspi_status_t, iptxfsts)},
+    };
+
+    for (size_t i = 0; i < lengthof(fields); i++)
+    {
+        if (changed & (1U << i))
+        {
+            uint32_t was = *(const uint32_t *)(const void *)((const uint8_t *)prev + fields[i].offset);
+            uint32_t now = *(const uint32_t *)(const void *)((const uint8_t *)cur + fields[i].offset);
+            slogt("%s: 0x%08X -> 0x%08X", fields[i].name, was, now);
+        }
+    }
+}
+
+/* Captures the status block for the subscribers, nothing is read when there are none */
+static void publish_status(FlexSPI_Type *fspi)
+{
+    if (atomic_load_explicit(&qspi_status.count, memory_order_relaxed) == 0)
+    {
+        return;
+    }
+
+    qspi_status_t    cur;
+    qspi_status_cb_t cb[QSPI_STATUS_SUBSCRIBERS_MAX];
+    void            *ctx[QSPI_STATUS_SUBSCRIBERS_MAX];
+    read_status(fspi, &cur);
+
+    pthread_mutex_lock(&qspi_status.lock);
+    qspi_status_t prev    = qspi_status.prev;
+    uint32_t      changed = QSPI_Status_Diff(&prev, &cur);
+    qspi_status.prev      = cur;
+    memcpy(cb, qspi_status.cb, sizeof(cb));
+    memcpy(ctx, qspi_status.ctx, sizeof(ctx));
+    pthread_mutex_unlock(&qspi_status.lock);
+
+    // Called on the copy without the lock, so a callback may subscribe or unsubscribe
+    for (int i = 0; i < QSPI_STATUS_SUBSCRIBERS_MAX; i++)
+    {
+        if (cb[i] != NULL)
+        {
+            cb[i](&cur, &prev, changed, ctx[i]);
+        }
+    }
+}
+
+int QSPI_Status_Subscribe(qspi_status_cb_t cb, void *ctx)
+{
+    assert(cb != NULL);
+
+    int ret = -ENOSPC;
+    pthread_mutex_lock(&qspi_status.lock);
+    for (int i = 0; i < QSPI_STATUS_SUBSCRIBERS_MAX; i++)
+    {
+        if (qspi_status.cb[i] == NULL)
+        {
+            qspi_status.cb[i]  = cb;
+            qspi_status.ctx[i] = ctx;
+            atomic_fetch_add(&qspi_status.count, 1);
+            ret = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&qspi_status.lock);
+
+    return ret;
+}
+
+void QSPI_Status_Unsubscribe(qspi_status_cb_t cb, void *ctx)
+{
+    pthread_mutex_lock(&qspi_status.lock);
+    for (int i = 0; i < QSPI_STATUS_SUBSCRIBERS_MAX; i++)
+    {
+        if (qspi_status.cb[i] == cb && qspi_status.ctx[i] == ctx)
+        {
+            qspi_status.cb[i]  = NULL;
+            qspi_status.ctx[i] = NULL;
+            atomic_fetch_sub(&qspi_status.count, 1);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&qspi_status.lock);
+}
+
+void QSPI_Status_Read(qspi_status_t *status)
+{
+    assert(status != NULL);
+    assert(qspi_ctx.flexspi != NULL);
+
+    read_status(qspi_ctx.flexspi, status);
+}
+
+uint32_t QSPI_Status_Diff(const qspi_status_t *a, const qspi_status_t *b)
+{
+    assert(a != NULL && b != NULL);
+
+    uint32_t changed = 0;
+    changed |= a->intr != b->intr ? QSPI_STATUS_INTR : 0;
+    changed |= a->sts0 != b->sts0 ? QSPI_STATUS_STS0 : 0;
+    changed |= a->sts1 != b->sts1 ? QSPI_STATUS_STS1 : 0;
+    changed |= a->sts2 != b->sts2 ? QSPI_STATUS_STS2 : 0;
+    changed |= a->ahbspndsts != b->ahbspndsts ? QSPI_STATUS_AHBSPNDSTS : 0;
+    changed |= a->iprxfsts != b->iprxfsts ? QSPI_STATUS_IPRXFSTS : 0;
+    changed |= a->iptxfsts != b->iptxfsts ? QSPI_STATUS_IPTXFSTS : 0;
+    return changed;
+}
+
+/* Watermark in entries from a boot-time WTR/RTR field, which can encode up to
+   128 entries: more than the TFDR/RFDR window the FIFO code moves per level */
+static uint32_t boot_watermark(const char *fifo, uint32_t field)
+{
+    uint32_t wm = field + 1U;
+    if (wm > QSPI_WATERMARK_MAX)
+    {
+        slogw("QSPI: boot %s watermark of %u entries clamped to %u", fifo, wm, QSPI_WATERMARK_MAX);
+        wm = QSPI_WATERMARK_MAX;
+    }
+    return wm;
+}
+
 void QSPI_Init()
 {
     struct sigaction sa;
@@ -389,6 +686,7 @@ void QSPI_Init()
     sa.sa_sigaction = segfault_sigaction;
     sa.sa_flags     = SA_SIGINFO;
     sigaction(SIGSEGV, &sa, NULL);
+    sigaction(SIGBUS, &sa, NULL);
 
     qspi_ctx.fd        = -1;
     qspi_ctx.page_size = sysconf(_SC_PAGE_SIZE);
@@ -421,15 +719,51 @@ void QSPI_Init()
     iomux_init(&qspi_ctx);
     slogt("IOMUX initialized.");
 
-    qspi_ctx.flexspi->MCR0 |= FSPI_MCR0_MDIS; // Disable FlexSPI
+    QSPI_Metrics_SetStallThreshold(QSPI_WAIT_STALL_NS);
+
+    FSPI_SET(qspi_ctx.flexspi, MCR0, FSPI_MCR0_MDIS); // Disable FlexSPI
     clock_init(&qspi_ctx, clk_mux, pre_div, post_div);
 
-    qspi_ctx.flexspi->MCR0 |= (1 << 1);            // Disable FlexSPI
-    qspi_ctx.flexspi->INTEN = (1 << 6) | (1 << 0); // Enable IPTX FIFO empty interrupt
+    FSPI_SET(qspi_ctx.flexspi, MCR0, 1 << 1);                   // Disable FlexSPI
+    FSPI_WRITE(qspi_ctx.flexspi, INTEN, (1 << 6) | (1 << 0)); // Enable IPTX FIFO empty interrupt
     // qspi_ctx.flexspi->MCR0 |= FSPI_MCR0_SWRST;     // Software reset
     // setup_lut(qspi_ctx.flexspi);
-    qspi_ctx.flexspi->MCR0 &= ~FSPI_MCR0_MDIS; // Enable FlexSPI
+    FSPI_CLEAR(qspi_ctx.flexspi, MCR0, FSPI_MCR0_MDIS); // Enable FlexSPI
+
+    // Keep whatever the boot stage left, the transfers program them from here on
+    qspi_ctx.tx_wm       = boot_watermark("TX", (FSPI_READ(qspi_ctx.flexspi, IPTXFCR) & FLEXSPI_IPTXFCR_WTR_MASK) >> FLEXSPI_IPTXFCR_WTR_SHIFT);
+    qspi_ctx.rx_wm       = boot_watermark("RX", (FSPI_READ(qspi_ctx.flexspi, IPRXFCR) & FLEXSPI_IPRXFCR_RTR_MASK) >> FLEXSPI_IPRXFCR_RTR_SHIFT);
+    qspi_ctx.wm_adaptive = 0;
+    qspi_ctx.init_done   = 1;
+}
+
+FlexSPI_Type *QSPI_InitSimulated(void)
+{
+    memset(&qspi_sim_regs, 0, sizeof(qspi_sim_regs));
+    // Acknowledging never clears these (intr_ack()), so every wait loop falls through
+    qspi_sim_regs.INTR     = FSPI_SIM_INTR_READY;
+    qspi_sim_regs.IPRXFSTS = 16;                              // RX FIFO fill level, a full RFDR window
+    // IPTXFSTS stays 0, the TX FIFO always looks empty
+
+    memset(&qspi_ctx, 0, sizeof(qspi_ctx));
+    qspi_ctx.fd        = -1;
+    qspi_ctx.flexspi   = &qspi_sim_regs;
+    qspi_ctx.simulated = 1;
+    qspi_ctx.clk_mux   = clk_mux;
+    qspi_ctx.pre_div   = pre_div;
+    qspi_ctx.post_div  = post_div;
+    qspi_ctx.tx_wm     = 1;
+    qspi_ctx.rx_wm     = 1;
     qspi_ctx.init_done = 1;
+
+    slogt("QSPI attached to simulated registers");
+    return &qspi_sim_regs;
+}
+
+void QSPI_SimulateFault(uint32_t intr)
+{
+    assert(qspi_ctx.simulated);
+    qspi_ctx.sim_faults = intr & FSPI_INTR_ERRORS;
 }
 
 void QSPI_SetupLut(uint32_t *lut, size_t len)
@@ -442,7 +776,10 @@ void QSPI_SetupLut(uint32_t *lut, size_t len)
     slogi("Setting up LUT...");
 
     unlock_lut(fspi);
-    memcpy(&fspi->LUT[0], lut, len);
+    for (size_t i = 0; i < len / sizeof(uint32_t); i++)
+    {
+        FSPI_WRITE(fspi, LUT[i], lut[i]);
+    }
     lock_lut(fspi);
 
     slogi("LUT setup completed.");
@@ -453,24 +790,109 @@ int QSPI_IsInitialized()
     return qspi_ctx.init_done;
 }
 
+int QSPI_SetClock(uint32_t mux, uint32_t pre, uint32_t post)
+{
+    if (mux > CLK_MUX_MAX || pre > PRE_DIV_MAX || post > POST_DIV_MAX)
+    {
+        return -EINVAL;
+    }
+    if (!qspi_ctx.init_done)
+    {
+        return -ENODEV;
+    }
+
+    slogi("QSPI clock: mux=%u, pre_div=%u, post_div=%u", mux, pre, post);
+
+    if (qspi_ctx.simulated)
+    {
+        // No CCM behind the simulated block, only the settings are kept
+        qspi_ctx.clk_mux  = mux;
+        qspi_ctx.pre_div  = pre;
+        qspi_ctx.post_div = post;
+        return 0;
+    }
+    if (qspi_ctx.ccm == NULL)
+    {
+        return -EIO;
+    }
+
+    // The root clock must not change under a running controller
+    FSPI_SET(qspi_ctx.flexspi, MCR0, FSPI_MCR0_MDIS);
+    clock_set(&qspi_ctx, mux, pre, post);
+    FSPI_CLEAR(qspi_ctx.flexspi, MCR0, FSPI_MCR0_MDIS);
+    return 0;
+}
+
+void QSPI_GetClock(uint32_t *mux, uint32_t *pre, uint32_t *post)
+{
+    assert(mux != NULL && pre != NULL && post != NULL);
+
+    *mux  = qspi_ctx.clk_mux;
+    *pre  = qspi_ctx.pre_div;
+    *post = qspi_ctx.post_div;
+}
+
+int QSPI_SetWatermarks(uint32_t tx, uint32_t rx)
+{
+    if (tx < 1 || tx > QSPI_WATERMARK_MAX || rx < 1 || rx > QSPI_WATERMARK_MAX)
+    {
+        return -EINVAL;
+    }
+    if (!qspi_ctx.init_done)
+    {
+        return -ENODEV;
+    }
+
+    qspi_ctx.tx_wm       = tx;
+    qspi_ctx.rx_wm       = rx;
+    qspi_ctx.wm_adaptive = 0;
+
+    FlexSPI_Type *fspi = qspi_ctx.flexspi;
+    FSPI_WRITE(fspi, IPTXFCR, (FSPI_READ(fspi, IPTXFCR) & ~FLEXSPI_IPTXFCR_WTR_MASK) | ((tx - 1) << FLEXSPI_IPTXFCR_WTR_SHIFT));
+    FSPI_WRITE(fspi, IPRXFCR, (FSPI_READ(fspi, IPRXFCR) & ~FLEXSPI_IPRXFCR_RTR_MASK) | ((rx - 1) << FLEXSPI_IPRXFCR_RTR_SHIFT));
+    return 0;
+}
+
+void QSPI_GetWatermarks(uint32_t *tx, uint32_t *rx)
+{
+    assert(tx != NULL && rx != NULL);
+
+    *tx = qspi_ctx.tx_wm;
+    *rx = qspi_ctx.rx_wm;
+}
+
+void QSPI_SetWatermarkMode(qspi_watermark_mode_t mode)
+{
+    assert(mode == QSPI_WATERMARK_FIXED || mode == QSPI_WATERMARK_ADAPTIVE);
+    qspi_ctx.wm_adaptive = mode == QSPI_WATERMARK_ADAPTIVE;
+}
+
+qspi_watermark_mode_t QSPI_GetWatermarkMode(void)
+{
+    return qspi_ctx.wm_adaptive ? QSPI_WATERMARK_ADAPTIVE : QSPI_WATERMARK_FIXED;
+}
+
 int QSPI_Busy(void)
 {
     slogi("QSPI_Busy check");
     if (!qspi_ctx.init_done)
     {
-        slogf("QSPI is not initialized");
+        slogf_limit(5, 1000, "QSPI is not initialized");
         return 1;
     }
 
-    LOG_REGISTER(&qspi_ctx.flexspi->INTR, FLEXSPI_BASE + offsetof(FlexSPI_Type, INTR));
-    LOG_REGISTER(&qspi_ctx.flexspi->STS0, FLEXSPI_BASE + offsetof(FlexSPI_Type, STS0));
-    LOG_REGISTER(&qspi_ctx.flexspi->STS1, FLEXSPI_BASE + offsetof(FlexSPI_Type, STS1));
-    LOG_REGISTER(&qspi_ctx.flexspi->STS2, FLEXSPI_BASE + offsetof(FlexSPI_Type, STS2));
-    uint32_t intr = qspi_ctx.flexspi->INTR;
+    publish_status(qspi_ctx.flexspi);
+    uint32_t intr = FSPI_READ(qspi_ctx.flexspi, INTR);
 
     if (intr & (1 << 3))
     {
-        slogf("QSPI error: IP RX FIFO underflow");
+        // A failed transfer counted it already, an error raised after a clean one is counted once here
+        if (!qspi_ctx.err_counted)
+        {
+            QSPI_Metrics_Error(qspi_ctx.last_seq);
+            qspi_ctx.err_counted = 1;
+        }
+        slogf_limit(5, 1000, "QSPI error: IP RX FIFO underflow");
         return -1;
     }
 
@@ -491,10 +913,23 @@ void QSPI_DeInit()
         return;
     }
 
+    if (qspi_ctx.simulated)
+    {
+        memset(&qspi_ctx, 0, sizeof(qspi_ctx));
+        qspi_ctx.fd = -1;
+        slogt("QSPI detached from simulated registers");
+        return;
+    }
+
     // Unmap FlexSPI registers
     munmap(qspi_ctx.map_iomux, PAGE_SIZE_64K);
     munmap(qspi_ctx.map_fspi, sizeof(FlexSPI_Type));
-    munmap(qspi_ctx.map_ccm, PAGE_SIZE_64K);
+    if (qspi_ctx.map_ccm != NULL)
+    {
+        munmap(qspi_ctx.map_ccm, PAGE_SIZE_64K);
+    }
+    qspi_ctx.map_ccm = NULL;
+    qspi_ctx.ccm     = NULL;
     munmap(qspi_ctx.map_rdc, PAGE_SIZE_64K);
     close(qspi_ctx.fd);
     qspi_ctx.fd        = -1;
@@ -520,9 +955,7 @@ int QSPI_Write(uint32_t addr, uint8_t lut_index, uint8_t *buffer, size_t size)
 
     int ret = transfer_blocking(qspi_ctx.flexspi, &xfer);
 
-    LOG_REGISTER(&qspi_ctx.flexspi->STS0, FLEXSPI_BASE + offsetof(FlexSPI_Type, STS0));
-    LOG_REGISTER(&qspi_ctx.flexspi->STS1, FLEXSPI_BASE + offsetof(FlexSPI_Type, STS1));
-    LOG_REGISTER(&qspi_ctx.flexspi->INTR, FLEXSPI_BASE + offsetof(FlexSPI_Type, INTR));
+    publish_status(qspi_ctx.flexspi);
 
     return ret;
 }
@@ -544,9 +977,7 @@ int QSPI_Read(uint32_t addr, uint8_t *buffer, size_t size)
 
     int ret = transfer_blocking(qspi_ctx.flexspi, &xfer);
 
-    LOG_REGISTER(&qspi_ctx.flexspi->STS0, FLEXSPI_BASE + offsetof(FlexSPI_Type, STS0));
-    LOG_REGISTER(&qspi_ctx.flexspi->STS1, FLEXSPI_BASE + offsetof(FlexSPI_Type, STS1));
-    LOG_REGISTER(&qspi_ctx.flexspi->INTR, FLEXSPI_BASE + offsetof(FlexSPI_Type, INTR));
+    publish_status(qspi_ctx.flexspi);
 
     return ret;
 }
@@ -568,9 +999,21 @@ int QSPI_ReadSample(uint32_t addr, void *sample, size_t size)
 
     int ret = transfer_blocking(qspi_ctx.flexspi, &xfer);
 
-    LOG_REGISTER(&qspi_ctx.flexspi->STS0, FLEXSPI_BASE + offsetof(FlexSPI_Type, STS0));
-    LOG_REGISTER(&qspi_ctx.flexspi->STS1, FLEXSPI_BASE + offsetof(FlexSPI_Type, STS1));
-    LOG_REGISTER(&qspi_ctx.flexspi->INTR, FLEXSPI_BASE + offsetof(FlexSPI_Type, INTR));
+    publish_status(qspi_ctx.flexspi);
+
+    return ret;
+}
+
+int QSPI_Transfer(flexspi_transfer_t *xfer)
+{
+    assert(xfer != NULL);
+    assert(xfer->dataSize <= QSPI_MAX_TRANSFER_SIZE);
+
+    slogi("QSPI_Transfer: addr=0x%08X, seq=%u, size=%u", xfer->deviceAddress, xfer->seqIndex, xfer->dataSize);
+
+    int ret = transfer_blocking(qspi_ctx.flexspi, xfer);
+
+    publish_status(qspi_ctx.flexspi);
 
     return ret;
 }
@@ -4,11 +4,36 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "flexspi.h"
+
+/* Largest payload a single IP command moves through the IP FIFOs. */
+#define QSPI_MAX_TRANSFER_SIZE (32 * 32)
+
 /**
  * @brief Initializes the QSPI (Quad SPI) interface.
  */
 void QSPI_Init();
 
+/**
+ * @brief Attaches the driver to an in-memory FlexSPI register block instead of /dev/mem.
+ *
+ * The status flags polled by the driver are preset, so every transfer completes
+ * immediately. Used by the unit tests and benchmarks on hosts without the FPGA.
+ *
+ * @return The simulated register block, to preload RX data or inspect TX data.
+ */
+FlexSPI_Type *QSPI_InitSimulated(void);
+
+/**
+ * @brief Makes every following command on the simulated block raise INTR error bits.
+ *
+ * The bits are set when the command starts, so they go through the same
+ * acknowledge paths as a failing command on the hardware.
+ *
+ * @param intr IPCMDGE (bit 1) and/or IPCMDERR (bit 3), 0 to stop failing.
+ */
+void QSPI_SimulateFault(uint32_t intr);
+
 /**
  * @brief Checks if the QSPI interface is initialized.
  *
@@ -23,6 +48,55 @@ void QSPI_DeInit();
 
 int QSPI_Busy(void);
 
+/* Largest IP FIFO watermark in 64-bit entries, a TX watermark fills the whole TFDR window */
+#define QSPI_WATERMARK_MAX 16
+
+/**
+ * @brief Reprograms the FlexSPI root clock (QSPI_CLK_ROOT in the CCM).
+ *
+ * The controller is disabled while the clock changes. QSPI_Init() sets
+ * mux 2, pre 0, post 7. The simulated backend only keeps the values.
+ *
+ * @param mux  Root clock source select, 0-7.
+ * @param pre  Pre-divider minus one, 0-7.
+ * @param post Post-divider minus one, 0-63.
+ *
+ * @return 0 on success, -EINVAL, -ENODEV when not initialized, -EIO without the CCM mapping.
+ */
+int QSPI_SetClock(uint32_t mux, uint32_t pre, uint32_t post);
+
+void QSPI_GetClock(uint32_t *mux, uint32_t *pre, uint32_t *post);
+
+typedef enum
+{
+    QSPI_WATERMARK_FIXED = 0, // The QSPI_SetWatermarks() levels for every command
+    QSPI_WATERMARK_ADAPTIVE,  // Picked per command from its size
+} qspi_watermark_mode_t;
+
+/**
+ * @brief Sets the IP TX and RX FIFO watermarks, in 64-bit entries (1-QSPI_WATERMARK_MAX).
+ *
+ * Selects QSPI_WATERMARK_FIXED. The levels are programmed with every command.
+ *
+ * @return 0 on success, -EINVAL, or -ENODEV when not initialized.
+ */
+int QSPI_SetWatermarks(uint32_t tx, uint32_t rx);
+/**
+ * @brief Levels of QSPI_WATERMARK_FIXED, in 64-bit entries.
+ */
+void QSPI_GetWatermarks(uint32_t *tx, uint32_t *rx);
+
+/**
+ * @brief Selects how the watermarks of each command are chosen.
+ *
+ * QSPI_WATERMARK_ADAPTIVE sizes both watermarks to the transfer, up to
+ * QSPI_WATERMARK_MAX: a write fills in as few chunks as the TX window allows
+ * and a read up to 128 bytes (e.g. a sample) is drained in one pass.
+ */
+void QSPI_SetWatermarkMode(qspi_watermark_mode_t mode);
+
+qspi_watermark_mode_t QSPI_GetWatermarkMode(void);
+
 void QSPI_SetupLut(uint32_t *lut, size_t len);
 
 int QSPI_Write(uint32_t addr, uint8_t lut_index,  uint8_t *buffer, size_t size);
@@ -31,4 +105,73 @@ int QSPI_Read(uint32_t addr, uint8_t *buffer, size_t size);
 
 int QSPI_ReadSample(uint32_t addr, void *sample, size_t size);
 
+/* FlexSPI status block, captured in one pass after each transfer */
+typedef struct
+{
+    uint32_t intr;
+    uint32_t sts0;
+    uint32_t sts1;
+    uint32_t sts2;
+    uint32_t ahbspndsts;
+    uint32_t iprxfsts;
+    uint32_t iptxfsts;
+    uint64_t cycles; // cycles_now() when captured
+} qspi_status_t;
+
+/* Bits returned by QSPI_Status_Diff() */
+typedef enum
+{
+    QSPI_STATUS_INTR       = (1 << 0),
+    QSPI_STATUS_STS0       = (1 << 1),
+    QSPI_STATUS_STS1       = (1 << 2),
+    QSPI_STATUS_STS2       = (1 << 3),
+    QSPI_STATUS_AHBSPNDSTS = (1 << 4),
+    QSPI_STATUS_IPRXFSTS   = (1 << 5),
+    QSPI_STATUS_IPTXFSTS   = (1 << 6),
+} qspi_status_field_t;
+
+#define QSPI_STATUS_SUBSCRIBERS_MAX 4
+
+/* cur is the new snapshot, prev the one before it, changed a QSPI_Status_Diff() mask */
+typedef void (*qspi_status_cb_t)(const qspi_status_t *cur, const qspi_status_t *prev, uint32_t changed, void *ctx);
+
+/**
+ * @brief Registers a consumer of the status snapshots.
+ *
+ * The status block is only read after transfers while a consumer is
+ * registered. The callback runs on the transferring thread without the
+ * subscriber lock held, so it may subscribe or unsubscribe. A callback can
+ * still run once for a transfer that finished on another thread while
+ * QSPI_Status_Unsubscribe() was called, keep ctx valid until transfers stop.
+ *
+ * @return 0 on success, -ENOSPC when QSPI_STATUS_SUBSCRIBERS_MAX are registered.
+ */
+int QSPI_Status_Subscribe(qspi_status_cb_t cb, void *ctx);
+
+void QSPI_Status_Unsubscribe(qspi_status_cb_t cb, void *ctx);
+
+/**
+ * @brief Subscriber that logs each changed register at trace level, ctx is unused.
+ */
+void QSPI_Status_Log(const qspi_status_t *cur, const qspi_status_t *prev, uint32_t changed, void *ctx);
+
+/**
+ * @brief Reads the status block now, regardless of subscribers.
+ */
+void QSPI_Status_Read(qspi_status_t *status);
+
+/**
+ * @brief Compares two snapshots.
+ *
+ * @return Mask of the qspi_status_field_t that differ.
+ */
+uint32_t QSPI_Status_Diff(const qspi_status_t *a, const qspi_status_t *b);
+
+/**
+ * @brief Executes a caller-described IP command (any LUT sequence, read or write).
+ *
+ * @return 0 on success, -EIO when the command raised IPCMDGE or IPCMDERR.
+ */
+int QSPI_Transfer(flexspi_transfer_t *xfer);
+
 #endif // QSPI_H
@@ -0,0 +1,145 @@
+#include "qspi_coalesce.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#include "qspi.h"
+
+#include "slog.h"
+
+typedef struct
+{
+    pthread_mutex_t        lock;
+    qspi_coalesce_config_t cfg;
+    uint8_t                mode[FPGA_OPCODE_IDX_COUNT];
+
+    int                 pending;
+    fpga_opcode_index_t op;
+    uint32_t            addr;
+    uint64_t            since_us;
+    size_t              size;
+    uint32_t            data[QSPI_MAX_TRANSFER_SIZE / sizeof(uint32_t)];
+} qspi_coalesce_t;
+
+static qspi_coalesce_t coalesce = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cfg  = {.window_us = 1000, .max_bytes = QSPI_MAX_TRANSFER_SIZE},
+    .mode = {[FPGA_LUT_IDX_WR_DCU_OUT] = QSPI_COALESCE_LAST_WINS},
+};
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000U + (uint64_t)ts.tv_nsec / 1000U;
+}
+
+static int flush_locked(qspi_coalesce_t *c)
+{
+    if (!c->pending)
+    {
+        return 0;
+    }
+
+    c->pending = 0;
+    slogt("Coalesced write: op=%d, addr=0x%08X, size=%zu", c->op, c->addr, c->size);
+    return QSPI_Write(c->addr, (uint8_t)c->op, (uint8_t *)c->data, c->size);
+}
+
+static int expired(const qspi_coalesce_t *c, uint64_t now)
+{
+    return c->pending && (now - c->since_us) >= c->cfg.window_us;
+}
+
+void QSPI_Coalesce_Config(const qspi_coalesce_config_t *cfg)
+{
+    assert(cfg != NULL);
+    assert(cfg->max_bytes > 0 && cfg->max_bytes <= QSPI_MAX_TRANSFER_SIZE);
+
+    pthread_mutex_lock(&coalesce.lock);
+    coalesce.cfg = *cfg;
+    pthread_mutex_unlock(&coalesce.lock);
+}
+
+void QSPI_Coalesce_SetMode(fpga_opcode_index_t op, qspi_coalesce_mode_t mode)
+{
+    assert(op < FPGA_OPCODE_IDX_COUNT);
+
+    pthread_mutex_lock(&coalesce.lock);
+    coalesce.mode[op] = (uint8_t)mode;
+    pthread_mutex_unlock(&coalesce.lock);
+}
+
+int QSPI_Coalesce_Write(fpga_opcode_index_t op, uint32_t addr, const uint8_t *buffer, size_t size)
+{
+    assert(op < FPGA_OPCODE_IDX_COUNT);
+    assert(buffer != NULL || size == 0);
+    assert(size <= QSPI_MAX_TRANSFER_SIZE);
+
+    qspi_coalesce_t *c   = &coalesce;
+    int              ret = 0;
+    uint64_t         now = now_us();
+
+    pthread_mutex_lock(&c->lock);
+
+    int last_wins = c->mode[op] == QSPI_COALESCE_LAST_WINS;
+
+    if (c->pending && (c->op != op || c->addr != addr || expired(c, now) || (!last_wins && c->size + size > c->cfg.max_bytes)))
+    {
+        ret = flush_locked(c);
+    }
+
+    if (!c->pending)
+    {
+        c->pending  = 1;
+        c->op       = op;
+        c->addr     = addr;
+        c->since_us = now;
+        c->size     = 0;
+    }
+
+    if (last_wins)
+    {
+        c->size = 0;
+    }
+    if (size > 0)
+    {
+        memcpy((uint8_t *)c->data + c->size, buffer, size);
+        c->size += size;
+    }
+
+    if (c->cfg.window_us == 0 || c->size >= c->cfg.max_bytes)
+    {
+        int err = flush_locked(c);
+        ret     = ret ? ret : err;
+    }
+
+    pthread_mutex_unlock(&c->lock);
+    return ret;
+}
+
+int QSPI_Coalesce_Poll(void)
+{
+    int      ret = 0;
+    uint64_t now = now_us();
+
+    pthread_mutex_lock(&coalesce.lock);
+    if (expired(&coalesce, now))
+    {
+        ret = flush_locked(&coalesce);
+    }
+    pthread_mutex_unlock(&coalesce.lock);
+
+    return ret;
+}
+
+int QSPI_Coalesce_Flush(void)
+{
+    pthread_mutex_lock(&coalesce.lock);
+    int ret = flush_locked(&coalesce);
+    pthread_mutex_unlock(&coalesce.lock);
+
+    return ret;
+}
@@ -0,0 +1,48 @@
+#ifndef QSPI_COALESCE_H
+#define QSPI_COALESCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fpga_interface.h"
+
+/*
+ * Write coalescing for small control writes (WR_DCU_OUT, WR_GENERIC_CMD, ...).
+ *
+ * Consecutive writes to the same opcode and address are held back and sent as
+ * one IP command once the window expires, the payload reaches max_bytes, or a
+ * write to another opcode/address arrives. Register-like targets use
+ * QSPI_COALESCE_LAST_WINS, where a newer write replaces the pending one.
+ */
+
+typedef enum
+{
+    QSPI_COALESCE_APPEND = 0, // Pending payloads are concatenated
+    QSPI_COALESCE_LAST_WINS,  // Only the most recent payload is sent
+} qspi_coalesce_mode_t;
+
+typedef struct
+{
+    uint32_t window_us; // Longest time a write may stay pending, 0 disables coalescing
+    size_t   max_bytes; // Flush once the pending payload reaches this size
+} qspi_coalesce_config_t;
+
+void QSPI_Coalesce_Config(const qspi_coalesce_config_t *cfg);
+
+void QSPI_Coalesce_SetMode(fpga_opcode_index_t op, qspi_coalesce_mode_t mode);
+
+/**
+ * @brief Queues a write, flushing the pending one first if it cannot be merged.
+ *
+ * @return 0 on success, the QSPI_Write() result of a failed flush otherwise.
+ */
+int QSPI_Coalesce_Write(fpga_opcode_index_t op, uint32_t addr, const uint8_t *buffer, size_t size);
+
+/**
+ * @brief Flushes the pending write if its window has expired. Call from the control loop.
+ */
+int QSPI_Coalesce_Poll(void);
+
+int QSPI_Coalesce_Flush(void);
+
+#endif // QSPI_COALESCE_H
@@ -0,0 +1,96 @@
+#ifndef QSPI_FIFO_H
+#define QSPI_FIFO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "qspi_recorder.h"
+
+/*
+ * Register accessors and the IP FIFO copy loops of the driver.
+ *
+ * They live here rather than in qspi.c so bench/bench_fifo.c can run the
+ * exact loops against a fake FIFO. Every access goes through the recorder,
+ * poll loops read with mmio_peek() and record the whole loop once.
+ */
+
+static inline uint32_t mmio_read(const volatile uint32_t *reg, uint32_t phys)
+{
+    uint32_t value = *reg;
+    QSPI_Recorder_Record(QSPI_RECORDER_READ, phys, value);
+    return value;
+}
+
+/* Unrecorded read for poll loops, which end with QSPI_Recorder_Poll() */
+static inline uint32_t mmio_peek(const volatile uint32_t *reg)
+{
+    return *reg;
+}
+
+static inline void mmio_write(volatile uint32_t *reg, uint32_t phys, uint32_t value)
+{
+    *reg = value;
+    QSPI_Recorder_Record(QSPI_RECORDER_WRITE, phys, value);
+}
+
+/*
+ * Copies size bytes into the TX FIFO window at fifo (physical address phys):
+ * whole words first, then the remaining bytes packed little-endian into one
+ * last word. Returns the buffer position after the copied bytes.
+ */
+static inline const uint8_t *QSPI_Fifo_Fill(volatile uint32_t *fifo, uint32_t phys, const uint8_t *buffer, size_t size)
+{
+    size_t i;
+
+    for (i = 0U; i < size / 4U; i++)
+    {
+        mmio_write(&fifo[i], phys + 4U * (uint32_t)i, *(const uint32_t *)(const void *)buffer);
+        buffer += 4U;
+    }
+
+    size -= 4U * i;
+    if (0x00U != size)
+    {
+        uint32_t tempVal = 0x00U;
+
+        for (size_t j = 0U; j < size; j++)
+        {
+            tempVal |= ((uint32_t)*buffer++ << (8U * j));
+        }
+
+        mmio_write(&fifo[i], phys + 4U * (uint32_t)i, tempVal);
+    }
+
+    return buffer;
+}
+
+/*
+ * Copies size bytes out of the RX FIFO window at fifo (physical address phys),
+ * the counterpart of QSPI_Fifo_Fill(). Returns the buffer position after the
+ * copied bytes.
+ */
+static inline uint8_t *QSPI_Fifo_Drain(const volatile uint32_t *fifo, uint32_t phys, uint8_t *buffer, size_t size)
+{
+    size_t i;
+
+    for (i = 0U; i < size / 4U; i++)
+    {
+        *(uint32_t *)(void *)buffer = mmio_read(&fifo[i], phys + 4U * (uint32_t)i);
+        buffer += 4U;
+    }
+
+    size -= 4U * i;
+    if (0x00U != size)
+    {
+        uint32_t tempVal = mmio_read(&fifo[i], phys + 4U * (uint32_t)i);
+
+        for (size_t j = 0U; j < size; j++)
+        {
+            *buffer++ = (uint8_t)(tempVal >> (8U * j));
+        }
+    }
+
+    return buffer;
+}
+
+#endif // QSPI_FIFO_H
@@ -0,0 +1,312 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "qspi_metrics.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cycles.h"
+
+#define EXPAND_AS_NAME(NAME, OPCODE) [FPGA_LUT_IDX_##NAME] = #NAME,
+
+static qspi_metrics_t metrics_local = {
+    .magic   = QSPI_METRICS_MAGIC,
+    .version = QSPI_METRICS_VERSION,
+    .slots   = QSPI_METRICS_SLOTS,
+};
+
+qspi_metrics_t *qspi_metrics = &metrics_local;
+
+static const char *const slot_names[QSPI_METRICS_SLOTS] = {
+    FPGA_TABLE(EXPAND_AS_NAME)[QSPI_METRICS_OTHER] = "OTHER",
+};
+
+static const char *const wait_names[QSPI_WAIT_SITES] = {
+    [QSPI_WAIT_TX_EMPTY]     = "tx_empty",
+    [QSPI_WAIT_RX_WATERMARK] = "rx_watermark",
+    [QSPI_WAIT_CMD_DONE]     = "cmd_done",
+};
+
+/* Calibrated once, publishing and the stall threshold both need the rate */
+static uint64_t metrics_hz(void)
+{
+    if (metrics_local.cycles_hz == 0)
+    {
+        metrics_local.cycles_hz = cycles_calibrate();
+    }
+    return metrics_local.cycles_hz;
+}
+
+static void copy_counters(qspi_metrics_t *dst, const qspi_metrics_t *src)
+{
+    for (unsigned i = 0; i < QSPI_METRICS_SLOTS; i++)
+    {
+        atomic_store(&dst->op[i].commands, atomic_load(&src->op[i].commands));
+        atomic_store(&dst->op[i].bytes, atomic_load(&src->op[i].bytes));
+        atomic_store(&dst->op[i].errors, atomic_load(&src->op[i].errors));
+        atomic_store(&dst->op[i].latency_cycles, atomic_load(&src->op[i].latency_cycles));
+    }
+
+    for (unsigned i = 0; i < QSPI_WAIT_SITES; i++)
+    {
+        atomic_store(&dst->wait[i].waits, atomic_load(&src->wait[i].waits));
+        atomic_store(&dst->wait[i].spins, atomic_load(&src->wait[i].spins));
+        atomic_store(&dst->wait[i].cycles, atomic_load(&src->wait[i].cycles));
+        atomic_store(&dst->wait[i].max_cycles, atomic_load(&src->wait[i].max_cycles));
+        atomic_store(&dst->wait[i].stalls, atomic_load(&src->wait[i].stalls));
+    }
+}
+
+void QSPI_Metrics_SetStallThreshold(uint64_t ns)
+{
+    uint64_t cycles = ns ? (uint64_t)((double)metrics_hz() * (double)ns / 1e9) : 0;
+
+    qspi_metrics->stall_cycles = ns != 0 && cycles == 0 ? 1 : cycles;
+}
+
+int QSPI_Metrics_Publish(void)
+{
+    if (qspi_metrics != &metrics_local)
+    {
+        return 0;
+    }
+
+    int fd = shm_open(QSPI_METRICS_SHM_NAME, O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        return -errno;
+    }
+
+    if (ftruncate(fd, sizeof(qspi_metrics_t)) != 0)
+    {
+        int err = errno;
+        close(fd);
+        shm_unlink(QSPI_METRICS_SHM_NAME);
+        return -err;
+    }
+
+    qspi_metrics_t *shared = mmap(NULL, sizeof(qspi_metrics_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int             err    = errno;
+    close(fd);
+    if (shared == MAP_FAILED)
+    {
+        shm_unlink(QSPI_METRICS_SHM_NAME);
+        return -err;
+    }
+
+    // Readers check the magic, so it is written last
+    shared->magic     = 0;
+    shared->version   = QSPI_METRICS_VERSION;
+    shared->slots     = QSPI_METRICS_SLOTS;
+    shared->cycles_hz    = metrics_hz();
+    shared->stall_cycles = metrics_local.stall_cycles;
+    copy_counters(shared, &metrics_local);
+    atomic_thread_fence(memory_order_release);
+    shared->magic = QSPI_METRICS_MAGIC;
+
+    qspi_metrics = shared;
+    return 0;
+}
+
+void QSPI_Metrics_Unpublish(void)
+{
+    qspi_metrics_t *shared = qspi_metrics;
+    if (shared == &metrics_local)
+    {
+        return;
+    }
+
+    copy_counters(&metrics_local, shared);
+    metrics_local.stall_cycles = shared->stall_cycles;
+    qspi_metrics               = &metrics_local;
+    munmap(shared, sizeof(qspi_metrics_t));
+    shm_unlink(QSPI_METRICS_SHM_NAME);
+}
+
+const qspi_metrics_t *QSPI_Metrics_Attach(void)
+{
+    int fd = shm_open(QSPI_METRICS_SHM_NAME, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(qspi_metrics_t))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    const qspi_metrics_t *metrics = mmap(NULL, sizeof(qspi_metrics_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (metrics == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    if (metrics->magic != QSPI_METRICS_MAGIC || metrics->version != QSPI_METRICS_VERSION || metrics->slots != QSPI_METRICS_SLOTS)
+    {
+        munmap((void *)metrics, sizeof(qspi_metrics_t));
+        return NULL;
+    }
+
+    return metrics;
+}
+
+void QSPI_Metrics_Detach(const qspi_metrics_t *metrics)
+{
+    if (metrics != NULL && metrics != qspi_metrics)
+    {
+        munmap((void *)metrics, sizeof(qspi_metrics_t));
+    }
+}
+
+void QSPI_Metrics_Reset(void)
+{
+    qspi_metrics_t zero;
+    memset(&zero, 0, sizeof(zero));
+    copy_counters(qspi_metrics, &zero);
+}
+
+const char *QSPI_Metrics_WaitName(qspi_wait_site_t site)
+{
+    return site < QSPI_WAIT_SITES ? wait_names[site] : "?";
+}
+
+const char *QSPI_Metrics_Name(unsigned slot)
+{
+    return slot < QSPI_METRICS_SLOTS && slot_names[slot] != NULL ? slot_names[slot] : "?";
+}
+
+static void write_family(const qspi_metrics_t *metrics, FILE *out, const char *name, const char *help, size_t offset, double scale)
+{
+    fprintf(out, "# HELP %s %s\n# TYPE %s counter\n", name, help, name);
+
+    for (unsigned i = 0; i < QSPI_METRICS_SLOTS; i++)
+    {
+        const _Atomic uint64_t *counter = (const _Atomic uint64_t *)(const void *)((const uint8_t *)&metrics->op[i] + offset);
+        uint64_t                value   = atomic_load_explicit(counter, memory_order_relaxed);
+
+        if (scale != 0)
+        {
+            fprintf(out, "%s{opcode=\"%s\"} %.9f\n", name, QSPI_Metrics_Name(i), (double)value * scale);
+        }
+        else
+        {
+            fprintf(out, "%s{opcode=\"%s\"} %llu\n", name, QSPI_Metrics_Name(i), (unsigned long long)value);
+        }
+    }
+}
+
+static void write_wait_family(const qspi_metrics_t *metrics, FILE *out, const char *name, const char *type, const char *help, size_t offset,
+                              double scale)
+{
+    fprintf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+
+    for (unsigned i = 0; i < QSPI_WAIT_SITES; i++)
+    {
+        const _Atomic uint64_t *counter = (const _Atomic uint64_t *)(const void *)((const uint8_t *)&metrics->wait[i] + offset);
+        uint64_t                value   = atomic_load_explicit(counter, memory_order_relaxed);
+
+        if (scale != 0)
+        {
+            fprintf(out, "%s{site=\"%s\"} %.9f\n", name, QSPI_Metrics_WaitName(i), (double)value * scale);
+        }
+        else
+        {
+            fprintf(out, "%s{site=\"%s\"} %llu\n", name, QSPI_Metrics_WaitName(i), (unsigned long long)value);
+        }
+    }
+}
+
+int QSPI_Metrics_WriteText(const qspi_metrics_t *metrics, FILE *out)
+{
+    write_family(metrics, out, "qspi_commands_total", "IP commands issued per FPGA opcode.", offsetof(qspi_metrics_op_t, commands), 0);
+    write_family(metrics, out, "qspi_bytes_total", "Payload bytes moved per FPGA opcode.", offsetof(qspi_metrics_op_t, bytes), 0);
+    write_family(metrics, out, "qspi_errors_total", "Failed commands and FIFO errors per FPGA opcode.", offsetof(qspi_metrics_op_t, errors), 0);
+
+    if (metrics->cycles_hz != 0)
+    {
+        write_family(metrics, out, "qspi_latency_seconds_total", "Time spent in IP commands per FPGA opcode.", offsetof(qspi_metrics_op_t, latency_cycles),
+                     1.0 / (double)metrics->cycles_hz);
+    }
+    else
+    {
+        write_family(metrics, out, "qspi_latency_cycles_total", "Cycle counter ticks spent in IP commands per FPGA opcode.",
+                     offsetof(qspi_metrics_op_t, latency_cycles), 0);
+    }
+
+    write_wait_family(metrics, out, "qspi_wait_total", "counter", "Spin waits on INTR per wait site.", offsetof(qspi_metrics_wait_t, waits), 0);
+    write_wait_family(metrics, out, "qspi_wait_spins_total", "counter", "INTR polls that found the flag clear per wait site.",
+                      offsetof(qspi_metrics_wait_t, spins), 0);
+    write_wait_family(metrics, out, "qspi_wait_stalls_total", "counter", "Spin waits longer than the stall threshold per wait site.",
+                      offsetof(qspi_metrics_wait_t, stalls), 0);
+
+    if (metrics->cycles_hz != 0)
+    {
+        double scale = 1.0 / (double)metrics->cycles_hz;
+        write_wait_family(metrics, out, "qspi_wait_seconds_total", "counter", "Time spent spinning per wait site.", offsetof(qspi_metrics_wait_t, cycles),
+                          scale);
+        write_wait_family(metrics, out, "qspi_wait_max_seconds", "gauge", "Longest spin wait per wait site.", offsetof(qspi_metrics_wait_t, max_cycles),
+                          scale);
+    }
+    else
+    {
+        write_wait_family(metrics, out, "qspi_wait_cycles_total", "counter", "Cycle counter ticks spent spinning per wait site.",
+                          offsetof(qspi_metrics_wait_t, cycles), 0);
+        write_wait_family(metrics, out, "qspi_wait_max_cycles", "gauge", "Longest spin wait in cycle counter ticks per wait site.",
+                          offsetof(qspi_metrics_wait_t, max_cycles), 0);
+    }
+
+    return ferror(out) ? -1 : 0;
+}
+
+int QSPI_Metrics_WriteTextfile(const qspi_metrics_t *metrics, const char *path)
+{
+    size_t len = strlen(path);
+    char  *tmp = malloc(len + sizeof(".tmp"));
+    if (tmp == NULL)
+    {
+        return -ENOMEM;
+    }
+    memcpy(tmp, path, len);
+    memcpy(tmp + len, ".tmp", sizeof(".tmp"));
+
+    int   ret  = 0;
+    FILE *file = fopen(tmp, "w");
+    if (file == NULL)
+    {
+        ret = -errno;
+    }
+    else
+    {
+        if (QSPI_Metrics_WriteText(metrics, file) != 0)
+        {
+            ret = -EIO;
+        }
+        if (fclose(file) != 0 && ret == 0)
+        {
+            ret = -errno;
+        }
+        if (ret == 0 && rename(tmp, path) != 0)
+        {
+            ret = -errno;
+        }
+        if (ret != 0)
+        {
+            unlink(tmp);
+        }
+    }
+
+    free(tmp);
+    return ret;
+}
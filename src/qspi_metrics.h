@@ -0,0 +1,182 @@
+#ifndef QSPI_METRICS_H
+#define QSPI_METRICS_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "fpga_interface.h"
+
+/*
+ * Per-opcode traffic counters of the IP command path.
+ *
+ * Every transfer_blocking() call adds to the slot of its LUT sequence, which
+ * is the fpga_opcode_index_t when the FPGA LUT is loaded. Sequences outside
+ * the FPGA table share QSPI_METRICS_OTHER. Updates are relaxed atomic adds;
+ * readers never take a lock the driver waits on.
+ *
+ * The spin loops on INTR are accounted per wait site: waits, polling
+ * iterations, cycles, the longest wait and stalls, the waits of at least the
+ * stall threshold. Each stall is also logged (rate limited).
+ *
+ * QSPI_Metrics_Publish() moves the block into a POSIX shared-memory segment
+ * that monitoring processes map read-only with QSPI_Metrics_Attach(), e.g.
+ * the qspi_metrics tool that writes a node_exporter textfile. qspi_tool
+ * publishes when started with --metrics.
+ */
+
+#define QSPI_METRICS_SHM_NAME "/qspi_metrics"
+#define QSPI_METRICS_MAGIC    0x4D495051 // "QPIM"
+#define QSPI_METRICS_VERSION  3
+
+#define QSPI_METRICS_OTHER FPGA_OPCODE_IDX_COUNT // LUT sequences outside the FPGA table
+#define QSPI_METRICS_SLOTS (FPGA_OPCODE_IDX_COUNT + 1)
+
+#define QSPI_WAIT_STALL_NS (100 * 1000) // Default stall threshold
+
+typedef enum
+{
+    QSPI_WAIT_TX_EMPTY,     // write_blocking(), room in the IPTXFSTS fill level
+    QSPI_WAIT_RX_WATERMARK, // read_blocking(), IPRXWA
+    QSPI_WAIT_CMD_DONE,     // transfer_blocking(), IPCMDDONE
+    QSPI_WAIT_SITES
+} qspi_wait_site_t;
+
+typedef struct
+{
+    _Atomic uint64_t commands;
+    _Atomic uint64_t bytes;
+    _Atomic uint64_t errors;
+    _Atomic uint64_t latency_cycles; // Sum over all commands
+} qspi_metrics_op_t;
+
+typedef struct
+{
+    _Atomic uint64_t waits;
+    _Atomic uint64_t spins; // INTR polls that found the flag clear
+    _Atomic uint64_t cycles;
+    _Atomic uint64_t max_cycles;
+    _Atomic uint64_t stalls;
+} qspi_metrics_wait_t;
+
+typedef struct
+{
+    uint32_t            magic;
+    uint32_t            version;
+    uint32_t            slots;
+    uint32_t            reserved;
+    uint64_t            cycles_hz;    // cycles_now() ticks per second, 0 when unknown
+    uint64_t            stall_cycles; // Waits of at least this long are stalls, 0 disables
+    qspi_metrics_op_t   op[QSPI_METRICS_SLOTS];
+    qspi_metrics_wait_t wait[QSPI_WAIT_SITES];
+} qspi_metrics_t;
+
+extern qspi_metrics_t *qspi_metrics;
+
+static inline unsigned QSPI_Metrics_Slot(uint32_t seq_index)
+{
+    return seq_index < FPGA_OPCODE_IDX_COUNT ? seq_index : QSPI_METRICS_OTHER;
+}
+
+/* Accounts one command of the LUT sequence seq_index */
+static inline void QSPI_Metrics_Record(uint32_t seq_index, uint32_t bytes, int result, uint64_t cycles)
+{
+    qspi_metrics_op_t *op = &qspi_metrics->op[QSPI_Metrics_Slot(seq_index)];
+
+    atomic_fetch_add_explicit(&op->commands, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&op->bytes, bytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&op->latency_cycles, cycles, memory_order_relaxed);
+    if (result != 0)
+    {
+        atomic_fetch_add_explicit(&op->errors, 1, memory_order_relaxed);
+    }
+}
+
+/* Accounts an error of the LUT sequence seq_index found outside its transfer */
+static inline void QSPI_Metrics_Error(uint32_t seq_index)
+{
+    atomic_fetch_add_explicit(&qspi_metrics->op[QSPI_Metrics_Slot(seq_index)].errors, 1, memory_order_relaxed);
+}
+
+/* Accounts one spin wait, returns 1 when it was a stall */
+static inline int QSPI_Metrics_Wait(qspi_wait_site_t site, uint64_t spins, uint64_t cycles)
+{
+    qspi_metrics_wait_t *w = &qspi_metrics->wait[site];
+
+    atomic_fetch_add_explicit(&w->waits, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&w->spins, spins, memory_order_relaxed);
+    atomic_fetch_add_explicit(&w->cycles, cycles, memory_order_relaxed);
+
+    uint64_t max = atomic_load_explicit(&w->max_cycles, memory_order_relaxed);
+    while (cycles > max && !atomic_compare_exchange_weak_explicit(&w->max_cycles, &max, cycles, memory_order_relaxed, memory_order_relaxed))
+    {
+    }
+
+    if (qspi_metrics->stall_cycles != 0 && cycles >= qspi_metrics->stall_cycles)
+    {
+        atomic_fetch_add_explicit(&w->stalls, 1, memory_order_relaxed);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Sets the wait duration counted as a stall, 0 disables stall detection.
+ *
+ * Calibrates the cycle counter on first use (10 ms on x86). QSPI_Init() sets
+ * QSPI_WAIT_STALL_NS.
+ */
+void QSPI_Metrics_SetStallThreshold(uint64_t ns);
+
+/**
+ * @brief Name of a wait site, as used in the exported labels.
+ */
+const char *QSPI_Metrics_WaitName(qspi_wait_site_t site);
+
+/**
+ * @brief Moves the counters into the shared-memory segment QSPI_METRICS_SHM_NAME.
+ *
+ * The counters gathered so far are carried over. Call it before transfers
+ * start, the driver does not synchronise with the switch.
+ *
+ * @return 0 on success, -errno otherwise (the counters stay process-local).
+ */
+int QSPI_Metrics_Publish(void);
+
+/**
+ * @brief Moves the counters back to process memory and removes the segment.
+ */
+void QSPI_Metrics_Unpublish(void);
+
+/**
+ * @brief Maps the segment of a publishing process read-only.
+ *
+ * @return The block, NULL when it does not exist or has another layout.
+ */
+const qspi_metrics_t *QSPI_Metrics_Attach(void);
+
+void QSPI_Metrics_Detach(const qspi_metrics_t *metrics);
+
+void QSPI_Metrics_Reset(void);
+
+/**
+ * @brief Name of a slot, the FPGA_TABLE entry or "OTHER".
+ */
+const char *QSPI_Metrics_Name(unsigned slot);
+
+/**
+ * @brief Writes the counters in the Prometheus text exposition format.
+ *
+ * @return 0 on success, -1 on a write error.
+ */
+int QSPI_Metrics_WriteText(const qspi_metrics_t *metrics, FILE *out);
+
+/**
+ * @brief Writes the text format to path through a temporary file and rename(),
+ *        so a textfile collector never reads a partial file.
+ *
+ * @return 0 on success, -errno otherwise.
+ */
+int QSPI_Metrics_WriteTextfile(const qspi_metrics_t *metrics, const char *path);
+
+#endif // QSPI_METRICS_H
@@ -0,0 +1,101 @@
+#include "qspi_phase.h"
+
+#include <assert.h>
+
+_Atomic uint64_t qspi_phase_hist[QSPI_PHASE_COUNT][QSPI_PHASE_BUCKETS];
+
+static const char *const phase_names[QSPI_PHASE_COUNT] = {
+    [QSPI_PHASE_SETUP]     = "setup",
+    [QSPI_PHASE_KICK]      = "kick",
+    [QSPI_PHASE_FIFO_WAIT] = "fifo_wait",
+    [QSPI_PHASE_FIFO_COPY] = "fifo_copy",
+    [QSPI_PHASE_DONE]      = "done",
+    [QSPI_PHASE_TOTAL]     = "total",
+};
+
+uint64_t QSPI_Phase_BucketValue(size_t bucket)
+{
+    assert(bucket < QSPI_PHASE_BUCKETS);
+
+    if (bucket < QSPI_PHASE_SUB_BUCKETS)
+    {
+        return bucket;
+    }
+
+    unsigned shift = (unsigned)(bucket / QSPI_PHASE_SUB_BUCKETS) - 1;
+    return (uint64_t)(QSPI_PHASE_SUB_BUCKETS + bucket % QSPI_PHASE_SUB_BUCKETS) << shift;
+}
+
+/* Copies the counts of a phase, returns their total */
+static uint64_t snapshot(qspi_phase_t phase, uint64_t *counts)
+{
+    uint64_t total = 0;
+
+    for (size_t i = 0; i < QSPI_PHASE_BUCKETS; i++)
+    {
+        counts[i] = atomic_load_explicit(&qspi_phase_hist[phase][i], memory_order_relaxed);
+        total += counts[i];
+    }
+    return total;
+}
+
+static uint64_t percentile(const uint64_t *counts, uint64_t total, double pct)
+{
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)((double)total * pct / 100.0 + 0.5);
+    uint64_t seen = 0;
+
+    rank = rank ? rank : 1;
+    for (size_t i = 0; i < QSPI_PHASE_BUCKETS; i++)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+        {
+            return QSPI_Phase_BucketValue(i);
+        }
+    }
+    return 0;
+}
+
+uint64_t QSPI_Phase_Percentile(qspi_phase_t phase, double pct)
+{
+    assert(phase < QSPI_PHASE_COUNT);
+
+    uint64_t counts[QSPI_PHASE_BUCKETS];
+    return percentile(counts, snapshot(phase, counts), pct);
+}
+
+void QSPI_Phase_Summary(qspi_phase_t phase, qspi_phase_summary_t *summary)
+{
+    assert(phase < QSPI_PHASE_COUNT);
+    assert(summary != NULL);
+
+    uint64_t counts[QSPI_PHASE_BUCKETS];
+    uint64_t total = snapshot(phase, counts);
+
+    summary->count = total;
+    summary->p50   = percentile(counts, total, 50);
+    summary->p90   = percentile(counts, total, 90);
+    summary->p99   = percentile(counts, total, 99);
+    summary->max   = percentile(counts, total, 100);
+}
+
+const char *QSPI_Phase_Name(qspi_phase_t phase)
+{
+    return phase < QSPI_PHASE_COUNT ? phase_names[phase] : "?";
+}
+
+void QSPI_Phase_Reset(void)
+{
+    for (size_t p = 0; p < QSPI_PHASE_COUNT; p++)
+    {
+        for (size_t i = 0; i < QSPI_PHASE_BUCKETS; i++)
+        {
+            atomic_store_explicit(&qspi_phase_hist[p][i], 0, memory_order_relaxed);
+        }
+    }
+}
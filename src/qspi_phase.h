@@ -0,0 +1,113 @@
+#ifndef QSPI_PHASE_H
+#define QSPI_PHASE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cycles.h"
+
+/*
+ * Latency histograms of the phases of an IP command, in cycles_now() ticks.
+ *
+ * transfer_blocking() timestamps each phase and adds it to a log-linear
+ * (HDR style) histogram: values below QSPI_PHASE_SUB_BUCKETS are exact, above
+ * that every power of two is split into QSPI_PHASE_SUB_BUCKETS buckets, so a
+ * reported value is within 1/QSPI_PHASE_SUB_BUCKETS of the measured one.
+ * Recording is a counter read and an atomic increment per phase; build with
+ * -DQSPI_NO_PHASE_STATS to compile it out.
+ */
+
+#define QSPI_PHASE_SUB_BITS    4
+#define QSPI_PHASE_SUB_BUCKETS (1 << QSPI_PHASE_SUB_BITS)
+#define QSPI_PHASE_BUCKETS     ((64 - QSPI_PHASE_SUB_BITS + 1) * QSPI_PHASE_SUB_BUCKETS)
+
+typedef enum
+{
+    QSPI_PHASE_SETUP,     // Sequence pointer reset, flag clear, FIFO flush, IPCR0/1
+    QSPI_PHASE_KICK,      // IPCMD write
+    QSPI_PHASE_FIFO_WAIT, // Spin until a watermark chunk may be moved
+    QSPI_PHASE_FIFO_COPY, // Fill or drain of one watermark chunk
+    QSPI_PHASE_DONE,      // Spin until IPCMDDONE
+    QSPI_PHASE_TOTAL,     // Whole transfer_blocking() call
+    QSPI_PHASE_COUNT
+} qspi_phase_t;
+
+typedef struct
+{
+    uint64_t count;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t max;
+} qspi_phase_summary_t;
+
+extern _Atomic uint64_t qspi_phase_hist[QSPI_PHASE_COUNT][QSPI_PHASE_BUCKETS];
+
+static inline size_t QSPI_Phase_Bucket(uint64_t cycles)
+{
+    if (cycles < QSPI_PHASE_SUB_BUCKETS)
+    {
+        return (size_t)cycles;
+    }
+
+    unsigned shift = (unsigned)(63 - __builtin_clzll(cycles)) - QSPI_PHASE_SUB_BITS;
+    return (size_t)(shift + 1) * QSPI_PHASE_SUB_BUCKETS + (size_t)((cycles >> shift) & (QSPI_PHASE_SUB_BUCKETS - 1));
+}
+
+static inline void QSPI_Phase_Record(qspi_phase_t phase, uint64_t cycles)
+{
+#ifndef QSPI_NO_PHASE_STATS
+    atomic_fetch_add_explicit(&qspi_phase_hist[phase][QSPI_Phase_Bucket(cycles)], 1, memory_order_relaxed);
+#else
+    (void)phase;
+    (void)cycles;
+#endif
+}
+
+/* Timestamp a phase starts at, 0 when the stats are compiled out */
+static inline uint64_t QSPI_Phase_Now(void)
+{
+#ifndef QSPI_NO_PHASE_STATS
+    return cycles_now();
+#else
+    return 0;
+#endif
+}
+
+/* Records the phase that started at since, returns the start of the next one */
+static inline uint64_t QSPI_Phase_Mark(qspi_phase_t phase, uint64_t since)
+{
+#ifndef QSPI_NO_PHASE_STATS
+    uint64_t now = cycles_now();
+    QSPI_Phase_Record(phase, now - since);
+    return now;
+#else
+    (void)phase;
+    (void)since;
+    return 0;
+#endif
+}
+
+/**
+ * @brief Smallest value that falls into a histogram bucket.
+ */
+uint64_t QSPI_Phase_BucketValue(size_t bucket);
+
+/**
+ * @brief Value below which pct percent of the recorded samples of a phase fall.
+ *
+ * @return Cycles, 0 when nothing was recorded.
+ */
+uint64_t QSPI_Phase_Percentile(qspi_phase_t phase, double pct);
+
+/**
+ * @brief Sample count and percentiles of a phase, in cycles.
+ */
+void QSPI_Phase_Summary(qspi_phase_t phase, qspi_phase_summary_t *summary);
+
+const char *QSPI_Phase_Name(qspi_phase_t phase);
+
+void QSPI_Phase_Reset(void);
+
+#endif // QSPI_PHASE_H
@@ -0,0 +1,205 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "qspi_recorder.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DUMP_PATH_MAX 256
+
+qspi_recorder_entry_t qspi_recorder_ring[QSPI_RECORDER_ENTRIES];
+_Atomic uint64_t      qspi_recorder_head;
+
+static char dump_path[DUMP_PATH_MAX] = "/tmp/qspi_recorder.log";
+
+/* Copies one slot, returns 0 when it is empty or was rewritten while copying */
+static int read_entry(const qspi_recorder_entry_t *e, uint64_t n, qspi_recorder_entry_t *out)
+{
+    if (!seq_ring_read_begin(&e->seq, n))
+    {
+        return 0;
+    }
+
+    out->cycles = e->cycles;
+    out->addr   = e->addr;
+    out->value  = e->value;
+    out->first  = e->first;
+    out->spins  = e->spins;
+    out->dir    = e->dir;
+
+    if (!seq_ring_read_end(&e->seq, n))
+    {
+        return 0;
+    }
+
+    atomic_init(&out->seq, n + 1);
+    return 1;
+}
+
+size_t QSPI_Recorder_Snapshot(qspi_recorder_entry_t *out, size_t max)
+{
+    uint64_t head  = atomic_load_explicit(&qspi_recorder_head, memory_order_acquire);
+    uint64_t first = seq_ring_oldest(head, QSPI_RECORDER_ENTRIES);
+    size_t   count = 0;
+
+    for (uint64_t n = first; n < head && count < max; n++)
+    {
+        count += (size_t)read_entry(&qspi_recorder_ring[n & (QSPI_RECORDER_ENTRIES - 1)], n, &out[count]);
+    }
+
+    return count;
+}
+
+void QSPI_Recorder_Reset(void)
+{
+    for (size_t i = 0; i < QSPI_RECORDER_ENTRIES; i++)
+    {
+        atomic_store_explicit(&qspi_recorder_ring[i].seq, 0, memory_order_relaxed);
+    }
+    atomic_store(&qspi_recorder_head, 0);
+}
+
+/* snprintf is not async-signal-safe, numbers are rendered by hand */
+static size_t put_hex(char *out, uint64_t value, int digits)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    for (int i = digits - 1; i >= 0; i--)
+    {
+        out[i] = hex[value & 0xF];
+        value >>= 4;
+    }
+    return (size_t)digits;
+}
+
+static size_t put_dec(char *out, uint64_t value)
+{
+    char   tmp[20];
+    size_t len = 0;
+
+    do
+    {
+        tmp[len++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    for (size_t i = 0; i < len; i++)
+    {
+        out[i] = tmp[len - 1 - i];
+    }
+    return len;
+}
+
+static int write_all(int fd, const char *buf, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return -1;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+int QSPI_Recorder_Dump(int fd)
+{
+    char   line[96];
+    size_t len;
+
+    len = 0;
+    memcpy(line, "# qspi recorder, cycles/s ", 26);
+    len += 26;
+    len += put_dec(line + len, cycles_freq());
+    line[len++] = '\n';
+    memcpy(line + len, "# seq cycles dir addr value [first spins]\n", 42);
+    len += 42;
+    if (write_all(fd, line, len) != 0)
+    {
+        return -1;
+    }
+
+    uint64_t head  = atomic_load_explicit(&qspi_recorder_head, memory_order_acquire);
+    uint64_t first = seq_ring_oldest(head, QSPI_RECORDER_ENTRIES);
+
+    for (uint64_t n = first; n < head; n++)
+    {
+        qspi_recorder_entry_t e;
+        if (!read_entry(&qspi_recorder_ring[n & (QSPI_RECORDER_ENTRIES - 1)], n, &e))
+        {
+            continue;
+        }
+
+        len         = put_dec(line, n);
+        line[len++] = ' ';
+        len += put_dec(line + len, e.cycles);
+        line[len++] = ' ';
+        line[len++] = (char)e.dir;
+        line[len++] = ' ';
+        line[len++] = '0';
+        line[len++] = 'x';
+        len += put_hex(line + len, e.addr, 8);
+        line[len++] = ' ';
+        line[len++] = '0';
+        line[len++] = 'x';
+        len += put_hex(line + len, e.value, 8);
+        if (e.dir == QSPI_RECORDER_POLL)
+        {
+            line[len++] = ' ';
+            line[len++] = '0';
+            line[len++] = 'x';
+            len += put_hex(line + len, e.first, 8);
+            line[len++] = ' ';
+            len += put_dec(line + len, e.spins);
+        }
+        line[len++] = '\n';
+
+        if (write_all(fd, line, len) != 0)
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void QSPI_Recorder_SetDumpPath(const char *path)
+{
+    if (path == NULL)
+    {
+        dump_path[0] = '\0';
+        return;
+    }
+
+    strncpy(dump_path, path, sizeof(dump_path) - 1);
+    dump_path[sizeof(dump_path) - 1] = '\0';
+}
+
+int QSPI_Recorder_DumpFile(void)
+{
+    if (dump_path[0] == '\0')
+    {
+        return 0;
+    }
+
+    int fd = open(dump_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        return -errno;
+    }
+
+    int ret = QSPI_Recorder_Dump(fd);
+    close(fd);
+    return ret;
+}
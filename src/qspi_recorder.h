@@ -0,0 +1,103 @@
+#ifndef QSPI_RECORDER_H
+#define QSPI_RECORDER_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cycles.h"
+#include "seq_ring.h"
+
+/*
+ * Flight recorder of the register accesses made by the QSPI driver.
+ *
+ * Every access is stored in a fixed ring (oldest entries are overwritten), so
+ * the last QSPI_RECORDER_ENTRIES accesses before a fault can be inspected
+ * without LOG_REGISTER tracing. A status poll loop is stored as one entry
+ * with the first and last value read and the number of extra reads, so a
+ * long stall does not flush the ring. Recording is one atomic increment and
+ * a few stores; build with -DQSPI_NO_RECORDER to compile it out.
+ */
+
+#define QSPI_RECORDER_ENTRIES 4096 // Power of two
+
+typedef enum
+{
+    QSPI_RECORDER_READ  = 'R',
+    QSPI_RECORDER_WRITE = 'W',
+    QSPI_RECORDER_POLL  = 'P', // value is the last read, first and spins describe the loop
+} qspi_recorder_dir_t;
+
+typedef struct
+{
+    _Atomic uint64_t seq; // Access number + 1, 0 while the slot is empty or being written
+    uint64_t         cycles;
+    uint32_t         addr; // Physical register address
+    uint32_t         value;
+    uint32_t         first; // QSPI_RECORDER_POLL: first value read
+    uint32_t         spins; // QSPI_RECORDER_POLL: reads after the first, saturating
+    uint8_t          dir;
+} qspi_recorder_entry_t;
+
+extern qspi_recorder_entry_t qspi_recorder_ring[QSPI_RECORDER_ENTRIES];
+extern _Atomic uint64_t      qspi_recorder_head;
+
+static inline void QSPI_Recorder_Put(qspi_recorder_dir_t dir, uint32_t addr, uint32_t value, uint32_t first, uint32_t spins)
+{
+#ifndef QSPI_NO_RECORDER
+    uint64_t               n = seq_ring_claim(&qspi_recorder_head);
+    qspi_recorder_entry_t *e = &qspi_recorder_ring[n & (QSPI_RECORDER_ENTRIES - 1)];
+
+    seq_ring_open(&e->seq);
+    e->cycles = cycles_now();
+    e->addr   = addr;
+    e->value  = value;
+    e->first  = first;
+    e->spins  = spins;
+    e->dir    = (uint8_t)dir;
+    seq_ring_publish(&e->seq, n);
+#else
+    (void)dir;
+    (void)addr;
+    (void)value;
+    (void)first;
+    (void)spins;
+#endif
+}
+
+static inline void QSPI_Recorder_Record(qspi_recorder_dir_t dir, uint32_t addr, uint32_t value)
+{
+    QSPI_Recorder_Put(dir, addr, value, 0, 0);
+}
+
+/* One entry for a poll loop on addr that read first, then spins more times until last */
+static inline void QSPI_Recorder_Poll(uint32_t addr, uint32_t first, uint32_t last, uint64_t spins)
+{
+    QSPI_Recorder_Put(QSPI_RECORDER_POLL, addr, last, first, spins > UINT32_MAX ? UINT32_MAX : (uint32_t)spins);
+}
+
+/**
+ * @brief Copies the recorded accesses, oldest first. Slots being written are skipped.
+ *
+ * @return Number of entries copied.
+ */
+size_t QSPI_Recorder_Snapshot(qspi_recorder_entry_t *out, size_t max);
+
+void QSPI_Recorder_Reset(void);
+
+/**
+ * @brief Writes the recorded accesses as text to fd. Async-signal-safe.
+ */
+int QSPI_Recorder_Dump(int fd);
+
+/**
+ * @brief Sets the file the fault handler dumps to, NULL disables the dump.
+ */
+void QSPI_Recorder_SetDumpPath(const char *path);
+
+/**
+ * @brief Dumps to the configured file. Async-signal-safe, called on SIGSEGV/SIGBUS.
+ */
+int QSPI_Recorder_DumpFile(void);
+
+#endif // QSPI_RECORDER_H
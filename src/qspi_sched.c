@@ -0,0 +1,246 @@
+#include "qspi_sched.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#include "qspi.h"
+#include "qspi_trace.h"
+
+#include "slog.h"
+
+typedef struct
+{
+    pthread_mutex_t     lock;
+    pthread_cond_t      cond;
+    qspi_sched_config_t cfg;
+
+    qspi_sched_req_t *head[QSPI_SCHED_CLASS_COUNT];
+    qspi_sched_req_t *tail[QSPI_SCHED_CLASS_COUNT];
+    uint32_t          used[QSPI_SCHED_CLASS_COUNT]; // Bytes moved in the current sample period
+    size_t            depth;
+    uint64_t          deadline_us; // Next sample read, 0 when not periodic
+    int               fresh;       // Nothing dispatched since the last sample read
+} qspi_sched_t;
+
+static qspi_sched_t sched = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .cfg  = {.guard_us = 20, .bytes_per_us = 4, .setup_us = 5},
+};
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000U + (uint64_t)ts.tv_nsec / 1000U;
+}
+
+static uint64_t predict_us(const qspi_sched_config_t *cfg, uint32_t size)
+{
+    return cfg->setup_us + (size + cfg->bytes_per_us - 1) / cfg->bytes_per_us;
+}
+
+/* Exceeds its class budget or a whole sample period, so it never fits the regular checks */
+static int oversized(const qspi_sched_config_t *cfg, int cls, uint32_t size)
+{
+    return (cfg->budget_bytes[cls] != 0 && size > cfg->budget_bytes[cls]) ||
+           predict_us(cfg, size) + cfg->guard_us > cfg->sample_period_us;
+}
+
+static qspi_sched_req_t *pop_locked(qspi_sched_t *s, int cls)
+{
+    qspi_sched_req_t *req = s->head[cls];
+
+    s->head[cls] = req->next;
+    if (s->head[cls] == NULL)
+    {
+        s->tail[cls] = NULL;
+    }
+    s->used[cls] += req->xfer.dataSize;
+    s->depth--;
+    s->fresh = 0;
+    QSPI_Trace_Depth(s->depth);
+    return req;
+}
+
+/*
+ * Pops the highest priority request that is within budget and fits before the
+ * deadline. An oversized head would block its class forever, so the first
+ * dispatch after a sample read runs it and accepts overrunning that deadline.
+ */
+static qspi_sched_req_t *pick_locked(qspi_sched_t *s, uint64_t now)
+{
+    const qspi_sched_config_t *cfg = &s->cfg;
+
+    if (s->fresh && s->deadline_us != 0)
+    {
+        for (int cls = QSPI_SCHED_SAMPLE + 1; cls < QSPI_SCHED_CLASS_COUNT; cls++)
+        {
+            if (s->head[cls] != NULL && oversized(cfg, cls, s->head[cls]->xfer.dataSize))
+            {
+                return pop_locked(s, cls);
+            }
+        }
+    }
+
+    for (int cls = 0; cls < QSPI_SCHED_CLASS_COUNT; cls++)
+    {
+        qspi_sched_req_t *req = s->head[cls];
+        if (req == NULL)
+        {
+            continue;
+        }
+
+        uint32_t size = req->xfer.dataSize;
+        if (cls != QSPI_SCHED_SAMPLE && s->deadline_us != 0)
+        {
+            if (cfg->budget_bytes[cls] != 0 && s->used[cls] + size > cfg->budget_bytes[cls])
+            {
+                QSPI_Trace_Sched(QSPI_TRACE_DEFER_BUDGET, cls, req->xfer.seqIndex, size);
+                continue;
+            }
+            if (now + predict_us(cfg, size) + cfg->guard_us > s->deadline_us)
+            {
+                QSPI_Trace_Sched(QSPI_TRACE_DEFER_DEADLINE, cls, req->xfer.seqIndex, size);
+                continue;
+            }
+        }
+
+        return pop_locked(s, cls);
+    }
+
+    return NULL;
+}
+
+static void run_done(qspi_sched_req_t *req, int result)
+{
+    pthread_mutex_lock(&sched.lock);
+    req->result   = result;
+    req->finished = 1;
+    pthread_cond_broadcast(&sched.cond);
+    pthread_mutex_unlock(&sched.lock);
+}
+
+void QSPI_Sched_Config(const qspi_sched_config_t *cfg)
+{
+    assert(cfg != NULL);
+    assert(cfg->bytes_per_us > 0);
+
+    pthread_mutex_lock(&sched.lock);
+    sched.cfg = *cfg;
+    if (cfg->sample_period_us == 0)
+    {
+        sched.deadline_us = 0;
+    }
+    pthread_mutex_unlock(&sched.lock);
+}
+
+int QSPI_Sched_Submit(qspi_sched_req_t *req)
+{
+    if (req == NULL || req->cls >= QSPI_SCHED_CLASS_COUNT || req->xfer.dataSize > QSPI_MAX_TRANSFER_SIZE)
+    {
+        return -EINVAL;
+    }
+
+    req->next     = NULL;
+    req->finished = 0;
+    req->result   = 0;
+
+    pthread_mutex_lock(&sched.lock);
+    if (sched.tail[req->cls] != NULL)
+    {
+        sched.tail[req->cls]->next = req;
+    }
+    else
+    {
+        sched.head[req->cls] = req;
+    }
+    sched.tail[req->cls] = req;
+    sched.depth++;
+    QSPI_Trace_Depth(sched.depth);
+    pthread_mutex_unlock(&sched.lock);
+
+    return 0;
+}
+
+int QSPI_Sched_Run(qspi_sched_req_t *req)
+{
+    if (req == NULL)
+    {
+        return -EINVAL;
+    }
+
+    // Must not be called from the dispatching thread, it would wait for itself
+    req->done = run_done;
+    int ret   = QSPI_Sched_Submit(req);
+    if (ret != 0)
+    {
+        return ret;
+    }
+
+    pthread_mutex_lock(&sched.lock);
+    while (!req->finished)
+    {
+        pthread_cond_wait(&sched.cond, &sched.lock);
+    }
+    ret = req->result;
+    pthread_mutex_unlock(&sched.lock);
+
+    return ret;
+}
+
+int QSPI_Sched_SampleRead(uint32_t addr, void *sample, size_t size)
+{
+    uint64_t start = now_us();
+    int      ret   = QSPI_ReadSample(addr, sample, size);
+
+    pthread_mutex_lock(&sched.lock);
+    sched.deadline_us = sched.cfg.sample_period_us ? start + sched.cfg.sample_period_us : 0;
+    memset(sched.used, 0, sizeof(sched.used));
+    sched.fresh = 1;
+    pthread_mutex_unlock(&sched.lock);
+
+    return ret;
+}
+
+int QSPI_Sched_Dispatch(void)
+{
+    int count = 0;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&sched.lock);
+        qspi_sched_req_t *req = pick_locked(&sched, now_us());
+        pthread_mutex_unlock(&sched.lock);
+
+        if (req == NULL)
+        {
+            break;
+        }
+
+        slogt("Dispatch: class=%d, seq=%u, size=%u", req->cls, req->xfer.seqIndex, req->xfer.dataSize);
+        QSPI_Trace_Sched(QSPI_TRACE_DISPATCH, req->cls, req->xfer.seqIndex, req->xfer.dataSize);
+        int result = QSPI_Transfer(&req->xfer);
+        count++;
+
+        // The request may be released by its callback, do not touch it afterwards
+        if (req->done != NULL)
+        {
+            req->done(req, result);
+        }
+    }
+
+    return count;
+}
+
+size_t QSPI_Sched_Depth(void)
+{
+    pthread_mutex_lock(&sched.lock);
+    size_t depth = sched.depth;
+    pthread_mutex_unlock(&sched.lock);
+
+    return depth;
+}
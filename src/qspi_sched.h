@@ -0,0 +1,84 @@
+#ifndef QSPI_SCHED_H
+#define QSPI_SCHED_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "flexspi.h"
+
+/*
+ * Priority scheduler in front of the IP command path.
+ *
+ * The acquisition thread owns the bus: it reads samples with
+ * QSPI_Sched_SampleRead() and calls QSPI_Sched_Dispatch() in between. Other
+ * threads queue auxiliary transfers with QSPI_Sched_Submit()/QSPI_Sched_Run().
+ * Dispatch serves the classes in priority order, caps each class at its byte
+ * budget per sample period and only starts a transfer when its predicted
+ * duration ends before the next sample deadline, minus a guard time. A
+ * request larger than its budget or a whole period runs first in the slot
+ * after a sample read instead, overrunning that one deadline.
+ */
+
+typedef enum
+{
+    QSPI_SCHED_SAMPLE = 0, // Sample reads, never deferred
+    QSPI_SCHED_CONTROL,    // Register and command writes
+    QSPI_SCHED_BULK,       // UART/SPI tunnel traffic
+    QSPI_SCHED_IDLE,       // Housekeeping, only when nothing else is waiting
+    QSPI_SCHED_CLASS_COUNT
+} qspi_sched_class_t;
+
+typedef struct qspi_sched_req qspi_sched_req_t;
+typedef void (*qspi_sched_cb_t)(qspi_sched_req_t *req, int result);
+
+struct qspi_sched_req
+{
+    flexspi_transfer_t xfer;
+    qspi_sched_class_t cls;
+    qspi_sched_cb_t    done; // Called on the dispatching thread, may be NULL
+    void              *ctx;
+
+    /* Owned by the scheduler while queued */
+    qspi_sched_req_t *next;
+    int               finished;
+    int               result;
+};
+
+typedef struct
+{
+    uint32_t sample_period_us;                     // 0 when samples are not read periodically
+    uint32_t guard_us;                             // Bus time kept free before each sample deadline
+    uint32_t budget_bytes[QSPI_SCHED_CLASS_COUNT]; // Per sample period, 0 is unlimited
+    uint32_t bytes_per_us;                         // Throughput estimate used to predict transfer time
+    uint32_t setup_us;                             // Fixed cost of one IP command
+} qspi_sched_config_t;
+
+void QSPI_Sched_Config(const qspi_sched_config_t *cfg);
+
+/**
+ * @brief Queues a request. The request memory must stay valid until its callback ran.
+ */
+int QSPI_Sched_Submit(qspi_sched_req_t *req);
+
+/**
+ * @brief Queues a request and waits until the dispatching thread executed it.
+ *
+ * @return The transfer result.
+ */
+int QSPI_Sched_Run(qspi_sched_req_t *req);
+
+/**
+ * @brief Reads a sample right away and starts a new sample period.
+ */
+int QSPI_Sched_SampleRead(uint32_t addr, void *sample, size_t size);
+
+/**
+ * @brief Executes queued requests that fit before the next sample deadline.
+ *
+ * @return Number of requests executed.
+ */
+int QSPI_Sched_Dispatch(void);
+
+size_t QSPI_Sched_Depth(void);
+
+#endif // QSPI_SCHED_H
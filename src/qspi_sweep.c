@@ -0,0 +1,236 @@
+#include "qspi_sweep.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cycles.h"
+#include "fpga_interface.h"
+#include "qspi.h"
+
+#include "slog.h"
+
+static void list_set(qspi_sweep_list_t *list, const uint32_t *values, size_t count)
+{
+    assert(count <= QSPI_SWEEP_VALUES_MAX);
+    memcpy(list->value, values, count * sizeof(values[0]));
+    list->count = count;
+}
+
+/* Differs per byte and per iteration, so shifted or stale data does not verify */
+static void fill_pattern(uint8_t *buffer, size_t size, uint32_t iteration)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        buffer[i] = (uint8_t)(i * 7U + iteration * 13U + 1U);
+    }
+}
+
+static int command(const qspi_sweep_config_t *cfg, flexspi_command_type_t type, uint8_t seq, uint8_t *buffer)
+{
+    flexspi_transfer_t xfer;
+    memset(&xfer, 0, sizeof(xfer));
+    xfer.deviceAddress = cfg->addr;
+    xfer.port          = kFlexSPI_PortA1;
+    xfer.cmdType       = type;
+    xfer.seqIndex      = seq;
+    xfer.SeqNumber     = 1;
+    xfer.data          = (uint32_t *)(void *)buffer;
+    xfer.dataSize      = cfg->bytes;
+
+    return QSPI_Transfer(&xfer);
+}
+
+static void run_workload(const qspi_sweep_config_t *cfg, qspi_sweep_result_t *res)
+{
+    uint8_t  wr[QSPI_MAX_TRANSFER_SIZE];
+    uint8_t  rd[QSPI_MAX_TRANSFER_SIZE];
+    uint64_t wr_ns = 0;
+    uint64_t rd_ns = 0;
+
+    for (uint32_t i = 0; i < cfg->iterations; i++)
+    {
+        fill_pattern(wr, cfg->bytes, i);
+        memset(rd, 0, cfg->bytes);
+
+        uint64_t t0 = now_ns();
+        int      we = command(cfg, kFLEXSPI_Write, cfg->wr_seq, wr);
+        uint64_t t1 = now_ns();
+        int      re = command(cfg, kFLEXSPI_Read, cfg->rd_seq, rd);
+        uint64_t t2 = now_ns();
+
+        wr_ns += t1 - t0;
+        rd_ns += t2 - t1;
+        res->commands += 2;
+        res->errors += (we != 0) + (re != 0);
+
+        if (cfg->verify && re == 0 && memcmp(wr, rd, cfg->bytes) != 0)
+        {
+            res->mismatches++;
+            res->errors++;
+        }
+    }
+
+    double total = (double)cfg->bytes * cfg->iterations;
+    res->write_mbps = wr_ns ? total * 1000.0 / (double)wr_ns : 0.0; // bytes/ns * 1000 = MB/s
+    res->read_mbps  = rd_ns ? total * 1000.0 / (double)rd_ns : 0.0;
+}
+
+/* Runs the workload for each watermark pair at the current clock, returns the results stored */
+static size_t sweep_watermarks(const qspi_sweep_config_t *cfg, uint32_t mux, uint32_t pre, uint32_t post, qspi_sweep_result_t *results, size_t max)
+{
+    size_t n = 0;
+
+    for (size_t t = 0; t < cfg->tx_wm.count; t++)
+    {
+        for (size_t r = 0; r < cfg->rx_wm.count && n < max; r++)
+        {
+            uint32_t tx = cfg->tx_wm.value[t];
+            uint32_t rx = cfg->rx_wm.value[r];
+
+            if (QSPI_SetWatermarks(tx, rx) != 0)
+            {
+                slogw("Sweep: skipping watermarks tx=%u rx=%u", tx, rx);
+                continue;
+            }
+
+            qspi_sweep_result_t *res = &results[n++];
+            memset(res, 0, sizeof(*res));
+            res->mux   = mux;
+            res->pre   = pre;
+            res->post  = post;
+            res->tx_wm = tx;
+            res->rx_wm = rx;
+            run_workload(cfg, res);
+        }
+    }
+
+    return n;
+}
+
+void QSPI_Sweep_Defaults(qspi_sweep_config_t *cfg)
+{
+    static const uint32_t mux[]  = {0x2};
+    static const uint32_t pre[]  = {0};
+    static const uint32_t post[] = {7, 5, 3, 1};
+    static const uint32_t wm[]   = {1, 4, 8, 16};
+
+    assert(cfg != NULL);
+    memset(cfg, 0, sizeof(*cfg));
+
+    list_set(&cfg->mux, mux, lengthof(mux));
+    list_set(&cfg->pre, pre, lengthof(pre));
+    list_set(&cfg->post, post, lengthof(post));
+    list_set(&cfg->tx_wm, wm, lengthof(wm));
+    list_set(&cfg->rx_wm, wm, lengthof(wm));
+
+    cfg->wr_seq     = QSPI_SWEEP_SEQ_NONE;
+    cfg->rd_seq     = QSPI_SWEEP_SEQ_NONE;
+    cfg->bytes      = 256;
+    cfg->iterations = 100;
+}
+
+int QSPI_Sweep_ParseList(const char *text, qspi_sweep_list_t *list)
+{
+    assert(list != NULL);
+
+    if (text == NULL || *text == '\0')
+    {
+        return -EINVAL;
+    }
+
+    size_t      count = 0;
+    const char *p     = text;
+    for (;;)
+    {
+        char *end;
+        errno               = 0;
+        unsigned long value = strtoul(p, &end, 0);
+        if (end == p || errno != 0 || value > UINT32_MAX || count == QSPI_SWEEP_VALUES_MAX)
+        {
+            return -EINVAL;
+        }
+        list->value[count++] = (uint32_t)value;
+
+        if (*end == '\0')
+        {
+            break;
+        }
+        if (*end != ',')
+        {
+            return -EINVAL;
+        }
+        p = end + 1;
+    }
+
+    list->count = count;
+    return 0;
+}
+
+size_t QSPI_Sweep_Count(const qspi_sweep_config_t *cfg)
+{
+    assert(cfg != NULL);
+    return cfg->mux.count * cfg->pre.count * cfg->post.count * cfg->tx_wm.count * cfg->rx_wm.count;
+}
+
+int QSPI_Sweep_Run(const qspi_sweep_config_t *cfg, qspi_sweep_result_t *results, size_t max)
+{
+    assert(cfg != NULL);
+    assert(results != NULL || max == 0);
+
+    if (cfg->bytes == 0 || cfg->bytes > QSPI_MAX_TRANSFER_SIZE || cfg->iterations == 0 || cfg->wr_seq == QSPI_SWEEP_SEQ_NONE ||
+        cfg->rd_seq == QSPI_SWEEP_SEQ_NONE)
+    {
+        return -EINVAL;
+    }
+    if (!QSPI_IsInitialized())
+    {
+        return -ENODEV;
+    }
+
+    uint32_t              mux0, pre0, post0, tx0, rx0;
+    qspi_watermark_mode_t mode0 = QSPI_GetWatermarkMode();
+    QSPI_GetClock(&mux0, &pre0, &post0);
+    QSPI_GetWatermarks(&tx0, &rx0);
+
+    size_t n = 0;
+    for (size_t m = 0; m < cfg->mux.count; m++)
+    {
+        for (size_t a = 0; a < cfg->pre.count; a++)
+        {
+            for (size_t b = 0; b < cfg->post.count; b++)
+            {
+                uint32_t mux  = cfg->mux.value[m];
+                uint32_t pre  = cfg->pre.value[a];
+                uint32_t post = cfg->post.value[b];
+
+                if (QSPI_SetClock(mux, pre, post) != 0)
+                {
+                    slogw("Sweep: skipping clock mux=%u pre=%u post=%u", mux, pre, post);
+                    continue;
+                }
+                n += sweep_watermarks(cfg, mux, pre, post, &results[n], max - n);
+            }
+        }
+    }
+
+    QSPI_SetClock(mux0, pre0, post0);
+    QSPI_SetWatermarks(tx0, rx0);
+    QSPI_SetWatermarkMode(mode0);
+    return (int)n;
+}
+
+void QSPI_Sweep_Print(FILE *out, const qspi_sweep_result_t *results, size_t count)
+{
+    assert(out != NULL);
+
+    fprintf(out, "%3s %3s %4s %5s %5s %9s %9s %8s %6s %9s\n", "mux", "pre", "post", "tx_wm", "rx_wm", "wr_MB/s", "rd_MB/s", "commands", "errors",
+            "err_rate");
+    for (size_t i = 0; i < count; i++)
+    {
+        const qspi_sweep_result_t *r = &results[i];
+        fprintf(out, "%3u %3u %4u %5u %5u %9.2f %9.2f %8u %6u %9.6f\n", r->mux, r->pre, r->post, r->tx_wm, r->rx_wm, r->write_mbps, r->read_mbps,
+                r->commands, r->errors, r->commands ? (double)r->errors / r->commands : 0.0);
+    }
+}
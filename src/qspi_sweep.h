@@ -0,0 +1,104 @@
+#ifndef QSPI_SWEEP_H
+#define QSPI_SWEEP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Throughput sweep over the FlexSPI root clock and the IP FIFO watermarks.
+ *
+ * For every combination of the configured mux/pre/post dividers and TX/RX
+ * watermarks, a fixed workload of write and read commands runs and the
+ * achieved throughput and error rate are reported. A command counts as an
+ * error when it fails (the driver reports IPCMDGE and IPCMDERR as -EIO) or,
+ * with verify enabled, reads back data different from what was written.
+ * Verification needs a write/read LUT pair that loops back, e.g. a scratch
+ * register in the FPGA.
+ *
+ * The FPGA forwards what the write sequence carries, so there is no default
+ * sequence pair: on hardware, pick one whose target tolerates the pattern.
+ *
+ * The clock and watermarks in use before the sweep are restored afterwards.
+ * A setting that stops the bus clock hangs the driver's INTR waits, so only
+ * put dividers into the lists the FPGA is specified for.
+ */
+
+#define QSPI_SWEEP_VALUES_MAX 8
+
+/* wr_seq/rd_seq not chosen yet, QSPI_Sweep_Run() refuses to start */
+#define QSPI_SWEEP_SEQ_NONE 0xFF
+
+typedef struct
+{
+    uint32_t value[QSPI_SWEEP_VALUES_MAX];
+    size_t   count;
+} qspi_sweep_list_t;
+
+typedef struct
+{
+    qspi_sweep_list_t mux;
+    qspi_sweep_list_t pre;
+    qspi_sweep_list_t post;
+    qspi_sweep_list_t tx_wm;
+    qspi_sweep_list_t rx_wm;
+
+    uint32_t addr;       // Device address of the workload
+    uint8_t  wr_seq;     // LUT sequence of the write commands, or QSPI_SWEEP_SEQ_NONE
+    uint8_t  rd_seq;     // LUT sequence of the read commands, or QSPI_SWEEP_SEQ_NONE
+    uint32_t bytes;      // Payload of each command, up to QSPI_MAX_TRANSFER_SIZE
+    uint32_t iterations; // Write/read pairs per setting
+    int      verify;     // Compare the read data with the written pattern
+} qspi_sweep_config_t;
+
+typedef struct
+{
+    uint32_t mux;
+    uint32_t pre;
+    uint32_t post;
+    uint32_t tx_wm;
+    uint32_t rx_wm;
+    uint32_t commands;   // Writes and reads issued
+    uint32_t errors;
+    uint32_t mismatches; // Reads that failed verification, included in errors
+    double   write_mbps;
+    double   read_mbps;
+} qspi_sweep_result_t;
+
+/**
+ * @brief Fills cfg with the default lists (the QSPI_Init() clock and a range
+ *        of post dividers and watermarks) and a 256 byte workload.
+ *
+ * wr_seq and rd_seq are left at QSPI_SWEEP_SEQ_NONE and must be set by the caller.
+ */
+void QSPI_Sweep_Defaults(qspi_sweep_config_t *cfg);
+
+/**
+ * @brief Parses a comma separated list of numbers ("1,4,16") into list.
+ *
+ * @return 0 on success, -EINVAL on a malformed list or more than QSPI_SWEEP_VALUES_MAX values.
+ */
+int QSPI_Sweep_ParseList(const char *text, qspi_sweep_list_t *list);
+
+/**
+ * @brief Runs the workload for every combination, at most max of them.
+ *
+ * Combinations whose clock or watermark cannot be set are skipped.
+ *
+ * @return Number of results stored, -EINVAL when the configuration is invalid
+ *         (including an unset wr_seq or rd_seq), or -ENODEV when the driver is
+ *         not initialized.
+ */
+int QSPI_Sweep_Run(const qspi_sweep_config_t *cfg, qspi_sweep_result_t *results, size_t max);
+
+/**
+ * @brief Number of combinations QSPI_Sweep_Run() visits for cfg.
+ */
+size_t QSPI_Sweep_Count(const qspi_sweep_config_t *cfg);
+
+/**
+ * @brief Prints the results as a table, one line per setting.
+ */
+void QSPI_Sweep_Print(FILE *out, const qspi_sweep_result_t *results, size_t count);
+
+#endif // QSPI_SWEEP_H
@@ -0,0 +1,216 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "qspi_trace.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "qspi_metrics.h"
+#include "seq_ring.h"
+
+typedef struct
+{
+    _Atomic uint64_t seq; // Event number + 1, 0 while the slot is empty or being written
+    uint64_t         start;
+    uint64_t         end;
+    uint32_t         tid;
+    uint32_t         opseq; // LUT sequence
+    uint32_t         size;
+    uint32_t         depth;
+    int32_t          arg;
+    uint8_t          type;
+} trace_event_t;
+
+typedef struct
+{
+    trace_event_t   *ring;
+    size_t           capacity; // Power of two
+    _Atomic uint64_t head;
+    uint64_t         origin; // cycles_now() when started, ts 0 of the trace
+    uint64_t         hz;
+} trace_t;
+
+_Atomic int      qspi_trace_enabled;
+_Atomic uint32_t qspi_trace_depth;
+uint64_t         qspi_trace_stall_cycles = UINT64_MAX;
+
+static trace_t                trace;
+static _Thread_local uint32_t trace_tid;
+
+static uint32_t thread_id(void)
+{
+    if (trace_tid == 0)
+    {
+        trace_tid = (uint32_t)syscall(SYS_gettid);
+    }
+    return trace_tid;
+}
+
+void QSPI_Trace_Record(qspi_trace_type_t type, uint64_t start, uint64_t end, uint32_t seq, uint32_t size, int32_t arg)
+{
+    uint64_t       n = seq_ring_claim(&trace.head);
+    trace_event_t *e = &trace.ring[n & (trace.capacity - 1)];
+
+    seq_ring_open(&e->seq);
+    e->start = start;
+    e->end   = end;
+    e->tid   = thread_id();
+    e->opseq = seq;
+    e->size  = size;
+    e->depth = atomic_load_explicit(&qspi_trace_depth, memory_order_relaxed);
+    e->arg   = arg;
+    e->type  = (uint8_t)type;
+    seq_ring_publish(&e->seq, n);
+}
+
+int QSPI_Trace_Start(size_t events)
+{
+    if (QSPI_Trace_Enabled())
+    {
+        return -EBUSY;
+    }
+
+    size_t capacity = 1;
+    while (capacity < events)
+    {
+        capacity <<= 1;
+    }
+
+    trace_event_t *ring = calloc(capacity, sizeof(*ring));
+    if (ring == NULL)
+    {
+        return -ENOMEM;
+    }
+
+    // Safe only once no recorder holds the old ring, see QSPI_Trace_Start() in the header
+    free(trace.ring);
+    trace.ring     = ring;
+    trace.capacity = capacity;
+    trace.hz       = cycles_calibrate();
+    atomic_store(&trace.head, 0);
+
+    qspi_trace_stall_cycles = trace.hz ? (uint64_t)((double)trace.hz * QSPI_TRACE_STALL_NS / 1e9) : UINT64_MAX;
+    trace.origin            = cycles_now();
+    atomic_store_explicit(&qspi_trace_enabled, 1, memory_order_release);
+    return 0;
+}
+
+void QSPI_Trace_Stop(void)
+{
+    atomic_store_explicit(&qspi_trace_enabled, 0, memory_order_release);
+}
+
+void QSPI_Trace_Free(void)
+{
+    QSPI_Trace_Stop();
+    free(trace.ring);
+    trace.ring     = NULL;
+    trace.capacity = 0;
+    atomic_store(&trace.head, 0);
+}
+
+/* Copies one slot, returns 0 when it is empty or was rewritten while copying */
+static int read_event(const trace_event_t *e, uint64_t n, trace_event_t *out)
+{
+    if (!seq_ring_read_begin(&e->seq, n))
+    {
+        return 0;
+    }
+
+    out->start = e->start;
+    out->end   = e->end;
+    out->tid   = e->tid;
+    out->opseq = e->opseq;
+    out->size  = e->size;
+    out->depth = e->depth;
+    out->arg   = e->arg;
+    out->type  = e->type;
+
+    return seq_ring_read_end(&e->seq, n);
+}
+
+/* Microseconds since the trace started, the unit of the trace-event format */
+static double to_us(uint64_t cycles)
+{
+    return trace.hz ? (double)(int64_t)(cycles - trace.origin) * 1e6 / (double)trace.hz : 0.0;
+}
+
+static void write_event(FILE *out, const trace_event_t *e, int pid)
+{
+    const char *sched = "";
+
+    switch ((qspi_trace_type_t)e->type)
+    {
+    case QSPI_TRACE_TRANSFER:
+        fprintf(out, "{\"name\":\"%s\",\"cat\":\"transfer\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u,"
+                     "\"args\":{\"seq\":%u,\"size\":%u,\"depth\":%u,\"result\":%d}}",
+                QSPI_Metrics_Name(QSPI_Metrics_Slot(e->opseq)), to_us(e->start), to_us(e->end) - to_us(e->start), pid, e->tid, e->opseq, e->size,
+                e->depth, e->arg);
+        return;
+    case QSPI_TRACE_STALL:
+        fprintf(out, "{\"name\":\"stall\",\"cat\":\"wait\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u,\"args\":{\"site\":\"%s\"}}",
+                to_us(e->start), to_us(e->end) - to_us(e->start), pid, e->tid, QSPI_Metrics_WaitName((qspi_wait_site_t)e->arg));
+        return;
+    case QSPI_TRACE_DEPTH:
+        fprintf(out, "{\"name\":\"queue_depth\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":%d,\"tid\":%u,\"args\":{\"depth\":%d}}", to_us(e->start), pid,
+                e->tid, e->arg);
+        return;
+    case QSPI_TRACE_DISPATCH:
+        sched = "dispatch";
+        break;
+    case QSPI_TRACE_DEFER_BUDGET:
+        sched = "defer_budget";
+        break;
+    case QSPI_TRACE_DEFER_DEADLINE:
+        sched = "defer_deadline";
+        break;
+    }
+
+    fprintf(out, "{\"name\":\"%s\",\"cat\":\"sched\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":%d,\"tid\":%u,"
+                 "\"args\":{\"class\":%d,\"seq\":%u,\"size\":%u,\"depth\":%u}}",
+            sched, to_us(e->start), pid, e->tid, e->arg, e->opseq, e->size, e->depth);
+}
+
+int QSPI_Trace_Write(FILE *out)
+{
+    uint64_t head  = atomic_load_explicit(&trace.head, memory_order_acquire);
+    uint64_t first = seq_ring_oldest(head, trace.capacity);
+    int      pid   = (int)getpid();
+
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"cycles_hz\":%llu,\"overwritten\":%llu},\"traceEvents\":[\n",
+            (unsigned long long)trace.hz, (unsigned long long)first);
+    fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"qspi\"}}", pid);
+
+    for (uint64_t n = first; n < head; n++)
+    {
+        trace_event_t e;
+        if (read_event(&trace.ring[n & (trace.capacity - 1)], n, &e))
+        {
+            fputs(",\n", out);
+            write_event(out, &e, pid);
+        }
+    }
+
+    fputs("\n]}\n", out);
+    return ferror(out) ? -1 : 0;
+}
+
+int QSPI_Trace_Save(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (file == NULL)
+    {
+        return -errno;
+    }
+
+    int ret = QSPI_Trace_Write(file) != 0 ? -EIO : 0;
+    if (fclose(file) != 0 && ret == 0)
+    {
+        ret = -errno;
+    }
+    return ret;
+}
@@ -0,0 +1,116 @@
+#ifndef QSPI_TRACE_H
+#define QSPI_TRACE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "cycles.h"
+
+/*
+ * Bus timeline in the Chrome trace-event format (chrome://tracing, Perfetto).
+ *
+ * While tracing is started, every transfer_blocking() call is stored with its
+ * opcode, size, result, thread and the scheduler queue depth, together with
+ * spin waits on INTR longer than QSPI_TRACE_STALL_NS and the scheduler's
+ * dispatch and defer decisions. Events go to a ring that keeps the newest
+ * ones (see seq_ring.h). When tracing is off each hook costs one acquire load.
+ */
+
+#define QSPI_TRACE_STALL_NS 1000 // Spin waits at least this long become events
+
+typedef enum
+{
+    QSPI_TRACE_TRANSFER,       // Complete event named after the opcode
+    QSPI_TRACE_STALL,          // Complete event, arg is the qspi_wait_site_t
+    QSPI_TRACE_DISPATCH,       // Instant event, arg is the scheduler class
+    QSPI_TRACE_DEFER_BUDGET,   // Instant event, arg is the scheduler class
+    QSPI_TRACE_DEFER_DEADLINE, // Instant event, arg is the scheduler class
+    QSPI_TRACE_DEPTH,          // Counter event of the scheduler queue depth
+} qspi_trace_type_t;
+
+extern _Atomic int      qspi_trace_enabled;
+extern _Atomic uint32_t qspi_trace_depth;
+extern uint64_t         qspi_trace_stall_cycles;
+
+/**
+ * @brief Stores one event. Use the wrappers below, they skip it when tracing is off.
+ */
+void QSPI_Trace_Record(qspi_trace_type_t type, uint64_t start, uint64_t end, uint32_t seq, uint32_t size, int32_t arg);
+
+/* Acquire pairs with the release in QSPI_Trace_Start(), a hook that sees tracing on sees the ring */
+static inline int QSPI_Trace_Enabled(void)
+{
+    return atomic_load_explicit(&qspi_trace_enabled, memory_order_acquire);
+}
+
+static inline void QSPI_Trace_Transfer(uint32_t seq, uint32_t size, int result, uint64_t start, uint64_t end)
+{
+    if (QSPI_Trace_Enabled())
+    {
+        QSPI_Trace_Record(QSPI_TRACE_TRANSFER, start, end, seq, size, result);
+    }
+}
+
+static inline void QSPI_Trace_Stall(int site, uint64_t start, uint64_t end)
+{
+    if (QSPI_Trace_Enabled() && end - start >= qspi_trace_stall_cycles)
+    {
+        QSPI_Trace_Record(QSPI_TRACE_STALL, start, end, 0, 0, site);
+    }
+}
+
+static inline void QSPI_Trace_Sched(qspi_trace_type_t type, int cls, uint32_t seq, uint32_t size)
+{
+    if (QSPI_Trace_Enabled())
+    {
+        uint64_t now = cycles_now();
+        QSPI_Trace_Record(type, now, now, seq, size, cls);
+    }
+}
+
+/* Tracks the scheduler queue depth, a counter event is stored while tracing */
+static inline void QSPI_Trace_Depth(size_t depth)
+{
+    atomic_store_explicit(&qspi_trace_depth, (uint32_t)depth, memory_order_relaxed);
+    if (QSPI_Trace_Enabled())
+    {
+        uint64_t now = cycles_now();
+        QSPI_Trace_Record(QSPI_TRACE_DEPTH, now, now, 0, 0, (int32_t)depth);
+    }
+}
+
+/**
+ * @brief Allocates a ring of at least events entries and starts tracing.
+ *
+ * Events of a previous run are discarded and its ring is freed, so as with
+ * QSPI_Trace_Free() a restart must wait until no transfer started before the
+ * QSPI_Trace_Stop() is still recording.
+ *
+ * @return 0 on success, -ENOMEM, or -EBUSY when tracing is already running.
+ */
+int QSPI_Trace_Start(size_t events);
+
+void QSPI_Trace_Stop(void);
+
+/**
+ * @brief Writes the recorded events as a Chrome trace-event JSON object, oldest first.
+ *
+ * @return 0 on success, -1 on a write error.
+ */
+int QSPI_Trace_Write(FILE *out);
+
+/**
+ * @brief QSPI_Trace_Write() to a file.
+ *
+ * @return 0 on success, -errno otherwise.
+ */
+int QSPI_Trace_Save(const char *path);
+
+/**
+ * @brief Releases the ring. Call after QSPI_Trace_Stop() once no transfer is running.
+ */
+void QSPI_Trace_Free(void);
+
+#endif // QSPI_TRACE_H
@@ -0,0 +1,55 @@
+#ifndef SEQ_RING_H
+#define SEQ_RING_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+/*
+ * Slot protocol of the lock-free rings that keep the newest entries (the
+ * register recorder and the bus trace).
+ *
+ * Entry n goes to slot n modulo the power-of-two capacity. Its writer marks
+ * the slot's seq 0 while filling it and publishes n + 1 afterwards. A reader
+ * keeps its copy only when seq was n + 1 both before and after copying, so a
+ * slot that is being written or was overwritten meanwhile is skipped.
+ */
+
+/* Number of the next entry, callers then open its slot */
+static inline uint64_t seq_ring_claim(_Atomic uint64_t *head)
+{
+    return atomic_fetch_add_explicit(head, 1, memory_order_relaxed);
+}
+
+/* Marks the slot as being written, before its fields are stored */
+static inline void seq_ring_open(_Atomic uint64_t *seq)
+{
+    atomic_store_explicit(seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+/* Makes entry n in the slot visible to readers */
+static inline void seq_ring_publish(_Atomic uint64_t *seq, uint64_t n)
+{
+    atomic_store_explicit(seq, n + 1, memory_order_release);
+}
+
+/* Oldest entry number still in a ring of capacity slots whose head was read as head */
+static inline uint64_t seq_ring_oldest(uint64_t head, uint64_t capacity)
+{
+    return head > capacity ? head - capacity : 0;
+}
+
+/* Before copying: 0 when the slot does not hold entry n */
+static inline int seq_ring_read_begin(const _Atomic uint64_t *seq, uint64_t n)
+{
+    return atomic_load_explicit(seq, memory_order_acquire) == n + 1;
+}
+
+/* After copying: 0 when entry n was overwritten while it was copied */
+static inline int seq_ring_read_end(const _Atomic uint64_t *seq, uint64_t n)
+{
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(seq, memory_order_relaxed) == n + 1;
+}
+
+#endif // SEQ_RING_H
@@ -34,6 +34,7 @@
 #include <errno.h>
 #include <time.h>
 #include "slog.h"
+#include "slog_bin.h"
 
 #ifdef __linux__
 #include <syscall.h>
@@ -41,8 +42,13 @@
 
 #ifndef _WIN32
 #include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdatomic.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 #else
 #include <windows.h>
 #endif
@@ -53,6 +59,13 @@
 
 #define SLOG_FILE_PATH_MAX SLOG_PATH_MAX + SLOG_NAME_MAX + SLOG_DATE_MAX
 #define SLOG_ASSERT_RET(x) if (!(x)) return
+#define SLOG_TAGS_MAX 8
+
+#ifdef _WIN32
+#define SLOG_THREAD_LOCAL __declspec(thread)
+#else
+#define SLOG_THREAD_LOCAL _Thread_local
+#endif
 
 typedef struct slog_file {
     char sFilePath[SLOG_FILE_PATH_MAX];
@@ -69,8 +82,50 @@ typedef struct slog {
     slog_config_t config;
     slog_file_t logFile;
     uint8_t nTdSafe;
+
+    /* Tags rendered for the current color and indent settings, by flag bit */
+    char sTags[SLOG_TAGS_MAX][SLOG_TAG_MAX];
+    uint8_t nTagLengths[SLOG_TAGS_MAX];
 } slog_t;
 
+/* Per thread copies of the parts of the info prefix that rarely change */
+typedef struct slog_prefix_cache {
+    slog_date_t date;                   // Date rendered into sDate, nUsec unused
+    slog_date_ctrl_t eDateControl;
+    char sDate[SLOG_DATE_MAX];          // Date up to and including the seconds dot
+    size_t nDateLength;
+
+    time_t nSec;                        // Second converted into tmInfo
+    struct tm tmInfo;
+
+    uint32_t nTidEpoch;                 // g_nTidEpoch when sTid was rendered
+    char sTid[SLOG_TAG_MAX];
+    size_t nTidLength;
+} slog_prefix_cache_t;
+
+static SLOG_THREAD_LOCAL slog_prefix_cache_t g_prefix;
+
+/* Per thread buffer the synchronous path renders lines into */
+typedef struct slog_line_buffer {
+    char *pData;
+    size_t nSize;
+} slog_line_buffer_t;
+
+#define SLOG_LINE_INITIAL (SLOG_INFO_MAX + SLOG_NAME_MAX + SLOG_MESSAGE_MAX)
+
+static SLOG_THREAD_LOCAL slog_line_buffer_t g_line;
+
+#ifndef _WIN32
+/* Frees the line buffer of exiting threads */
+static pthread_key_t g_lineKey;
+static pthread_once_t g_lineKeyOnce = PTHREAD_ONCE_INIT;
+
+static void slog_create_line_key(void)
+{
+    pthread_key_create(&g_lineKey, free);
+}
+#endif
+
 typedef struct slog_context {
     const char *pFormat;
     slog_flag_t eFlag;
@@ -78,12 +133,124 @@ typedef struct slog_context {
     uint8_t nNewLine;
 } slog_context_t;
 
+#ifndef _WIN32
+#define SLOG_STAGES_MAX 32
+
+typedef struct slog_record {
+    uint64_t nTime;                 // CLOCK_REALTIME ns of date, the writer merges the stages by it
+    slog_flag_t eFlag;
+    slog_date_t date;
+    size_t nLength;
+    char sLine[SLOG_ASYNC_LINE_MAX];
+} slog_record_t;
+
+typedef enum {
+    SLOG_STAGE_FREE = 0,
+    SLOG_STAGE_CLAIMED,             // Being set up by its new thread
+    SLOG_STAGE_ACTIVE,
+    SLOG_STAGE_EXITED               // Thread is gone, released once drained
+} slog_stage_state_t;
+
+/* Records of one logging thread, single producer and single consumer */
+typedef struct slog_stage {
+    slog_record_t *pRecords;
+    atomic_size_t nHead;            // Next record to write, writer thread only
+    atomic_size_t nTail;            // Next record to fill, owner thread only
+    atomic_size_t nDropped;         // Records lost because the stage was full
+    atomic_uint_least64_t nStamp;   // nTime of the record being filled, 0 when idle
+    atomic_int nState;
+    uint32_t nGen;
+} slog_stage_t;
+
+typedef struct slog_async {
+    slog_stage_t stages[SLOG_STAGES_MAX];
+    atomic_int nStages;             // Slots ever claimed, bounds the writer's scan
+    atomic_uint nGen;               // Bumped on start, invalidates cached stages
+    size_t nCapacity;               // Records per stage, power of two
+    atomic_int nActive;             // Producers currently inside a stage
+    atomic_int nPaused;             // Config changes in progress, producers go synchronous
+    atomic_int nRunning;
+    atomic_int nStop;
+    pthread_t thread;
+    sem_t sem;
+} slog_async_t;
+
+static slog_async_t g_async;
+
+/* nStamp of a push that has not read the clock yet, older than any record */
+#define SLOG_STAMP_PENDING 1
+
+/* The calling thread's stage, valid while nGen matches g_async.nGen */
+typedef struct slog_stage_ref {
+    slog_stage_t *pStage;
+    uint32_t nGen;
+} slog_stage_ref_t;
+
+static SLOG_THREAD_LOCAL slog_stage_ref_t g_stageRef;
+static pthread_key_t g_stageKey;
+static pthread_once_t g_stageKeyOnce = PTHREAD_ONCE_INIT;
+
+typedef struct slog_binary {
+    pthread_mutex_t mutex;
+    FILE *pHandle;
+    char *pBuffer;                      // stdio buffer, records reach the file in large writes
+    uint32_t nNextId;
+    char *pFormats[SLOG_BIN_FORMATS_MAX];   // Copies, a format may live in a reused buffer
+    uint32_t nHashes[SLOG_BIN_FORMATS_MAX];
+    uint32_t nIds[SLOG_BIN_FORMATS_MAX];
+} slog_binary_t;
+
+static slog_binary_t g_binary = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+
+typedef struct slog_sink {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_t thread;
+    char *pActive;                      // Filled by the logging threads
+    char *pSpare;                       // NULL while the writer thread owns it
+    char *pPending;                     // Full buffer waiting for the writer thread
+    size_t nActive;
+    size_t nPending;
+    size_t nSize;
+    uint32_t nFlushMs;
+    int nFd;
+    uint8_t nCurrDay;                   // Day of sPath, 0 until a file was requested
+    uint8_t nReopen;                    // sPath changed, the writer thread opens it
+    uint8_t nStop;
+    atomic_int nRunning;
+    char sPath[SLOG_FILE_PATH_MAX];
+} slog_sink_t;
+
+static slog_sink_t g_sink = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .nFd = -1
+};
+#endif
+
+/* Levels recorded in binary form instead of text */
+static volatile uint16_t g_nSlogBinFlags = 0;
+
 static volatile int g_nHaveSlogVerShort = 0;
 static volatile int g_nHaveSlogVerLong = 0;
 static char g_slogVerShort[128];
 static char g_slogVerLong[256];
 
 static slog_t g_slog;
+SLOG_ATOMIC(uint16_t) g_nSlogFlags = 0;
+
+/* Bumped in forked children, thread ids cached before the fork are stale there */
+static volatile uint32_t g_nTidEpoch = 1;
+
+static void slog_update_tags(slog_t *pSlog);
+
+/* Must be called with the lock held after any change of the configuration */
+static void slog_update_flags(const slog_config_t *pCfg)
+{
+    uint8_t nOutput = pCfg->logCallback || pCfg->nToScreen || pCfg->nToFile;
+    SLOG_ATOMIC_STORE(g_nSlogFlags, (uint16_t)((nOutput ? pCfg->nFlags : 0) | g_nSlogBinFlags));
+    slog_update_tags(&g_slog);
+}
 
 static void slog_sync_init(slog_t *pSlog)
 {
@@ -261,15 +428,19 @@ static void slog_close_file(slog_file_t *pFile)
     }
 }
 
-static uint8_t slog_open_file(slog_file_t *pFile, const slog_config_t *pCfg, const slog_date_t *pDate)
+static void slog_update_file_path(slog_file_t *pFile, const slog_config_t *pCfg, const slog_date_t *pDate)
 {
-    slog_close_file(pFile);
-
     if (pCfg->nRotate || pFile->sFilePath[0] == SLOG_NUL)
     {
         snprintf(pFile->sFilePath, sizeof(pFile->sFilePath), "%s/%s-%04d-%02d-%02d.log",
             pCfg->sFilePath, pCfg->sFileName, pDate->nYear, pDate->nMonth, pDate->nDay);
     }
+}
+
+static uint8_t slog_open_file(slog_file_t *pFile, const slog_config_t *pCfg, const slog_date_t *pDate)
+{
+    slog_close_file(pFile);
+    slog_update_file_path(pFile, pCfg, pDate);
 
 #ifdef _WIN32
     if (fopen_s(&pFile->pHandle, pFile->sFilePath, "a")) pFile->pHandle = NULL;
@@ -319,21 +490,32 @@ void slog_get_date(slog_date_t *pDate)
     pDate->nUsec = (uint16_t)((uli.QuadPart / 10) % 1000);
 }
 #else
+static void slog_date_from_time(slog_date_t *pDate, time_t nSec, long nUsec)
+{
+    slog_prefix_cache_t *pCache = &g_prefix;
+    struct tm *pTm = &pCache->tmInfo;
+
+    /* localtime_r() takes the tz lock and may stat the zone file, once a second is enough */
+    if (nSec != pCache->nSec || pTm->tm_mday == 0)
+    {
+        localtime_r(&nSec, pTm);
+        pCache->nSec = nSec;
+    }
+
+    pDate->nYear = pTm->tm_year + 1900;
+    pDate->nMonth = pTm->tm_mon + 1;
+    pDate->nDay = pTm->tm_mday;
+    pDate->nHour = pTm->tm_hour;
+    pDate->nMin = pTm->tm_min;
+    pDate->nSec = pTm->tm_sec;
+    pDate->nUsec = (uint16_t)(nUsec / 1000);
+}
+
 void slog_get_date(slog_date_t *pDate)
 {
     struct timeval tv;
-    struct tm tm_info;
-
     gettimeofday(&tv, NULL);
-    localtime_r(&tv.tv_sec, &tm_info);
-
-    pDate->nYear = tm_info.tm_year + 1900;
-    pDate->nMonth = tm_info.tm_mon + 1;
-    pDate->nDay = tm_info.tm_mday;
-    pDate->nHour = tm_info.tm_hour;
-    pDate->nMin = tm_info.tm_min;
-    pDate->nSec = tm_info.tm_sec;
-    pDate->nUsec = (uint16_t)(tv.tv_usec / 1000);
+    slog_date_from_time(pDate, tv.tv_sec, (long)tv.tv_usec);
 }
 #endif
 
@@ -366,265 +548,1420 @@ static void slog_create_tag(char *pOut, size_t nSize, slog_flag_t eFlag, const c
     else snprintf(pOut, nSize, "%s<%s>%s%s", pColor, pTag, SLOG_COLOR_RESET, pIndent);
 }
 
-static void slog_create_tid(char *pOut, int nSize, uint8_t nTraceTid)
+#ifndef _WIN32
+static void slog_fork_child(void)
 {
-    if (!nTraceTid) pOut[0] = SLOG_NUL;
-    else snprintf(pOut, nSize, "(%zu) ", slog_get_tid());
+    g_nTidEpoch++;
 }
 
-static void slog_display_message(const slog_context_t *pCtx, const char *pInfo, int nInfoLen, const char *pInput)
+static void slog_register_atfork(void)
 {
-    slog_config_t *pCfg = &g_slog.config;
-    slog_file_t *pFile = &g_slog.logFile;
-    int nCbVal = 1;
+    pthread_atfork(NULL, NULL, slog_fork_child);
+}
+#endif
 
-    uint8_t nFullColor = pCfg->eColorFormat == SLOG_COLORING_FULL ? 1 : 0;
-    const char *pSeparator = nInfoLen > 0 ? pCfg->sSeparator : SLOG_EMPTY;
-    const char *pNewLine = pCtx->nNewLine ? SLOG_NEWLINE : SLOG_EMPTY;
-    const char *pMessage = pInput != NULL ? pInput : SLOG_EMPTY;
-    const char *pReset = nFullColor ? SLOG_COLOR_RESET : SLOG_EMPTY;
+/* Thread id text, rendered once per thread */
+static const char *slog_create_tid(size_t *pLength)
+{
+    slog_prefix_cache_t *pCache = &g_prefix;
 
-    if (pCfg->logCallback != NULL)
+    if (pCache->nTidEpoch != g_nTidEpoch)
     {
-        int nLength = 0;
-        char *pLog = NULL;
+        int nLength = snprintf(pCache->sTid, sizeof(pCache->sTid), "(%zu) ", slog_get_tid());
+        pCache->nTidLength = nLength > 0 ? (size_t)nLength : 0;
+        pCache->nTidEpoch = g_nTidEpoch;
+    }
 
-#ifdef _WIN32
-        nLength = slog_asprintf(&pLog, "%s%s%s%s%s", pInfo,
-            pSeparator, pMessage, pReset, pNewLine);
-#else
-        nLength = asprintf(&pLog, "%s%s%s%s%s", pInfo,
-            pSeparator, pMessage, pReset, pNewLine);
-#endif
+    *pLength = pCache->nTidLength;
+    return pCache->sTid;
+}
 
-        if (pLog != NULL && nLength > 0)
-        {
-            nCbVal = pCfg->logCallback (
-                pLog,
-                (size_t)nLength,
-                pCtx->eFlag,
-                pCfg->pCallbackCtx
-            );
-
-            free(pLog);
-        }
+static int slog_get_tag_index(slog_flag_t eFlag)
+{
+    for (int i = 0; i < SLOG_TAGS_MAX; i++)
+        if ((uint16_t)eFlag == (1 << i)) return i;
+
+    return -1;
+}
+
+static void slog_update_tags(slog_t *pSlog)
+{
+    for (int i = 0; i < SLOG_TAGS_MAX; i++)
+    {
+        slog_flag_t eFlag = (slog_flag_t)(1 << i);
+        const char *pColor = slog_get_color(eFlag);
+
+        slog_create_tag(pSlog->sTags[i], sizeof(pSlog->sTags[i]), eFlag, pColor);
+        pSlog->nTagLengths[i] = (uint8_t)strlen(pSlog->sTags[i]);
     }
+}
 
-    if (pCfg->nToScreen && nCbVal > 0)
+/* Date text up to the milliseconds, rendered again only when the second changes */
+static const char *slog_create_date(const slog_date_t *pDate, slog_date_ctrl_t eDateControl, size_t *pLength)
+{
+    slog_prefix_cache_t *pCache = &g_prefix;
+    const slog_date_t *pLast = &pCache->date;
+
+    if (pCache->eDateControl != eDateControl ||
+        pLast->nSec != pDate->nSec ||
+        pLast->nMin != pDate->nMin ||
+        pLast->nHour != pDate->nHour ||
+        pLast->nDay != pDate->nDay ||
+        pLast->nMonth != pDate->nMonth ||
+        pLast->nYear != pDate->nYear)
     {
-        printf("%s%s%s%s%s", pInfo, pSeparator, pMessage, pReset, pNewLine);
-        if (pCfg->nFlush) fflush(stdout);
+        int nLength = 0;
+
+        if (eDateControl == SLOG_TIME_ONLY)
+        {
+            nLength = snprintf(pCache->sDate, sizeof(pCache->sDate), "%02d:%02d:%02d.",
+                pDate->nHour, pDate->nMin, pDate->nSec);
+        }
+        else if (eDateControl == SLOG_DATE_FULL)
+        {
+            nLength = snprintf(pCache->sDate, sizeof(pCache->sDate), "%04d.%02d.%02d-%02d:%02d:%02d.",
+                pDate->nYear, pDate->nMonth, pDate->nDay, pDate->nHour,
+                pDate->nMin, pDate->nSec);
+        }
+
+        pCache->nDateLength = nLength > 0 ? (size_t)nLength : 0;
+        pCache->eDateControl = eDateControl;
+        pCache->date = *pDate;
     }
 
-    if (!pCfg->nToFile || nCbVal < 0) return;
-    const slog_date_t *pDate = &pCtx->date;
+    *pLength = pCache->nDateLength;
+    return pCache->sDate;
+}
+
+static size_t slog_put(char *pOut, size_t nSize, size_t nLength, const char *pStr, size_t nStrLen)
+{
+    if (nLength + nStrLen >= nSize) nStrLen = nLength + 1 < nSize ? nSize - nLength - 1 : 0;
+    memcpy(pOut + nLength, pStr, nStrLen);
+    return nLength + nStrLen;
+}
+
+static FILE *slog_acquire_file(const slog_date_t *pDate)
+{
+    slog_config_t *pCfg = &g_slog.config;
+    slog_file_t *pFile = &g_slog.logFile;
 
     if (pFile->nCurrDay != pDate->nDay && pCfg->nRotate) slog_close_file(pFile);
-    if (pFile->pHandle == NULL && !slog_open_file(pFile, pCfg, pDate)) return;
+    if (pFile->pHandle == NULL && !slog_open_file(pFile, pCfg, pDate)) return NULL;
+
+    return pFile->pHandle;
+}
 
-    fprintf(pFile->pHandle, "%s%s%s%s%s", pInfo,
-        pSeparator, pMessage, pReset, pNewLine);
+static void slog_release_file(void)
+{
+    slog_config_t *pCfg = &g_slog.config;
+    slog_file_t *pFile = &g_slog.logFile;
 
     if (pCfg->nFlush) fflush(pFile->pHandle);
     if (!pCfg->nKeepOpen) slog_close_file(pFile);
 }
 
-static int slog_create_info(const slog_context_t *pCtx, char* pOut, size_t nSize)
+#ifndef _WIN32
+static void slog_sink_write(int nFd, const char *pData, size_t nLength)
+{
+    while (nFd >= 0 && nLength > 0)
+    {
+        ssize_t nWritten = write(nFd, pData, nLength);
+        if (nWritten < 0 && errno == EINTR) continue;
+        if (nWritten <= 0) break;
+
+        pData += nWritten;
+        nLength -= (size_t)nWritten;
+    }
+}
+
+/* Hands the active buffer to the writer thread, waits while it still owns the spare one */
+static void slog_sink_handoff(slog_sink_t *pSink)
+{
+    if (!pSink->nActive) return;
+    while (pSink->pSpare == NULL) pthread_cond_wait(&pSink->cond, &pSink->mutex);
+
+    pSink->pPending = pSink->pActive;
+    pSink->nPending = pSink->nActive;
+    pSink->pActive = pSink->pSpare;
+    pSink->pSpare = NULL;
+    pSink->nActive = 0;
+
+    pthread_cond_broadcast(&pSink->cond);
+}
+
+/* Copies a line into the sink buffer, the file is opened and written by the writer thread */
+static uint8_t slog_sink_append(const slog_date_t *pDate, slog_flag_t eFlag, const struct iovec *pParts, size_t nParts)
 {
+    slog_sink_t *pSink = &g_sink;
     slog_config_t *pCfg = &g_slog.config;
-    const slog_date_t *pDate = &pCtx->date;
+    slog_file_t *pFile = &g_slog.logFile;
 
-    char sDate[SLOG_DATE_MAX + SLOG_NAME_MAX];
-    sDate[0] = SLOG_NUL;
+    if (!atomic_load_explicit(&pSink->nRunning, memory_order_relaxed)) return 0;
+    pthread_mutex_lock(&pSink->mutex);
 
-    if (pCfg->eDateControl == SLOG_TIME_ONLY)
+    /* Lines buffered so far belong to the previous file, they are handed off first */
+    if (!pSink->nCurrDay || (pCfg->nRotate && pSink->nCurrDay != pDate->nDay))
     {
-        snprintf(sDate, sizeof(sDate), "%02d:%02d:%02d.%03d ",
-            pDate->nHour, pDate->nMin, pDate->nSec, pDate->nUsec);
+        slog_sink_handoff(pSink);
+        slog_update_file_path(pFile, pCfg, pDate);
+        snprintf(pSink->sPath, sizeof(pSink->sPath), "%s", pFile->sFilePath);
+        pSink->nCurrDay = pDate->nDay;
+        pSink->nReopen = 1;
+        pthread_cond_broadcast(&pSink->cond);
     }
-    else if (pCfg->eDateControl == SLOG_DATE_FULL)
+
+    for (size_t i = 0; i < nParts; i++)
     {
-        snprintf(sDate, sizeof(sDate), "%04d.%02d.%02d-%02d:%02d:%02d.%03d ",
-            pDate->nYear, pDate->nMonth, pDate->nDay, pDate->nHour,
-            pDate->nMin, pDate->nSec, pDate->nUsec);
+        const char *pData = (const char*)pParts[i].iov_base;
+        size_t nLeft = pParts[i].iov_len;
+        if (pSink->nActive + nLeft > pSink->nSize) slog_sink_handoff(pSink);
+
+        /* A line longer than the buffer goes out in buffer sized pieces, in order */
+        while (nLeft)
+        {
+            if (pSink->nActive == pSink->nSize) slog_sink_handoff(pSink);
+
+            size_t nLength = pSink->nSize - pSink->nActive;
+            if (nLength > nLeft) nLength = nLeft;
+
+            memcpy(pSink->pActive + pSink->nActive, pData, nLength);
+            pSink->nActive += nLength;
+            pData += nLength;
+            nLeft -= nLength;
+        }
     }
 
-    char sTid[SLOG_TAG_MAX], sTag[SLOG_TAG_MAX];
-    uint8_t nFullColor = pCfg->eColorFormat == SLOG_COLORING_FULL ? 1 : 0;
+    if (pCfg->nFlush || eFlag == SLOG_FATAL) slog_sink_handoff(pSink);
 
-    const char *pColorCode = slog_get_color(pCtx->eFlag);
-    const char *pColor = nFullColor ? pColorCode : SLOG_EMPTY;
+    /* The process may not survive a fatal message, wait until it reached the file */
+    if (eFlag == SLOG_FATAL)
+    {
+        while (pSink->pSpare == NULL) pthread_cond_wait(&pSink->cond, &pSink->mutex);
+    }
 
-    slog_create_tid(sTid, sizeof(sTid), pCfg->nTraceTid);
-    slog_create_tag(sTag, sizeof(sTag), pCtx->eFlag, pColorCode);
-    return snprintf(pOut, nSize, "%s%s%s%s", pColor, sTid, sDate, sTag);
+    pthread_mutex_unlock(&pSink->mutex);
+    return 1;
 }
 
-static void slog_display_heap(const slog_context_t *pCtx, va_list args)
+static void slog_sink_reopen(slog_sink_t *pSink)
 {
-    int nBytes = 0;
-    char *pMessage = NULL;
-    char sLogInfo[SLOG_INFO_MAX];
-
-#ifdef _WIN32
-    nBytes = slog_vasprintf(&pMessage, pCtx->pFormat, args);
-#else
-    nBytes = vasprintf(&pMessage, pCtx->pFormat, args);
-#endif
+    char sPath[SLOG_FILE_PATH_MAX];
+    memcpy(sPath, pSink->sPath, sizeof(sPath));
+    pSink->nReopen = 0;
 
-    va_end(args);
-    (void)nBytes;
+    pthread_mutex_unlock(&pSink->mutex);
+    int nFd = open(sPath, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    int nError = errno;
+    pthread_mutex_lock(&pSink->mutex);
 
-    if (pMessage == NULL)
+    if (nFd < 0)
     {
-        printf("<%s:%d> %s<error>%s %s: Can not allocate memory for input: errno(%d)\n", 
-            __FILE__, __LINE__, SLOG_COLOR_RED, SLOG_COLOR_RESET, __func__, errno);
+        printf("<%s:%d> %s: [ERROR] Failed to open file: %s (%s)\n",
+            __FILE__, __LINE__, __func__, sPath, strerror(nError));
 
         return;
     }
 
-    int nLength = slog_create_info(pCtx, sLogInfo, sizeof(sLogInfo));
-    slog_display_message(pCtx, sLogInfo, nLength, pMessage);
-    if (pMessage != NULL) free(pMessage);
-}
+    /* The pending buffer was handed off with the reopen request, it holds the older lines */
+    int nOldFd = pSink->nFd;
+    char *pOld = pSink->pPending;
+    size_t nOld = pSink->nPending;
 
-static void slog_display_stack(const slog_context_t *pCtx, va_list args)
-{
-    char sMessage[SLOG_MESSAGE_MAX];
-    char sLogInfo[SLOG_INFO_MAX];
+    pSink->nFd = nFd;
+    pSink->pPending = NULL;
 
-    vsnprintf(sMessage, sizeof(sMessage), pCtx->pFormat, args);
-    int nLength = slog_create_info(pCtx, sLogInfo, sizeof(sLogInfo));
-    slog_display_message(pCtx, sLogInfo, nLength, sMessage);
+    pthread_mutex_unlock(&pSink->mutex);
+    if (pOld != NULL) slog_sink_write(nOldFd >= 0 ? nOldFd : nFd, pOld, nOld);
+    if (nOldFd >= 0) close(nOldFd);
+    pthread_mutex_lock(&pSink->mutex);
+
+    if (pOld != NULL)
+    {
+        pSink->pSpare = pOld;
+        pthread_cond_broadcast(&pSink->cond);
+    }
 }
 
-void slog_display(slog_flag_t eFlag, uint8_t nNewLine, const char *pFormat, ...)
+static void *slog_sink_worker(void *pArg)
 {
-    slog_sync_lock(&g_slog);
-    slog_config_t *pCfg = &g_slog.config;
+    slog_sink_t *pSink = (slog_sink_t*)pArg;
+    pthread_mutex_lock(&pSink->mutex);
 
-    if ((SLOG_FLAGS_CHECK(g_slog.config.nFlags, eFlag)) &&
-        (g_slog.config.logCallback ||
-         g_slog.config.nToScreen ||
-         g_slog.config.nToFile))
+    for (;;)
     {
-        slog_context_t ctx;
-        slog_get_date(&ctx.date);
+        /* Reopen first, the pending buffer then goes to the file it belongs to */
+        if (pSink->nReopen)
+        {
+            slog_sink_reopen(pSink);
+            continue;
+        }
 
-        ctx.eFlag = eFlag;
-        ctx.pFormat = pFormat;
-        ctx.nNewLine = nNewLine;
+        if (pSink->pPending != NULL)
+        {
+            char *pData = pSink->pPending;
+            size_t nLength = pSink->nPending;
+            int nFd = pSink->nFd;
+            pSink->pPending = NULL;
+
+            pthread_mutex_unlock(&pSink->mutex);
+            slog_sink_write(nFd, pData, nLength);
+            pthread_mutex_lock(&pSink->mutex);
+
+            pSink->pSpare = pData;
+            pthread_cond_broadcast(&pSink->cond);
+            continue;
+        }
 
-        void(*slog_display_args)(const slog_context_t *pCtx, va_list args);
-        slog_display_args = pCfg->nUseHeap ? slog_display_heap : slog_display_stack;
+        if (pSink->nStop) break;
 
-        va_list args;
-        va_start(args, pFormat);
-        slog_display_args(&ctx, args);
-        va_end(args);
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += pSink->nFlushMs / 1000;
+        deadline.tv_nsec += (long)(pSink->nFlushMs % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_nsec -= 1000000000L;
+            deadline.tv_sec++;
+        }
+
+        /* With no buffer pending the spare one is free, the handoff never waits here */
+        if (pthread_cond_timedwait(&pSink->cond, &pSink->mutex, &deadline) == ETIMEDOUT &&
+            pSink->pPending == NULL) slog_sink_handoff(pSink);
     }
 
-    slog_sync_unlock(&g_slog);
+    slog_sink_write(pSink->nFd, pSink->pActive, pSink->nActive);
+    pSink->nActive = 0;
+
+    if (pSink->nFd >= 0) close(pSink->nFd);
+    pSink->nFd = -1;
+
+    pthread_mutex_unlock(&pSink->mutex);
+    return NULL;
 }
+#endif
 
-const char* slog_version(uint8_t nShort)
+/* Output of a fully rendered line to the callback, screen and file */
+static void slog_display_line(const slog_context_t *pCtx, const char *pLine, size_t nLength)
 {
-    if (nShort)
-    {
-        if (!g_nHaveSlogVerShort)
-        {
-            snprintf(g_slogVerShort, sizeof(g_slogVerShort), "%d.%d.%d",
-                SLOG_VERSION_MAJOR, SLOG_VERSION_MINOR, SLOG_BUILD_NUMBER);
-
-            g_nHaveSlogVerShort = 1;
-        }
+    slog_config_t *pCfg = &g_slog.config;
+    int nCbVal = 1;
 
-        return g_slogVerShort;
+    if (pCfg->logCallback != NULL)
+    {
+        nCbVal = pCfg->logCallback(pLine, nLength,
+            pCtx->eFlag, pCfg->pCallbackCtx);
     }
 
-    if (!g_nHaveSlogVerLong)
+    if (pCfg->nToScreen && nCbVal > 0)
     {
-        snprintf(g_slogVerLong, sizeof(g_slogVerLong), "%d.%d build %d (%s)",
-        SLOG_VERSION_MAJOR, SLOG_VERSION_MINOR, SLOG_BUILD_NUMBER, __DATE__);
-
-        g_nHaveSlogVerLong = 1;
+        fwrite(pLine, 1, nLength, stdout);
+        if (pCfg->nFlush) fflush(stdout);
     }
 
-    return g_slogVerLong;
-}
+    if (!pCfg->nToFile || nCbVal < 0) return;
 
-void slog_config_get(slog_config_t *pCfg)
-{
-    slog_sync_lock(&g_slog);
-    *pCfg = g_slog.config;
-    slog_sync_unlock(&g_slog);
+#ifndef _WIN32
+    struct iovec part = { (void*)pLine, nLength };
+    if (slog_sink_append(&pCtx->date, pCtx->eFlag, &part, 1)) return;
+#endif
+
+    FILE *pHandle = slog_acquire_file(&pCtx->date);
+    if (pHandle == NULL) return;
+
+    fwrite(pLine, 1, nLength, pHandle);
+    slog_release_file();
 }
 
-void slog_config_set(slog_config_t *pCfg)
+static int slog_create_info(const slog_context_t *pCtx, char* pOut, size_t nSize)
 {
-    slog_sync_lock(&g_slog);
-    slog_config_t *pOldCfg = &g_slog.config;
-    slog_file_t *pFile = &g_slog.logFile;
+    slog_config_t *pCfg = &g_slog.config;
+    const slog_date_t *pDate = &pCtx->date;
+    size_t nLength = 0;
 
-    if (!pCfg->nToFile ||
-        strncmp(pOldCfg->sFilePath, pCfg->sFilePath, sizeof(pOldCfg->sFilePath)) ||
-        strncmp(pOldCfg->sFileName, pCfg->sFileName, sizeof(pOldCfg->sFileName)))
+    if (!nSize) return 0;
+
+    if (pCfg->eColorFormat == SLOG_COLORING_FULL)
     {
-        slog_close_file(pFile); /* Log function will open it again if required */
-        pFile->sFilePath[0] = SLOG_NUL;
+        const char *pColor = slog_get_color(pCtx->eFlag);
+        nLength = slog_put(pOut, nSize, nLength, pColor, strlen(pColor));
     }
 
-    g_slog.config = *pCfg;
-    slog_sync_unlock(&g_slog);
+    if (pCfg->nTraceTid)
+    {
+        size_t nTidLen = 0;
+        const char *pTid = slog_create_tid(&nTidLen);
+        nLength = slog_put(pOut, nSize, nLength, pTid, nTidLen);
+    }
+
+    if (pCfg->eDateControl == SLOG_TIME_ONLY || pCfg->eDateControl == SLOG_DATE_FULL)
+    {
+        size_t nDateLen = 0;
+        const char *pDateStr = slog_create_date(pDate, pCfg->eDateControl, &nDateLen);
+        nLength = slog_put(pOut, nSize, nLength, pDateStr, nDateLen);
+
+        char sMsec[5];
+        uint16_t nMsec = pDate->nUsec % 1000;
+        sMsec[0] = (char)('0' + nMsec / 100);
+        sMsec[1] = (char)('0' + nMsec / 10 % 10);
+        sMsec[2] = (char)('0' + nMsec % 10);
+        sMsec[3] = ' ';
+        nLength = slog_put(pOut, nSize, nLength, sMsec, 4);
+    }
+
+    int nTag = slog_get_tag_index(pCtx->eFlag);
+    if (nTag >= 0)
+    {
+        nLength = slog_put(pOut, nSize, nLength, g_slog.sTags[nTag], g_slog.nTagLengths[nTag]);
+    }
+    else
+    {
+        char sTag[SLOG_TAG_MAX];
+        slog_create_tag(sTag, sizeof(sTag), pCtx->eFlag, slog_get_color(pCtx->eFlag));
+        nLength = slog_put(pOut, nSize, nLength, sTag, strlen(sTag));
+    }
+
+    pOut[nLength] = SLOG_NUL;
+    return (int)nLength;
 }
 
-void slog_enable(slog_flag_t eFlag)
+/* Grows the calling thread's line buffer, the old contents are kept */
+static char *slog_reserve_line(size_t nSize)
 {
-    slog_sync_lock(&g_slog);
-    slog_config_t *pCfg = &g_slog.config;
+    slog_line_buffer_t *pLine = &g_line;
+    if (pLine->nSize >= nSize) return pLine->pData;
 
-    if (eFlag == SLOG_FLAGS_ALL) pCfg->nFlags = SLOG_FLAGS_ALL;
-    else if (!SLOG_FLAGS_CHECK(pCfg->nFlags, eFlag)) pCfg->nFlags |= eFlag;
+    size_t nNewSize = pLine->nSize ? pLine->nSize : SLOG_LINE_INITIAL;
+    while (nNewSize < nSize) nNewSize *= 2;
 
-    slog_sync_unlock(&g_slog);
+    char *pData = (char*)realloc(pLine->pData, nNewSize);
+    if (pData == NULL) return NULL;
+
+#ifndef _WIN32
+    pthread_once(&g_lineKeyOnce, slog_create_line_key);
+    pthread_setspecific(g_lineKey, pData);
+#endif
+
+    pLine->pData = pData;
+    pLine->nSize = nNewSize;
+    return pData;
 }
 
-void slog_disable(slog_flag_t eFlag)
+static void slog_free_line(void)
 {
-    slog_sync_lock(&g_slog);
-    slog_config_t *pCfg = &g_slog.config;
+    slog_line_buffer_t *pLine = &g_line;
 
-    if (eFlag == SLOG_FLAGS_ALL) pCfg->nFlags = 0;
-    else if (SLOG_FLAGS_CHECK(pCfg->nFlags, eFlag)) pCfg->nFlags &= ~eFlag;
+#ifndef _WIN32
+    if (pLine->pData != NULL) pthread_setspecific(g_lineKey, NULL);
+#endif
 
-    slog_sync_unlock(&g_slog);
+    free(pLine->pData);
+    pLine->pData = NULL;
+    pLine->nSize = 0;
 }
 
-void slog_separator_set(const char *pFormat, ...)
+/*
+ * Renders info, separator, message, color reset and newline into the calling
+ * thread's line buffer. The message is cut at SLOG_MESSAGE_MAX unless nUseHeap
+ * is set, the buffer only grows when a line does not fit.
+ */
+static const char *slog_render_line(const slog_context_t *pCtx, va_list args, size_t *pLength)
 {
-    slog_sync_lock(&g_slog);
     slog_config_t *pCfg = &g_slog.config;
+    uint8_t nFullColor = pCfg->eColorFormat == SLOG_COLORING_FULL ? 1 : 0;
+    size_t nTail = sizeof(SLOG_COLOR_RESET) + sizeof(SLOG_NEWLINE);
+    size_t nSeparator = strlen(pCfg->sSeparator);
 
-    va_list args;
-    va_start(args, pFormat);
+    char *pOut = slog_reserve_line(SLOG_INFO_MAX + nSeparator + SLOG_MESSAGE_MAX + nTail);
+    if (pOut == NULL) return NULL;
 
-    if (vsnprintf(pCfg->sSeparator, sizeof(pCfg->sSeparator), pFormat, args) <= 0)
+    int nInfo = slog_create_info(pCtx, pOut, SLOG_INFO_MAX);
+    size_t nLength = nInfo > 0 ? (size_t)nInfo : 0;
+
+    if (nLength > 0)
     {
-        pCfg->sSeparator[0] = ' ';
-        pCfg->sSeparator[1] = '\0';
+        memcpy(pOut + nLength, pCfg->sSeparator, nSeparator);
+        nLength += nSeparator;
     }
 
-    va_end(args);
+    va_list locArgs;
+    va_copy(locArgs, args);
+    int nMessage = vsnprintf(pOut + nLength, SLOG_MESSAGE_MAX, pCtx->pFormat, locArgs);
+    va_end(locArgs);
+
+    if (nMessage >= SLOG_MESSAGE_MAX && pCfg->nUseHeap)
+    {
+        pOut = slog_reserve_line(nLength + (size_t)nMessage + nTail);
+        if (pOut == NULL) return NULL;
+        vsnprintf(pOut + nLength, (size_t)nMessage + 1, pCtx->pFormat, args);
+    }
+    else if (nMessage >= SLOG_MESSAGE_MAX)
+    {
+        nMessage = SLOG_MESSAGE_MAX - 1;
+    }
+
+    if (nMessage > 0) nLength += (size_t)nMessage;
+
+    if (nFullColor)
+    {
+        memcpy(pOut + nLength, SLOG_COLOR_RESET, sizeof(SLOG_COLOR_RESET) - 1);
+        nLength += sizeof(SLOG_COLOR_RESET) - 1;
+    }
+
+    if (pCtx->nNewLine)
+    {
+        memcpy(pOut + nLength, SLOG_NEWLINE, sizeof(SLOG_NEWLINE) - 1);
+        nLength += sizeof(SLOG_NEWLINE) - 1;
+    }
+
+    pOut[nLength] = SLOG_NUL;
+    *pLength = nLength;
+    return pOut;
+}
+
+#ifndef _WIN32
+static size_t slog_append(char *pOut, size_t nSize, size_t nLength, const char *pStr)
+{
+    while (*pStr && nLength + 1 < nSize) pOut[nLength++] = *pStr++;
+    pOut[nLength] = SLOG_NUL;
+    return nLength;
+}
+
+/* Renders info, separator, message, color reset and newline into one buffer */
+static size_t slog_format_line(const slog_context_t *pCtx, char *pOut, size_t nSize, va_list args)
+{
+    slog_config_t *pCfg = &g_slog.config;
+    uint8_t nFullColor = pCfg->eColorFormat == SLOG_COLORING_FULL ? 1 : 0;
+    size_t nTail = sizeof(SLOG_COLOR_RESET) + sizeof(SLOG_NEWLINE);
+
+    int nInfo = slog_create_info(pCtx, pOut, nSize - nTail);
+    size_t nLength = nInfo < 0 ? 0 : (size_t)nInfo;
+    if (nLength >= nSize - nTail) nLength = nSize - nTail - 1;
+
+    if (nLength > 0) nLength = slog_append(pOut, nSize - nTail, nLength, pCfg->sSeparator);
+
+    int nMessage = vsnprintf(pOut + nLength, nSize - nTail - nLength, pCtx->pFormat, args);
+    if (nMessage > 0) nLength += (size_t)nMessage;
+    if (nLength >= nSize - nTail) nLength = nSize - nTail - 1;
+
+    if (nFullColor) nLength = slog_append(pOut, nSize, nLength, SLOG_COLOR_RESET);
+    if (pCtx->nNewLine) nLength = slog_append(pOut, nSize, nLength, SLOG_NEWLINE);
+    return nLength;
+}
+
+/* Marks the stage of an exiting thread, the writer releases it once drained */
+static void slog_stage_exit(void *pArg)
+{
+    slog_stage_t *pStage = (slog_stage_t*)pArg;
+    if (g_stageRef.pStage != pStage || g_stageRef.nGen != pStage->nGen) return;
+
+    int nState = SLOG_STAGE_ACTIVE;
+    if (atomic_compare_exchange_strong(&pStage->nState, &nState, SLOG_STAGE_EXITED) &&
+        atomic_load(&g_async.nRunning)) sem_post(&g_async.sem);
+}
+
+static void slog_create_stage_key(void)
+{
+    pthread_key_create(&g_stageKey, slog_stage_exit);
+}
+
+/* Returns the calling thread's stage, claims a free slot on first use */
+static slog_stage_t *slog_async_stage(slog_async_t *pAsync)
+{
+    uint32_t nGen = atomic_load_explicit(&pAsync->nGen, memory_order_relaxed);
+    if (g_stageRef.pStage != NULL && g_stageRef.nGen == nGen) return g_stageRef.pStage;
+
+    for (int i = 0; i < SLOG_STAGES_MAX; i++)
+    {
+        slog_stage_t *pStage = &pAsync->stages[i];
+        int nState = SLOG_STAGE_FREE;
+
+        if (!atomic_compare_exchange_strong(&pStage->nState, &nState, SLOG_STAGE_CLAIMED)) continue;
+
+        pStage->pRecords = (slog_record_t*)malloc(pAsync->nCapacity * sizeof(slog_record_t));
+        if (pStage->pRecords == NULL)
+        {
+            atomic_store(&pStage->nState, SLOG_STAGE_FREE);
+            return NULL;
+        }
+
+        atomic_store_explicit(&pStage->nHead, 0, memory_order_relaxed);
+        atomic_store_explicit(&pStage->nTail, 0, memory_order_relaxed);
+        atomic_store_explicit(&pStage->nDropped, 0, memory_order_relaxed);
+        atomic_store_explicit(&pStage->nStamp, 0, memory_order_relaxed);
+        pStage->nGen = nGen;
+
+        pthread_once(&g_stageKeyOnce, slog_create_stage_key);
+        pthread_setspecific(g_stageKey, pStage);
+
+        g_stageRef.pStage = pStage;
+        g_stageRef.nGen = nGen;
+
+        int nStages = atomic_load(&pAsync->nStages);
+        while (nStages < i + 1 && !atomic_compare_exchange_weak(&pAsync->nStages, &nStages, i + 1));
+
+        atomic_store_explicit(&pStage->nState, SLOG_STAGE_ACTIVE, memory_order_release);
+        return pStage;
+    }
+
+    return NULL;
+}
+
+/* Renders into the calling thread's stage. Returns 0 when no stage is available, drops when full */
+static int slog_async_push(const slog_context_t *pCtx, va_list args)
+{
+    slog_async_t *pAsync = &g_async;
+    slog_stage_t *pStage = slog_async_stage(pAsync);
+    if (pStage == NULL) return 0;
+
+    size_t nTail = atomic_load_explicit(&pStage->nTail, memory_order_relaxed);
+    size_t nHead = atomic_load_explicit(&pStage->nHead, memory_order_acquire);
+
+    if (nTail - nHead >= pAsync->nCapacity)
+    {
+        atomic_fetch_add_explicit(&pStage->nDropped, 1, memory_order_relaxed);
+        return 1;
+    }
+
+    /* Announced before the clock is read, the writer holds back newer records until it is done */
+    atomic_store(&pStage->nStamp, SLOG_STAMP_PENDING);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    slog_record_t *pRecord = &pStage->pRecords[nTail & (pAsync->nCapacity - 1)];
+    pRecord->nTime = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    atomic_store_explicit(&pStage->nStamp, pRecord->nTime, memory_order_relaxed);
+
+    /* The printed time is the merge key, so the output reads in order */
+    slog_context_t ctx = *pCtx;
+    slog_date_from_time(&ctx.date, ts.tv_sec, ts.tv_nsec / 1000);
+
+    pRecord->eFlag = ctx.eFlag;
+    pRecord->date = ctx.date;
+    pRecord->nLength = slog_format_line(&ctx, pRecord->sLine, sizeof(pRecord->sLine), args);
+
+    atomic_store_explicit(&pStage->nTail, nTail + 1, memory_order_release);
+    atomic_store_explicit(&pStage->nStamp, 0, memory_order_release);
+    sem_post(&pAsync->sem);
+    return 1;
+}
+
+/*
+ * Oldest pending record over all stages, NULL when they are all empty or
+ * a push still in progress may stamp an older one (it posts when done).
+ */
+static slog_stage_t *slog_async_oldest(slog_async_t *pAsync)
+{
+    for (;;)
+    {
+        /* Pushes not announced by now read the clock later, their records are newer */
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        uint64_t nLimit = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+        atomic_thread_fence(memory_order_seq_cst);
+
+        int nStages = atomic_load_explicit(&pAsync->nStages, memory_order_acquire);
+        slog_stage_t *pOldest = NULL;
+        uint64_t nOldest = 0;
+        uint8_t nBusy = 0;
+
+        for (int i = 0; i < nStages; i++)
+        {
+            uint64_t nStamp = atomic_load_explicit(&pAsync->stages[i].nStamp, memory_order_relaxed);
+            if (nStamp != 0 && nStamp < nLimit)
+            {
+                nLimit = nStamp;
+                nBusy = 1;
+            }
+        }
+
+        for (int i = 0; i < nStages; i++)
+        {
+            slog_stage_t *pStage = &pAsync->stages[i];
+            int nState = atomic_load_explicit(&pStage->nState, memory_order_acquire);
+            if (nState != SLOG_STAGE_ACTIVE && nState != SLOG_STAGE_EXITED) continue;
+
+            size_t nHead = atomic_load_explicit(&pStage->nHead, memory_order_relaxed);
+            if (nHead == atomic_load_explicit(&pStage->nTail, memory_order_acquire)) continue;
+
+            uint64_t nTime = pStage->pRecords[nHead & (pAsync->nCapacity - 1)].nTime;
+            if (pOldest == NULL || nTime < nOldest)
+            {
+                pOldest = pStage;
+                nOldest = nTime;
+            }
+        }
+
+        if (pOldest == NULL || nOldest < nLimit) return pOldest;
+        if (nBusy) return NULL;
+
+        /* Stamped after the clock read above, take a new one */
+    }
+}
+
+static void slog_async_drain(slog_async_t *pAsync)
+{
+    slog_stage_t *pStage;
+
+    while ((pStage = slog_async_oldest(pAsync)) != NULL)
+    {
+        size_t nHead = atomic_load_explicit(&pStage->nHead, memory_order_relaxed);
+        slog_record_t *pRecord = &pStage->pRecords[nHead & (pAsync->nCapacity - 1)];
+
+        slog_context_t ctx;
+        ctx.eFlag = pRecord->eFlag;
+        ctx.date = pRecord->date;
+
+        slog_sync_lock(&g_slog);
+        slog_display_line(&ctx, pRecord->sLine, pRecord->nLength);
+        slog_sync_unlock(&g_slog);
+
+        atomic_store_explicit(&pStage->nHead, nHead + 1, memory_order_release);
+    }
+
+    size_t nDropped = 0;
+    int nStages = atomic_load_explicit(&pAsync->nStages, memory_order_acquire);
+
+    for (int i = 0; i < nStages; i++)
+    {
+        pStage = &pAsync->stages[i];
+        int nState = atomic_load_explicit(&pStage->nState, memory_order_acquire);
+        if (nState != SLOG_STAGE_ACTIVE && nState != SLOG_STAGE_EXITED) continue;
+
+        nDropped += atomic_exchange_explicit(&pStage->nDropped, 0, memory_order_relaxed);
+
+        /* Drained stage of an exited thread, the slot can be claimed again */
+        if (nState == SLOG_STAGE_EXITED &&
+            atomic_load_explicit(&pStage->nHead, memory_order_relaxed) ==
+            atomic_load_explicit(&pStage->nTail, memory_order_acquire))
+        {
+            free(pStage->pRecords);
+            pStage->pRecords = NULL;
+            atomic_store_explicit(&pStage->nState, SLOG_STAGE_FREE, memory_order_release);
+        }
+    }
+
+    if (nDropped)
+    {
+        char sLine[SLOG_INFO_MAX];
+        slog_context_t ctx;
+        slog_get_date(&ctx.date);
+        ctx.eFlag = SLOG_WARN;
+
+        int nLength = snprintf(sLine, sizeof(sLine), "<warn> %zu log messages dropped, async queue full\n", nDropped);
+        slog_sync_lock(&g_slog);
+        slog_display_line(&ctx, sLine, (size_t)nLength);
+        slog_sync_unlock(&g_slog);
+    }
+}
+
+static void *slog_async_worker(void *pArg)
+{
+    slog_async_t *pAsync = (slog_async_t*)pArg;
+
+    for (;;)
+    {
+        while (sem_wait(&pAsync->sem) && errno == EINTR);
+        slog_async_drain(pAsync);
+        if (atomic_load(&pAsync->nStop)) break;
+    }
+
+    slog_async_drain(pAsync);
+    return NULL;
+}
+
+/* Takes the record path if the writer is running, returns 0 to fall back to the synchronous path */
+static int slog_async_display(const slog_context_t *pCtx, va_list args)
+{
+    slog_async_t *pAsync = &g_async;
+    int nQueued = 0;
+
+    /*
+     * Pairs with slog_async_stop() storing nRunning then reading nActive:
+     * with both sides seq_cst either stop sees this producer or the
+     * producer sees the writer stopped, never neither.
+     */
+    atomic_fetch_add(&pAsync->nActive, 1);
+    if (atomic_load(&pAsync->nRunning) && !atomic_load(&pAsync->nPaused))
+    {
+        nQueued = slog_async_push(pCtx, args);
+    }
+
+    atomic_fetch_sub_explicit(&pAsync->nActive, 1, memory_order_release);
+    return nQueued;
+}
+#endif
+
+/*
+ * Producers render with g_slog.config outside the slog mutex. Setters take
+ * the mutex, then wait for the renders in progress the same way
+ * slog_async_stop() does. Lines logged until the unlock go synchronous and
+ * block on the mutex, so no line mixes old and new settings.
+ */
+static void slog_config_lock(void)
+{
+    slog_sync_lock(&g_slog);
+#ifndef _WIN32
+    atomic_fetch_add(&g_async.nPaused, 1);
+    while (atomic_load(&g_async.nActive)) sched_yield();
+#endif
+}
+
+static void slog_config_unlock(void)
+{
+#ifndef _WIN32
+    atomic_fetch_sub(&g_async.nPaused, 1);
+#endif
     slog_sync_unlock(&g_slog);
 }
 
-void slog_callback_set(slog_cb_t callback, void *pContext)
+#ifndef _WIN32
+/* FNV-1a of the format text, also returns its length */
+static uint32_t slog_binary_hash(const char *pFormat, size_t *pLength)
+{
+    uint32_t nHash = 2166136261u;
+    const char *p = pFormat;
+
+    for (; *p; p++) nHash = (nHash ^ (uint8_t)*p) * 16777619u;
+
+    *pLength = (size_t)(p - pFormat);
+    return nHash;
+}
+
+/* Returns the id of a format text, registering it on first use. 0 when the table is full */
+static uint32_t slog_binary_format_id(slog_binary_t *pBin, const char *pFormat)
+{
+    size_t nMask = SLOG_BIN_FORMATS_MAX - 1;
+    size_t nLength;
+    uint32_t nHash = slog_binary_hash(pFormat, &nLength);
+    size_t nSlot = (size_t)(nHash * 2654435761u) & nMask;
+
+    for (size_t i = 0; i < SLOG_BIN_FORMATS_MAX; i++, nSlot = (nSlot + 1) & nMask)
+    {
+        if (pBin->pFormats[nSlot] != NULL)
+        {
+            if (pBin->nHashes[nSlot] == nHash && !strcmp(pBin->pFormats[nSlot], pFormat)) return pBin->nIds[nSlot];
+            continue;
+        }
+
+        if (++nLength > UINT16_MAX) return 0;
+
+        char *pCopy = (char*)malloc(nLength);
+        if (pCopy == NULL) return 0;
+        memcpy(pCopy, pFormat, nLength);
+
+        slog_bin_header_t hdr = { 0 };
+        hdr.nType = SLOG_BIN_FORMAT;
+        hdr.nPayload = (uint16_t)nLength;
+        hdr.nFormatId = ++pBin->nNextId;
+
+        fwrite(&hdr, sizeof(hdr), 1, pBin->pHandle);
+        fwrite(pFormat, 1, nLength, pBin->pHandle);
+
+        pBin->pFormats[nSlot] = pCopy;
+        pBin->nHashes[nSlot] = nHash;
+        pBin->nIds[nSlot] = hdr.nFormatId;
+        return hdr.nFormatId;
+    }
+
+    return 0;
+}
+
+static void slog_binary_free_formats(slog_binary_t *pBin)
+{
+    for (size_t i = 0; i < SLOG_BIN_FORMATS_MAX; i++)
+    {
+        free(pBin->pFormats[i]);
+        pBin->pFormats[i] = NULL;
+    }
+}
+
+#define SLOG_BIN_PUT(pOut, nUsed, nSize, value) \
+    do { \
+        if ((nUsed) + sizeof(value) > (nSize)) return (nUsed); \
+        memcpy((pOut) + (nUsed), &(value), sizeof(value)); \
+        (nUsed) += sizeof(value); \
+    } while (0)
+
+/* Copies the raw arguments described by pFormat, see slog_bin.h for the layout */
+static size_t slog_binary_pack(const char *pFormat, va_list args, uint8_t *pOut, size_t nSize)
+{
+    const char *p = pFormat;
+    slog_bin_spec_t spec;
+    size_t nUsed = 0;
+
+    while ((p = slog_bin_next_spec(p, &spec)) != NULL)
+    {
+        if (spec.cConv == '%') continue;
+
+        int64_t nStar = -1;
+        for (uint8_t i = 0; i < spec.nStars; i++)
+        {
+            nStar = va_arg(args, int);
+            SLOG_BIN_PUT(pOut, nUsed, nSize, nStar);
+        }
+
+        /* A negative '*' precision counts as none */
+        int64_t nPrecision = spec.nPrecision == SLOG_BIN_PRECISION_STAR ? nStar : spec.nPrecision;
+
+        int64_t nValue = 0;
+        double fValue = 0;
+
+        switch (spec.cConv)
+        {
+            case 'd':
+            case 'i':
+                switch (spec.cLength)
+                {
+                    case 'l': nValue = va_arg(args, long); break;
+                    case 'q': nValue = va_arg(args, long long); break;
+                    case 'j': nValue = va_arg(args, intmax_t); break;
+                    case 'z': nValue = (int64_t)va_arg(args, size_t); break;
+                    case 't': nValue = va_arg(args, ptrdiff_t); break;
+                    default: nValue = va_arg(args, int); break;
+                }
+                SLOG_BIN_PUT(pOut, nUsed, nSize, nValue);
+                break;
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X':
+                switch (spec.cLength)
+                {
+                    case 'l': nValue = (int64_t)va_arg(args, unsigned long); break;
+                    case 'q': nValue = (int64_t)va_arg(args, unsigned long long); break;
+                    case 'j': nValue = (int64_t)va_arg(args, uintmax_t); break;
+                    case 'z': nValue = (int64_t)va_arg(args, size_t); break;
+                    case 't': nValue = va_arg(args, ptrdiff_t); break;
+                    default: nValue = va_arg(args, unsigned int); break;
+                }
+                SLOG_BIN_PUT(pOut, nUsed, nSize, nValue);
+                break;
+            case 'c':
+                nValue = va_arg(args, int);
+                SLOG_BIN_PUT(pOut, nUsed, nSize, nValue);
+                break;
+            case 'p':
+                nValue = (int64_t)(uintptr_t)va_arg(args, void*);
+                SLOG_BIN_PUT(pOut, nUsed, nSize, nValue);
+                break;
+            case 's':
+            {
+                const char *pStr = va_arg(args, const char*);
+                if (pStr == NULL) pStr = "(null)";
+
+                uint16_t nLength = 0;
+                if (nUsed + sizeof(nLength) > nSize) return nUsed;
+
+                /* With a precision the argument need not be NUL terminated */
+                size_t nRoom = nSize - nUsed - sizeof(nLength);
+                if (nPrecision >= 0 && (uint64_t)nPrecision < nRoom) nRoom = (size_t)nPrecision;
+                nLength = (uint16_t)strnlen(pStr, nRoom);
+
+                SLOG_BIN_PUT(pOut, nUsed, nSize, nLength);
+                memcpy(pOut + nUsed, pStr, nLength);
+                nUsed += nLength;
+                break;
+            }
+            case 'n':
+                (void)va_arg(args, void*);
+                break;
+            default:
+                if (!slog_bin_is_float(spec.cConv)) return nUsed; /* Unknown type, the rest can not be read */
+                fValue = spec.cLength == 'L' ? (double)va_arg(args, long double) : va_arg(args, double);
+                SLOG_BIN_PUT(pOut, nUsed, nSize, fValue);
+                break;
+        }
+    }
+
+    return nUsed;
+}
+
+static void slog_binary_record(slog_flag_t eFlag, const char *pFormat, va_list args)
+{
+    slog_binary_t *pBin = &g_binary;
+    uint8_t payload[SLOG_BIN_PAYLOAD_MAX];
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    size_t nPayload = slog_binary_pack(pFormat, args, payload, sizeof(payload));
+
+    slog_bin_header_t hdr = { 0 };
+    hdr.nType = SLOG_BIN_MESSAGE;
+    hdr.nFlag = (uint8_t)eFlag;
+    hdr.nPayload = (uint16_t)nPayload;
+    hdr.nTime = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+    hdr.nTid = (uint32_t)slog_get_tid();
+
+    pthread_mutex_lock(&pBin->mutex);
+    if (pBin->pHandle != NULL)
+    {
+        hdr.nFormatId = slog_binary_format_id(pBin, pFormat);
+        if (hdr.nFormatId)
+        {
+            fwrite(&hdr, sizeof(hdr), 1, pBin->pHandle);
+            fwrite(payload, 1, nPayload, pBin->pHandle);
+        }
+    }
+    pthread_mutex_unlock(&pBin->mutex);
+}
+#endif
+
+int slog_binary_open(const char *pPath, uint16_t nFlags, size_t nBufferSize)
+{
+#ifndef _WIN32
+    slog_binary_t *pBin = &g_binary;
+    slog_binary_close();
+
+    pthread_mutex_lock(&pBin->mutex);
+    pBin->pHandle = fopen(pPath, "wb");
+    if (pBin->pHandle == NULL)
+    {
+        printf("<%s:%d> %s: [ERROR] Failed to open file: %s (%s)\n",
+            __FILE__, __LINE__, __func__, pPath, strerror(errno));
+
+        pthread_mutex_unlock(&pBin->mutex);
+        return -1;
+    }
+
+    pBin->pBuffer = nBufferSize ? (char*)malloc(nBufferSize) : NULL;
+    if (pBin->pBuffer != NULL) setvbuf(pBin->pHandle, pBin->pBuffer, _IOFBF, nBufferSize);
+
+    fwrite(SLOG_BIN_MAGIC, 1, sizeof(SLOG_BIN_MAGIC) - 1, pBin->pHandle);
+    slog_binary_free_formats(pBin);
+    pBin->nNextId = 0;
+    pthread_mutex_unlock(&pBin->mutex);
+
+    slog_sync_lock(&g_slog);
+    g_nSlogBinFlags = nFlags;
+    slog_update_flags(&g_slog.config);
+    slog_sync_unlock(&g_slog);
+    return 0;
+#else
+    (void)pPath;
+    (void)nFlags;
+    (void)nBufferSize;
+    return -1;
+#endif
+}
+
+void slog_binary_flush()
+{
+#ifndef _WIN32
+    pthread_mutex_lock(&g_binary.mutex);
+    if (g_binary.pHandle != NULL) fflush(g_binary.pHandle);
+    pthread_mutex_unlock(&g_binary.mutex);
+#endif
+}
+
+void slog_binary_close()
 {
+#ifndef _WIN32
+    slog_binary_t *pBin = &g_binary;
+
     slog_sync_lock(&g_slog);
+    g_nSlogBinFlags = 0;
+    slog_update_flags(&g_slog.config);
+    slog_sync_unlock(&g_slog);
+
+    pthread_mutex_lock(&pBin->mutex);
+    if (pBin->pHandle != NULL)
+    {
+        fclose(pBin->pHandle);
+        pBin->pHandle = NULL;
+    }
+
+    slog_binary_free_formats(pBin);
+    free(pBin->pBuffer);
+    pBin->pBuffer = NULL;
+    pthread_mutex_unlock(&pBin->mutex);
+#endif
+}
+
+int slog_async_start(size_t nRecords)
+{
+#ifndef _WIN32
+    slog_async_t *pAsync = &g_async;
+    if (atomic_load(&pAsync->nRunning)) return 0;
+
+    size_t nCapacity = 2;
+    while (nCapacity < nRecords) nCapacity <<= 1;
+
+    pAsync->nCapacity = nCapacity;
+    atomic_fetch_add(&pAsync->nGen, 1);
+    atomic_store(&pAsync->nStages, 0);
+    atomic_store(&pAsync->nStop, 0);
+
+    /* The writer thread shares the outputs with the synchronous path */
+    if (!g_slog.nTdSafe)
+    {
+        g_slog.nTdSafe = 1;
+        slog_sync_init(&g_slog);
+    }
+
+    if (sem_init(&pAsync->sem, 0, 0) ||
+        pthread_create(&pAsync->thread, NULL, slog_async_worker, pAsync))
+    {
+        printf("<%s:%d> %s: [ERROR] Can not start async writer: %d\n",
+            __FILE__, __LINE__, __func__, errno);
+
+        return -1;
+    }
+
+    atomic_store(&pAsync->nRunning, 1);
+    return 0;
+#else
+    (void)nRecords;
+    return -1;
+#endif
+}
+
+void slog_async_stop()
+{
+#ifndef _WIN32
+    slog_async_t *pAsync = &g_async;
+    if (!atomic_load(&pAsync->nRunning)) return;
+
+    /* New messages go synchronous, wait for producers still pushing */
+    atomic_store(&pAsync->nRunning, 0);
+    while (atomic_load(&pAsync->nActive)) sched_yield();
+
+    atomic_store(&pAsync->nStop, 1);
+    sem_post(&pAsync->sem);
+    pthread_join(pAsync->thread, NULL);
+    sem_destroy(&pAsync->sem);
+
+    for (int i = 0; i < SLOG_STAGES_MAX; i++)
+    {
+        free(pAsync->stages[i].pRecords);
+        pAsync->stages[i].pRecords = NULL;
+        atomic_store(&pAsync->stages[i].nState, SLOG_STAGE_FREE);
+    }
+#endif
+}
+
+int slog_file_sink_start(size_t nBufferSize, uint32_t nFlushMs)
+{
+#ifndef _WIN32
+    slog_sink_t *pSink = &g_sink;
+    if (atomic_load(&pSink->nRunning)) return 0;
+    if (nBufferSize < SLOG_INFO_MAX) nBufferSize = SLOG_INFO_MAX;
+
+    pSink->pActive = (char*)malloc(nBufferSize);
+    pSink->pSpare = (char*)malloc(nBufferSize);
+    if (pSink->pActive == NULL || pSink->pSpare == NULL)
+    {
+        free(pSink->pActive);
+        free(pSink->pSpare);
+        pSink->pActive = pSink->pSpare = NULL;
+        return -1;
+    }
+
+    pSink->pPending = NULL;
+    pSink->nActive = 0;
+    pSink->nSize = nBufferSize;
+    pSink->nFlushMs = nFlushMs ? nFlushMs : 1;
+    pSink->nFd = -1;
+    pSink->nCurrDay = 0;
+    pSink->nReopen = 0;
+    pSink->nStop = 0;
+
+    if (pthread_create(&pSink->thread, NULL, slog_sink_worker, pSink))
+    {
+        printf("<%s:%d> %s: [ERROR] Can not start file writer: %d\n",
+            __FILE__, __LINE__, __func__, errno);
+
+        free(pSink->pActive);
+        free(pSink->pSpare);
+        pSink->pActive = pSink->pSpare = NULL;
+        return -1;
+    }
+
+    /* Lines written through stdio so far are flushed before the sink takes over */
+    slog_sync_lock(&g_slog);
+    slog_close_file(&g_slog.logFile);
+    atomic_store(&pSink->nRunning, 1);
+    slog_sync_unlock(&g_slog);
+    return 0;
+#else
+    (void)nBufferSize;
+    (void)nFlushMs;
+    return -1;
+#endif
+}
+
+void slog_file_sink_stop()
+{
+#ifndef _WIN32
+    slog_sink_t *pSink = &g_sink;
+    if (!atomic_load(&pSink->nRunning)) return;
+
+    /* Later lines go through stdio again */
+    slog_sync_lock(&g_slog);
+    atomic_store(&pSink->nRunning, 0);
+    slog_sync_unlock(&g_slog);
+
+    pthread_mutex_lock(&pSink->mutex);
+    slog_sink_handoff(pSink);
+    pSink->nStop = 1;
+    pthread_cond_broadcast(&pSink->cond);
+    pthread_mutex_unlock(&pSink->mutex);
+    pthread_join(pSink->thread, NULL);
+
+    free(pSink->pActive);
+    free(pSink->pSpare);
+    pSink->pActive = pSink->pSpare = NULL;
+#endif
+}
+
+void slog_display(slog_flag_t eFlag, uint8_t nNewLine, const char *pFormat, ...)
+{
+    /* Disabled levels return before touching the mutex */
+    if (!SLOG_FLAGS_CHECK(SLOG_ATOMIC_LOAD(g_nSlogFlags), eFlag)) return;
+
+#ifndef _WIN32
+    if (SLOG_FLAGS_CHECK(g_nSlogBinFlags, eFlag))
+    {
+        va_list args;
+        va_start(args, pFormat);
+        slog_binary_record(eFlag, pFormat, args);
+        va_end(args);
+        return;
+    }
+#endif
+
+#ifndef _WIN32
+    /* Fatal messages stay synchronous, the process may not live to drain the queue */
+    if (eFlag != SLOG_FATAL && atomic_load_explicit(&g_async.nRunning, memory_order_relaxed))
+    {
+        slog_context_t ctx; // Dated by slog_async_push()
+        ctx.eFlag = eFlag;
+        ctx.pFormat = pFormat;
+        ctx.nNewLine = nNewLine;
+
+        va_list args;
+        va_start(args, pFormat);
+        int nQueued = slog_async_display(&ctx, args);
+        va_end(args);
+
+        if (nQueued) return;
+    }
+#endif
+
+    slog_sync_lock(&g_slog);
+
+    if ((SLOG_FLAGS_CHECK(g_slog.config.nFlags, eFlag)) &&
+        (g_slog.config.logCallback ||
+         g_slog.config.nToScreen ||
+         g_slog.config.nToFile))
+    {
+        slog_context_t ctx;
+        slog_get_date(&ctx.date);
+
+        ctx.eFlag = eFlag;
+        ctx.pFormat = pFormat;
+        ctx.nNewLine = nNewLine;
+
+        size_t nLength = 0;
+        va_list args;
+        va_start(args, pFormat);
+        const char *pLine = slog_render_line(&ctx, args, &nLength);
+        va_end(args);
+
+        if (pLine != NULL) slog_display_line(&ctx, pLine, nLength);
+        else printf("<%s:%d> %s<error>%s %s: Can not allocate memory for input: errno(%d)\n",
+            __FILE__, __LINE__, SLOG_COLOR_RED, SLOG_COLOR_RESET, __func__, errno);
+    }
+
+    slog_sync_unlock(&g_slog);
+}
+
+#ifdef _WIN32
+#define slog_limit_load64(p) ((uint64_t)InterlockedCompareExchange64((volatile LONG64*)(p), 0, 0))
+#define slog_limit_load32(p) ((uint32_t)InterlockedCompareExchange((volatile LONG*)(p), 0, 0))
+#define slog_limit_cas64(p, nOld, nNew) \
+    (InterlockedCompareExchange64((volatile LONG64*)(p), (LONG64)(nNew), (LONG64)(nOld)) == (LONG64)(nOld))
+#define slog_limit_add32(p, v) ((uint32_t)InterlockedExchangeAdd((volatile LONG*)(p), (LONG)(v)))
+#define slog_limit_swap32(p, v) ((uint32_t)InterlockedExchange((volatile LONG*)(p), (LONG)(v)))
+#else
+#define slog_limit_load64(p) atomic_load_explicit(p, memory_order_relaxed)
+#define slog_limit_load32(p) atomic_load_explicit(p, memory_order_relaxed)
+#define slog_limit_cas64(p, nOld, nNew) slog_limit_cas(p, nOld, nNew)
+#define slog_limit_add32(p, v) atomic_fetch_add_explicit(p, v, memory_order_relaxed)
+#define slog_limit_swap32(p, v) atomic_exchange_explicit(p, v, memory_order_relaxed)
+#endif
+
+#ifndef _WIN32
+static inline uint8_t slog_limit_cas(_Atomic uint64_t *pValue, uint64_t nOld, uint64_t nNew)
+{
+    return atomic_compare_exchange_strong(pValue, &nOld, nNew);
+}
+#endif
+
+static uint64_t slog_get_ms()
+{
+#ifdef _WIN32
+    return (uint64_t)GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+#endif
+}
+
+/*
+ * The thread whose CAS moves nStart opens the interval: it takes over the
+ * suppressed count and restarts nCount with its own message. Messages
+ * racing with the rollover may still be counted against the old interval,
+ * their drops are reported with the next interval.
+ */
+uint8_t slog_limit_interval(slog_limit_t *pLimit, uint32_t nBurst, uint32_t nIntervalMs, uint32_t *pSuppressed)
+{
+    uint64_t nNow = slog_get_ms();
+    uint64_t nStart = slog_limit_load64(&pLimit->nStart);
+
+    if ((nStart == 0 || nNow - nStart >= nIntervalMs) && nBurst &&
+        slog_limit_cas64(&pLimit->nStart, nStart, nNow))
+    {
+        slog_limit_swap32(&pLimit->nCount, 1);
+        *pSuppressed = slog_limit_swap32(&pLimit->nSuppressed, 0);
+        return 1;
+    }
+
+    /* Checked first so a flooded call site stops counting and cannot wrap nCount */
+    if (slog_limit_load32(&pLimit->nCount) < nBurst &&
+        slog_limit_add32(&pLimit->nCount, 1) < nBurst)
+    {
+        *pSuppressed = slog_limit_swap32(&pLimit->nSuppressed, 0);
+        return 1;
+    }
+
+    slog_limit_add32(&pLimit->nSuppressed, 1);
+    return 0;
+}
+
+uint8_t slog_limit_every(slog_limit_t *pLimit, uint32_t nEvery, uint32_t *pSuppressed)
+{
+    if (!nEvery || slog_limit_add32(&pLimit->nCount, 1) % nEvery == 0)
+    {
+        *pSuppressed = slog_limit_swap32(&pLimit->nSuppressed, 0);
+        return 1;
+    }
+
+    slog_limit_add32(&pLimit->nSuppressed, 1);
+    return 0;
+}
+
+const char* slog_version(uint8_t nShort)
+{
+    if (nShort)
+    {
+        if (!g_nHaveSlogVerShort)
+        {
+            snprintf(g_slogVerShort, sizeof(g_slogVerShort), "%d.%d.%d",
+                SLOG_VERSION_MAJOR, SLOG_VERSION_MINOR, SLOG_BUILD_NUMBER);
+
+            g_nHaveSlogVerShort = 1;
+        }
+
+        return g_slogVerShort;
+    }
+
+    if (!g_nHaveSlogVerLong)
+    {
+        snprintf(g_slogVerLong, sizeof(g_slogVerLong), "%d.%d build %d (%s)",
+        SLOG_VERSION_MAJOR, SLOG_VERSION_MINOR, SLOG_BUILD_NUMBER, __DATE__);
+
+        g_nHaveSlogVerLong = 1;
+    }
+
+    return g_slogVerLong;
+}
+
+void slog_config_get(slog_config_t *pCfg)
+{
+    slog_sync_lock(&g_slog);
+    *pCfg = g_slog.config;
+    slog_sync_unlock(&g_slog);
+}
+
+void slog_config_set(slog_config_t *pCfg)
+{
+    slog_config_lock();
+    slog_config_t *pOldCfg = &g_slog.config;
+    slog_file_t *pFile = &g_slog.logFile;
+
+    if (!pCfg->nToFile ||
+        strncmp(pOldCfg->sFilePath, pCfg->sFilePath, sizeof(pOldCfg->sFilePath)) ||
+        strncmp(pOldCfg->sFileName, pCfg->sFileName, sizeof(pOldCfg->sFileName)))
+    {
+        slog_close_file(pFile); /* Log function will open it again if required */
+        pFile->sFilePath[0] = SLOG_NUL;
+
+#ifndef _WIN32
+        pthread_mutex_lock(&g_sink.mutex);
+        g_sink.nCurrDay = 0;
+        pthread_mutex_unlock(&g_sink.mutex);
+#endif
+    }
+
+    g_slog.config = *pCfg;
+    slog_update_flags(&g_slog.config);
+    slog_config_unlock();
+}
+
+void slog_enable(slog_flag_t eFlag)
+{
+    slog_config_lock();
+    slog_config_t *pCfg = &g_slog.config;
+
+    if (eFlag == SLOG_FLAGS_ALL) pCfg->nFlags = SLOG_FLAGS_ALL;
+    else if (!SLOG_FLAGS_CHECK(pCfg->nFlags, eFlag)) pCfg->nFlags |= eFlag;
+
+    slog_update_flags(pCfg);
+
+    slog_config_unlock();
+}
+
+void slog_disable(slog_flag_t eFlag)
+{
+    slog_config_lock();
+    slog_config_t *pCfg = &g_slog.config;
+
+    if (eFlag == SLOG_FLAGS_ALL) pCfg->nFlags = 0;
+    else if (SLOG_FLAGS_CHECK(pCfg->nFlags, eFlag)) pCfg->nFlags &= ~eFlag;
+
+    slog_update_flags(pCfg);
+
+    slog_config_unlock();
+}
+
+void slog_separator_set(const char *pFormat, ...)
+{
+    slog_config_lock();
+    slog_config_t *pCfg = &g_slog.config;
+
+    va_list args;
+    va_start(args, pFormat);
+
+    if (vsnprintf(pCfg->sSeparator, sizeof(pCfg->sSeparator), pFormat, args) <= 0)
+    {
+        pCfg->sSeparator[0] = ' ';
+        pCfg->sSeparator[1] = '\0';
+    }
+
+    va_end(args);
+    slog_config_unlock();
+}
+
+void slog_callback_set(slog_cb_t callback, void *pContext)
+{
+    slog_config_lock();
     slog_config_t *pCfg = &g_slog.config;
     pCfg->pCallbackCtx = pContext;
     pCfg->logCallback = callback;
-    slog_sync_unlock(&g_slog);
+    slog_update_flags(pCfg);
+    slog_config_unlock();
 }
 
 size_t slog_get_full_path(char *pFilePath, size_t nSize)
@@ -669,6 +2006,12 @@ void slog_init(const char* pName, uint16_t nFlags, uint8_t nTdSafe)
     pCfg->nRotate = 1;
     pCfg->nFlush = 0;
     pCfg->nFlags = nFlags;
+    slog_update_flags(pCfg);
+
+#ifndef _WIN32
+    static pthread_once_t atforkOnce = PTHREAD_ONCE_INIT;
+    pthread_once(&atforkOnce, slog_register_atfork);
+#endif
 
     const char *pFileName = (pName != NULL) ? pName : SLOG_NAME_DEFAULT;
     snprintf(pCfg->sFileName, sizeof(pCfg->sFileName), "%s", pFileName);
@@ -691,9 +2034,14 @@ void slog_init(const char* pName, uint16_t nFlags, uint8_t nTdSafe)
 
 void slog_destroy()
 {
+    slog_async_stop();
+    slog_binary_close();
+    slog_file_sink_stop();
+    slog_free_line();
     slog_sync_lock(&g_slog);
     slog_close_file(&g_slog.logFile);
     memset(&g_slog.config, 0, sizeof(g_slog.config));
+    slog_update_flags(&g_slog.config);
 
     g_slog.config.pCallbackCtx = NULL;
     g_slog.config.logCallback = NULL;
@@ -63,6 +63,7 @@ extern "C" {
 #define SLOG_DATE_MAX           64
 #define SLOG_TAG_MAX            32
 #define SLOG_COLOR_MAX          16
+#define SLOG_ASYNC_LINE_MAX     1024
 
 #define SLOG_FLAGS_CHECK(c, f) (((c) & (f)) == (f))
 #define SLOG_FLAGS_ALL          255
@@ -117,25 +118,68 @@ typedef enum
     SLOG_DATE_FULL
 } slog_date_ctrl_t;
 
+/*
+ * Compile-time ceiling: levels missing from this mask are removed from the
+ * build, e.g. -DSLOG_COMPILED_FLAGS="(SLOG_FLAGS_ALL & ~SLOG_TRACE)".
+ */
+#ifndef SLOG_COMPILED_FLAGS
+#define SLOG_COMPILED_FLAGS     SLOG_FLAGS_ALL
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SLOG_UNLIKELY(x)        __builtin_expect(!!(x), 0)
+#else
+#define SLOG_UNLIKELY(x)        (x)
+#endif
+
+/*
+ * Shared state read without the mutex. C units use C11 relaxed atomics.
+ * Windows builds and C++ units see a plain volatile of the same size, so
+ * SLOG_ENABLED() there is a single aligned load with no ordering: enough
+ * for a level hint, since slog_display() checks the level again. The rate
+ * limiter fields are only updated in slog.c, with Interlocked functions on
+ * Windows.
+ */
+#if !defined(_WIN32) && !defined(__cplusplus)
+#include <stdatomic.h>
+#define SLOG_ATOMIC(type) _Atomic type
+#define SLOG_ATOMIC_LOAD(var) atomic_load_explicit(&(var), memory_order_relaxed)
+#define SLOG_ATOMIC_STORE(var, value) atomic_store_explicit(&(var), (value), memory_order_relaxed)
+#else
+#define SLOG_ATOMIC(type) volatile type
+#define SLOG_ATOMIC_LOAD(var) (var)
+#define SLOG_ATOMIC_STORE(var, value) ((var) = (value))
+#endif
+
+/* Levels that currently reach an output, mirrored from the config without locking */
+extern SLOG_ATOMIC(uint16_t) g_nSlogFlags;
+
+#define SLOG_ENABLED(eFlag) \
+    (((SLOG_COMPILED_FLAGS) & (eFlag)) && SLOG_UNLIKELY(SLOG_FLAGS_CHECK(SLOG_ATOMIC_LOAD(g_nSlogFlags), (eFlag))))
+
+/* Arguments are only evaluated when the level is enabled */
+#define slog_display_if(eFlag, nNewLine, ...) \
+    do { if (SLOG_ENABLED(eFlag)) slog_display(eFlag, nNewLine, __VA_ARGS__); } while (0)
+
 /* Slog function definitions */
-#define slog(...) slog_display(SLOG_NOTAG, 1, __VA_ARGS__)
-#define slog_note(...) slog_display(SLOG_NOTE, 1, __VA_ARGS__)
-#define slog_info(...) slog_display(SLOG_INFO, 1, __VA_ARGS__)
-#define slog_warn(...) slog_display(SLOG_WARN, 1, __VA_ARGS__)
-#define slog_debug(...) slog_display(SLOG_DEBUG, 1, __VA_ARGS__)
-#define slog_error(...) slog_display(SLOG_ERROR, 1, __VA_ARGS__)
-#define slog_trace(...) slog_display(SLOG_TRACE, 1, SLOG_THROW_LOCATION __VA_ARGS__)
-#define slog_fatal(...) slog_display(SLOG_FATAL, 1, SLOG_THROW_LOCATION __VA_ARGS__)
+#define slog(...) slog_display_if(SLOG_NOTAG, 1, __VA_ARGS__)
+#define slog_note(...) slog_display_if(SLOG_NOTE, 1, __VA_ARGS__)
+#define slog_info(...) slog_display_if(SLOG_INFO, 1, __VA_ARGS__)
+#define slog_warn(...) slog_display_if(SLOG_WARN, 1, __VA_ARGS__)
+#define slog_debug(...) slog_display_if(SLOG_DEBUG, 1, __VA_ARGS__)
+#define slog_error(...) slog_display_if(SLOG_ERROR, 1, __VA_ARGS__)
+#define slog_trace(...) slog_display_if(SLOG_TRACE, 1, SLOG_THROW_LOCATION __VA_ARGS__)
+#define slog_fatal(...) slog_display_if(SLOG_FATAL, 1, SLOG_THROW_LOCATION __VA_ARGS__)
 
 /* No new line definitions */
-#define slog_wn(...) slog_display(SLOG_NOTAG, 0, __VA_ARGS__)
-#define slog_note_wn(...) slog_display(SLOG_NOTE, 0, __VA_ARGS__)
-#define slog_info_wn(...) slog_display(SLOG_INFO, 0, __VA_ARGS__)
-#define slog_warn_wn(...) slog_display(SLOG_WARN, 0, __VA_ARGS__)
-#define slog_debug_wn(...) slog_display(SLOG_DEBUG, 0, __VA_ARGS__)
-#define slog_error_wn(...) slog_display(SLOG_ERROR, 0, __VA_ARGS__)
-#define slog_trace_wn(...) slog_display(SLOG_TRACE, 0, SLOG_THROW_LOCATION __VA_ARGS__)
-#define slog_fatal_wn(...) slog_display(SLOG_FATAL, 0, SLOG_THROW_LOCATION __VA_ARGS__)
+#define slog_wn(...) slog_display_if(SLOG_NOTAG, 0, __VA_ARGS__)
+#define slog_note_wn(...) slog_display_if(SLOG_NOTE, 0, __VA_ARGS__)
+#define slog_info_wn(...) slog_display_if(SLOG_INFO, 0, __VA_ARGS__)
+#define slog_warn_wn(...) slog_display_if(SLOG_WARN, 0, __VA_ARGS__)
+#define slog_debug_wn(...) slog_display_if(SLOG_DEBUG, 0, __VA_ARGS__)
+#define slog_error_wn(...) slog_display_if(SLOG_ERROR, 0, __VA_ARGS__)
+#define slog_trace_wn(...) slog_display_if(SLOG_TRACE, 0, SLOG_THROW_LOCATION __VA_ARGS__)
+#define slog_fatal_wn(...) slog_display_if(SLOG_FATAL, 0, SLOG_THROW_LOCATION __VA_ARGS__)
 
 /* Short name definitions */
 #define slogn(...) slog_note(__VA_ARGS__)
@@ -155,6 +199,48 @@ typedef enum
 #define slogt_wn(...) slog_trace_wn(__VA_ARGS__)
 #define slogf_wn(...) slog_fatal_wn(__VA_ARGS__)
 
+/*
+ * Per call site state of the rate limited and sampled macros, updated
+ * without locks so busy call sites on several threads do not serialize.
+ * The number of dropped messages is reported with the first message shown
+ * after them: for slog_ratelimit() the first one of the next interval.
+ */
+typedef struct slog_limit {
+    SLOG_ATOMIC(uint64_t) nStart;       // Start of the current interval in ms, 0 before the first message
+    SLOG_ATOMIC(uint32_t) nCount;       // Messages seen in the interval or in total
+    SLOG_ATOMIC(uint32_t) nSuppressed;  // Messages dropped since the last one shown
+} slog_limit_t;
+
+uint8_t slog_limit_interval(slog_limit_t *pLimit, uint32_t nBurst, uint32_t nIntervalMs, uint32_t *pSuppressed);
+uint8_t slog_limit_every(slog_limit_t *pLimit, uint32_t nEvery, uint32_t *pSuppressed);
+
+#define slog_display_limited(eFlag, check, ...) \
+    do { \
+        if (SLOG_ENABLED(eFlag)) { \
+            static slog_limit_t slogLimit; \
+            uint32_t nSlogSuppressed = 0; \
+            if (check) { \
+                if (nSlogSuppressed) slog_display(eFlag, 1, SLOG_THROW_LOCATION "%u similar messages suppressed", nSlogSuppressed); \
+                slog_display(eFlag, 1, __VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+
+/* At most nBurst messages per nIntervalMs from this call site */
+#define slog_ratelimit(eFlag, nBurst, nIntervalMs, ...) \
+    slog_display_limited(eFlag, slog_limit_interval(&slogLimit, nBurst, nIntervalMs, &nSlogSuppressed), __VA_ARGS__)
+
+/* The 1st, (nEvery + 1)th, (2 * nEvery + 1)th ... message from this call site */
+#define slog_every(eFlag, nEvery, ...) \
+    slog_display_limited(eFlag, slog_limit_every(&slogLimit, nEvery, &nSlogSuppressed), __VA_ARGS__)
+
+#define slogw_limit(nBurst, nIntervalMs, ...) slog_ratelimit(SLOG_WARN, nBurst, nIntervalMs, __VA_ARGS__)
+#define sloge_limit(nBurst, nIntervalMs, ...) slog_ratelimit(SLOG_ERROR, nBurst, nIntervalMs, __VA_ARGS__)
+#define slogf_limit(nBurst, nIntervalMs, ...) slog_ratelimit(SLOG_FATAL, nBurst, nIntervalMs, SLOG_THROW_LOCATION __VA_ARGS__)
+#define slogw_every(nEvery, ...) slog_every(SLOG_WARN, nEvery, __VA_ARGS__)
+#define sloge_every(nEvery, ...) slog_every(SLOG_ERROR, nEvery, __VA_ARGS__)
+#define slogf_every(nEvery, ...) slog_every(SLOG_FATAL, nEvery, SLOG_THROW_LOCATION __VA_ARGS__)
+
 typedef struct SLogConfig {
     slog_date_ctrl_t eDateControl;      // Display output with date format
     slog_coloring_t eColorFormat;       // Output color format control
@@ -191,6 +277,40 @@ void slog_init(const char* pName, uint16_t nFlags, uint8_t nTdSafe);
 void slog_display(slog_flag_t eFlag, uint8_t nNewLine, const char *pFormat, ...);
 void slog_destroy(); // Required only if (nTdSafe > 0 || nKeepOpen > 0)
 
+/*
+ * Asynchronous mode: each logging thread renders its lines into its own
+ * queue of nRecords slots (lines are cut at SLOG_ASYNC_LINE_MAX), without
+ * taking the slog mutex. A writer thread merges the queues by timestamp and
+ * does the screen, file and callback output, in timestamp order: a line
+ * waits while another thread is still rendering an older one. The printed
+ * time is taken when the line is queued. Messages are dropped and
+ * counted when a queue is full. Fatal messages, and threads beyond the
+ * first 32 with a queue, are written synchronously. slog_config_set() and
+ * the other setters wait for lines being rendered. Lines logged meanwhile
+ * are written synchronously with the new settings, ahead of queued ones.
+ */
+int slog_async_start(size_t nRecords);
+void slog_async_stop(); // Drains the queue, called by slog_destroy()
+
+/*
+ * Binary mode: messages of the levels in nFlags are not formatted, their
+ * timestamp, thread, format string id and raw arguments are appended to
+ * pPath through an nBufferSize stdio buffer. Render them with tools/slog_decode.
+ */
+int slog_binary_open(const char *pPath, uint16_t nFlags, size_t nBufferSize);
+void slog_binary_flush();
+void slog_binary_close(); // Called by slog_destroy()
+
+/*
+ * Buffered file output: file lines are copied into an nBufferSize buffer and
+ * a writer thread writes it out when it is full or nFlushMs after the last
+ * write, opens the file and does the daily rotation. A line longer than the
+ * buffer is passed through it in pieces, never cut. Logging threads do no
+ * file system calls, fatal messages wait until they reached the file.
+ */
+int slog_file_sink_start(size_t nBufferSize, uint32_t nFlushMs);
+void slog_file_sink_stop(); // Writes out the buffer, called by slog_destroy()
+
 #ifdef __cplusplus
 }
 #endif
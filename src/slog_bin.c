@@ -0,0 +1,140 @@
+/*
+ * Rendering of binary slog records (see slog_bin.h), used by the offline
+ * decoder (tools/slog_decode.c) and the unit tests.
+ */
+
+#include "slog_bin.h"
+
+typedef struct
+{
+    const uint8_t *data;
+    size_t         size;
+    size_t         pos;
+} payload_t;
+
+static int take(payload_t *p, void *out, size_t size)
+{
+    if (p->pos + size > p->size)
+    {
+        return 0;
+    }
+    memcpy(out, p->data + p->pos, size);
+    p->pos += size;
+    return 1;
+}
+
+/* Copies a conversion without its length modifier, optionally forcing "ll" */
+static void rewrite_spec(const slog_bin_spec_t *spec, int as_long_long, char *out, size_t size)
+{
+    size_t n = 0;
+
+    for (size_t i = 0; i + 1 < spec->nLength && n + 4 < size; i++)
+    {
+        char c = spec->pStart[i];
+        if (i > 0 && strchr("hljztLq", c))
+        {
+            continue;
+        }
+        out[n++] = c;
+    }
+    if (as_long_long)
+    {
+        out[n++] = 'l';
+        out[n++] = 'l';
+    }
+    out[n++] = spec->cConv;
+    out[n]   = '\0';
+}
+
+#define PRINT_SPEC(out, fmt, nstars, stars, value)                   \
+    do                                                               \
+    {                                                                \
+        if ((nstars) == 2)                                           \
+            fprintf((out), (fmt), (stars)[0], (stars)[1], (value));  \
+        else if ((nstars) == 1)                                      \
+            fprintf((out), (fmt), (stars)[0], (value));              \
+        else                                                         \
+            fprintf((out), (fmt), (value));                          \
+    } while (0)
+
+void slog_bin_render(FILE *pOut, const char *pFormat, const uint8_t *pArgs, size_t nSize)
+{
+    const char     *p    = pFormat, *next;
+    payload_t       args = {pArgs, nSize, 0};
+    slog_bin_spec_t spec;
+    char            fmt[64];
+
+    while ((next = slog_bin_next_spec(p, &spec)) != NULL)
+    {
+        fwrite(p, 1, (size_t)(spec.pStart - p), pOut);
+        p = next;
+
+        if (spec.cConv == '%')
+        {
+            fputc('%', pOut);
+            continue;
+        }
+
+        int     stars[2] = {0, 0};
+        int64_t star = 0, value;
+        double  fvalue;
+        int     ok = 1;
+
+        for (uint8_t i = 0; i < spec.nStars; i++)
+        {
+            ok       = ok && take(&args, &star, sizeof(star));
+            stars[i] = (int)star;
+        }
+
+        switch (spec.cConv)
+        {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            if (!(ok && take(&args, &value, sizeof(value))))
+                break;
+            rewrite_spec(&spec, 1, fmt, sizeof(fmt));
+            PRINT_SPEC(pOut, fmt, spec.nStars, stars, (long long)value);
+            continue;
+        case 'c':
+            if (!(ok && take(&args, &value, sizeof(value))))
+                break;
+            rewrite_spec(&spec, 0, fmt, sizeof(fmt));
+            PRINT_SPEC(pOut, fmt, spec.nStars, stars, (int)value);
+            continue;
+        case 'p':
+            if (!(ok && take(&args, &value, sizeof(value))))
+                break;
+            rewrite_spec(&spec, 0, fmt, sizeof(fmt));
+            PRINT_SPEC(pOut, fmt, spec.nStars, stars, (void *)(uintptr_t)value);
+            continue;
+        case 's':
+        {
+            uint16_t len;
+            char     str[SLOG_BIN_PAYLOAD_MAX + 1];
+            if (!(ok && take(&args, &len, sizeof(len)) && len <= SLOG_BIN_PAYLOAD_MAX && take(&args, str, len)))
+                break;
+            str[len] = '\0';
+            rewrite_spec(&spec, 0, fmt, sizeof(fmt));
+            PRINT_SPEC(pOut, fmt, spec.nStars, stars, str);
+            continue;
+        }
+        case 'n':
+            continue;
+        default:
+            if (!slog_bin_is_float(spec.cConv) || !(ok && take(&args, &fvalue, sizeof(fvalue))))
+                break;
+            rewrite_spec(&spec, 0, fmt, sizeof(fmt));
+            PRINT_SPEC(pOut, fmt, spec.nStars, stars, fvalue);
+            continue;
+        }
+
+        // Argument missing from a truncated record
+        fputs("<?>", pOut);
+    }
+
+    fputs(p, pOut);
+}
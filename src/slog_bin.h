@@ -0,0 +1,108 @@
+/*
+ * Binary slog records, shared by slog.c and the offline decoder (tools/slog_decode.c).
+ *
+ * A binary log starts with SLOG_BIN_MAGIC followed by records. Each record is a
+ * slog_bin_header_t and nPayload bytes:
+ *  - SLOG_BIN_FORMAT: the NUL terminated format string registered as nFormatId,
+ *    written the first time a format is used.
+ *  - SLOG_BIN_MESSAGE: the raw arguments of one message, in format order. Each
+ *    '*' width/precision and each integer, character or pointer argument is an
+ *    int64_t, floating point arguments are doubles, strings are a uint16_t
+ *    length followed by the characters (at most the precision of the %s).
+ * Values are stored in host byte order. Format ids are assigned per distinct
+ * format text, so formats built at run time in a reused buffer decode right.
+ */
+
+#ifndef __SLOG_BIN_H__
+#define __SLOG_BIN_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SLOG_BIN_MAGIC          "SLOGBIN1"
+#define SLOG_BIN_PAYLOAD_MAX    1024
+#define SLOG_BIN_FORMATS_MAX    4096
+
+#define SLOG_BIN_FORMAT         'F'
+#define SLOG_BIN_MESSAGE        'M'
+
+#define SLOG_BIN_PRECISION_NONE -1
+#define SLOG_BIN_PRECISION_STAR -2      // Taken from the last '*' argument
+
+typedef struct slog_bin_header {
+    uint8_t nType;
+    uint8_t nFlag;
+    uint16_t nPayload;
+    uint32_t nFormatId;
+    uint64_t nTime;                     // CLOCK_REALTIME in nanoseconds
+    uint32_t nTid;
+    uint32_t nReserved;
+} slog_bin_header_t;
+
+typedef struct slog_bin_spec {
+    const char *pStart;                 // The '%' of the conversion
+    size_t nLength;                     // Characters up to and including the conversion
+    uint8_t nStars;                     // '*' arguments in front of the value
+    int32_t nPrecision;                 // Digits after '.', or SLOG_BIN_PRECISION_NONE/STAR
+    char cLength;                       // 'H' hh, 'h', 'l', 'q' ll, 'j', 'z', 't', 'L' or 0
+    char cConv;                         // Conversion character, '%' for a literal percent
+} slog_bin_spec_t;
+
+/* Finds the next conversion in pFormat, returns NULL when there is none */
+static inline const char *slog_bin_next_spec(const char *pFormat, slog_bin_spec_t *pSpec)
+{
+    const char *p = strchr(pFormat, '%');
+    if (p == NULL) return NULL;
+
+    pSpec->pStart = p++;
+    pSpec->nStars = 0;
+    pSpec->nPrecision = SLOG_BIN_PRECISION_NONE;
+    pSpec->cLength = 0;
+
+    while (*p && strchr("-+ #0'", *p)) p++;
+    if (*p == '*') { pSpec->nStars++; p++; }
+    while (*p >= '0' && *p <= '9') p++;
+
+    if (*p == '.')
+    {
+        p++;
+        pSpec->nPrecision = 0;
+        if (*p == '*') { pSpec->nStars++; pSpec->nPrecision = SLOG_BIN_PRECISION_STAR; p++; }
+        while (*p >= '0' && *p <= '9')
+        {
+            if (pSpec->nPrecision < 0xFFFF) pSpec->nPrecision = pSpec->nPrecision * 10 + (*p - '0');
+            p++;
+        }
+    }
+
+    if (*p == 'h' || *p == 'l')
+    {
+        pSpec->cLength = (p[1] == *p) ? (*p == 'h' ? 'H' : 'q') : *p;
+        p += (p[1] == *p) ? 2 : 1;
+    }
+    else if (*p && strchr("jztL", *p))
+    {
+        pSpec->cLength = *p++;
+    }
+
+    pSpec->cConv = *p;
+    if (*p) p++;
+
+    pSpec->nLength = (size_t)(p - pSpec->pStart);
+    return p;
+}
+
+static inline int slog_bin_is_float(char cConv)
+{
+    return cConv && strchr("fFeEgGaA", cConv) != NULL;
+}
+
+/*
+ * Prints the message described by pFormat and the packed arguments in pArgs
+ * to pOut. Arguments missing from a truncated record are printed as "<?>".
+ */
+void slog_bin_render(FILE *pOut, const char *pFormat, const uint8_t *pArgs, size_t nSize);
+
+#endif /* __SLOG_BIN_H__ */
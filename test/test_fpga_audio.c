@@ -0,0 +1,154 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "unity.h"
+#include "unity_fixture.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "fpga_audio.h"
+
+/* 8 kHz, 2 channels, 10 ms periods, 20 ms latency */
+#define RATE    8000
+#define PERIOD  80
+#define LATENCY 160
+
+static int pipe_fd[2];
+
+static void push_frames(int first, int count)
+{
+    fpga_sample_t sample;
+    memset(&sample, 0, sizeof(sample));
+
+    for (int i = first; i < first + count; i++)
+    {
+        sample.smp[0] = i;
+        sample.smp[1] = -i;
+        TEST_ASSERT_EQUAL_INT(0, FPGA_Audio_Push(&sample));
+    }
+}
+
+/* Frames taken from the ring so far */
+static uint64_t frames_written(void)
+{
+    fpga_audio_stats_t stats;
+    FPGA_Audio_GetStats(&stats);
+    return stats.frames_out - stats.underruns;
+}
+
+static int wait_written(uint64_t frames)
+{
+    struct timespec step = {.tv_nsec = 1000 * 1000};
+
+    for (int i = 0; i < 2000 && frames_written() < frames; i++)
+    {
+        nanosleep(&step, NULL);
+    }
+    return frames_written() == frames;
+}
+
+static int wait_underrun(void)
+{
+    struct timespec    step = {.tv_nsec = 1000 * 1000};
+    fpga_audio_stats_t stats;
+
+    for (int i = 0; i < 2000; i++)
+    {
+        FPGA_Audio_GetStats(&stats);
+        if (stats.underruns != 0)
+        {
+            return 1;
+        }
+        nanosleep(&step, NULL);
+    }
+    return 0;
+}
+
+static void read_frames(int32_t *frames, size_t count)
+{
+    size_t want = count * 2 * sizeof(int32_t);
+    size_t got  = 0;
+
+    while (got < want)
+    {
+        ssize_t n = read(pipe_fd[0], (uint8_t *)frames + got, want - got);
+        TEST_ASSERT_TRUE(n > 0);
+        got += (size_t)n;
+    }
+}
+
+TEST_GROUP(FPGA_Audio);
+
+TEST_SETUP(FPGA_Audio)
+{
+    TEST_ASSERT_EQUAL_INT(0, pipe(pipe_fd));
+
+    fpga_audio_config_t cfg = {.fd = pipe_fd[1], .rate_hz = RATE, .channels = 2, .latency_frames = LATENCY, .period_frames = PERIOD};
+    TEST_ASSERT_EQUAL_INT(0, FPGA_Audio_Start(&cfg));
+}
+
+TEST_TEAR_DOWN(FPGA_Audio)
+{
+    // Drain so the writer is never blocked on a full pipe when it is stopped
+    char drain[4096];
+    fcntl(pipe_fd[0], F_SETFL, O_NONBLOCK);
+    while (read(pipe_fd[0], drain, sizeof(drain)) > 0)
+    {
+    }
+    FPGA_Audio_Stop();
+    close(pipe_fd[0]);
+    close(pipe_fd[1]);
+}
+
+TEST(FPGA_Audio, frames_come_out_in_order_and_a_full_ring_drops)
+{
+    static int32_t frames[(LATENCY + PERIOD) * 2];
+    fpga_sample_t  sample;
+
+    push_frames(0, LATENCY + PERIOD);
+    memset(&sample, 0, sizeof(sample));
+    TEST_ASSERT_EQUAL_INT(-ENOSPC, FPGA_Audio_Push(&sample));
+
+    read_frames(frames, LATENCY + PERIOD);
+    for (int i = 0; i < LATENCY + PERIOD; i++)
+    {
+        TEST_ASSERT_EQUAL_INT32(i, frames[2 * i]);
+        TEST_ASSERT_EQUAL_INT32(-i, frames[2 * i + 1]);
+    }
+
+    fpga_audio_stats_t stats;
+    FPGA_Audio_GetStats(&stats);
+    TEST_ASSERT_EQUAL_UINT64(LATENCY + PERIOD, stats.frames_in);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.overruns);
+}
+
+TEST(FPGA_Audio, underrun_waits_for_the_full_latency_again)
+{
+    struct timespec five_periods = {.tv_nsec = 50 * 1000 * 1000};
+    int32_t         frame[2];
+
+    push_frames(0, LATENCY);
+    TEST_ASSERT_TRUE(wait_written(LATENCY));
+    TEST_ASSERT_TRUE(wait_underrun());
+
+    // Below the latency nothing is taken from the ring, the sink gets silence
+    push_frames(LATENCY, LATENCY - PERIOD);
+    nanosleep(&five_periods, NULL);
+    TEST_ASSERT_EQUAL_UINT64(LATENCY, frames_written());
+
+    push_frames(2 * LATENCY - PERIOD, PERIOD);
+    TEST_ASSERT_TRUE(wait_written(2 * LATENCY));
+
+    fpga_audio_stats_t stats;
+    FPGA_Audio_GetStats(&stats);
+    TEST_ASSERT_TRUE(stats.underruns >= 5 * PERIOD);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.underruns % PERIOD);
+
+    read_frames(frame, 1);
+    TEST_ASSERT_EQUAL_INT32(0, frame[0]);
+}
@@ -0,0 +1,141 @@
+#include "unity.h"
+#include "unity_fixture.h"
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+
+#include "fpga_clock.h"
+#include "fpga_interface.h"
+#include "qspi.h"
+#include "qspi_sched.h"
+
+#define NSEC_PER_SEC 1000000000LL
+
+/* Seconds and nanoseconds of RD_MST_CLK, equal so the time reads the same
+   whether the RX watermark drains RFDR[0] twice or RFDR[0] and RFDR[1] */
+#define FPGA_WORD 100
+#define FPGA_NS   (FPGA_WORD * NSEC_PER_SEC + FPGA_WORD)
+
+static FlexSPI_Type *regs;
+static int64_t       offset_ns;
+
+static int64_t reference(void *ctx)
+{
+    (void)ctx;
+    return FPGA_NS - offset_ns; // The reference lags the FPGA by offset_ns
+}
+
+static fpga_clock_config_t config(void)
+{
+    fpga_clock_config_t cfg = {
+        .interval_ms       = 1000,
+        .kp                = 0.5,
+        .ki                = 0.1,
+        .step_threshold_ns = 1000000,
+        .max_ppb           = 1000,
+        .reference         = reference,
+    };
+    return cfg;
+}
+
+/* One measurement: RD_MST_CLK, then the WR_MST_CLK it produced */
+static void measure(int64_t offset, fpga_mst_clk_adj_t *adj)
+{
+    fpga_clock_config_t cfg = config();
+
+    offset_ns     = offset;
+    regs->RFDR[0] = FPGA_WORD;
+    regs->RFDR[1] = FPGA_WORD;
+
+    TEST_ASSERT_EQUAL_INT(0, FPGA_Clock_Init(&cfg));
+    FPGA_Clock_Poll();
+    // The read callback queues the write, the same dispatch runs it
+    TEST_ASSERT_EQUAL_INT(2, QSPI_Sched_Dispatch());
+    TEST_ASSERT_EQUAL_HEX32((FPGA_LUT_IDX_WR_MST_CLK << 16) | sizeof(*adj), regs->IPCR1);
+
+    memcpy(adj, (const void *)regs->TFDR, sizeof(*adj));
+}
+
+TEST_GROUP(FPGA_Clock);
+
+TEST_SETUP(FPGA_Clock)
+{
+    qspi_sched_config_t cfg = {.guard_us = 20, .bytes_per_us = 4, .setup_us = 5};
+
+    regs = QSPI_InitSimulated();
+    QSPI_Sched_Config(&cfg);
+}
+
+TEST_TEAR_DOWN(FPGA_Clock)
+{
+    QSPI_Sched_Dispatch();
+    QSPI_DeInit();
+}
+
+TEST(FPGA_Clock, rejects_settings_that_cannot_converge)
+{
+    fpga_clock_config_t cfg;
+
+    cfg             = config();
+    cfg.interval_ms = 0;
+    TEST_ASSERT_EQUAL_INT(-EINVAL, FPGA_Clock_Init(&cfg));
+    cfg                   = config();
+    cfg.step_threshold_ns = 0;
+    TEST_ASSERT_EQUAL_INT(-EINVAL, FPGA_Clock_Init(&cfg));
+    cfg         = config();
+    cfg.max_ppb = -1;
+    TEST_ASSERT_EQUAL_INT(-EINVAL, FPGA_Clock_Init(&cfg));
+    cfg    = config();
+    cfg.kp = -0.5;
+    TEST_ASSERT_EQUAL_INT(-EINVAL, FPGA_Clock_Init(&cfg));
+    cfg    = config();
+    cfg.ki = NAN;
+    TEST_ASSERT_EQUAL_INT(-EINVAL, FPGA_Clock_Init(&cfg));
+
+    cfg = config();
+    TEST_ASSERT_EQUAL_INT(0, FPGA_Clock_Init(&cfg));
+}
+
+TEST(FPGA_Clock, small_offset_is_slewed_by_the_pi_terms)
+{
+    fpga_mst_clk_adj_t  adj;
+    fpga_clock_status_t status;
+
+    // 100 ns over 1 s: kp 50 ppb plus ki 10 ppb, trimmed against the offset
+    measure(100, &adj);
+    TEST_ASSERT_EQUAL_INT32(-60, adj.freq_ppb);
+    TEST_ASSERT_EQUAL_INT32(0, adj.step_ns);
+
+    FPGA_Clock_GetStatus(&status);
+    TEST_ASSERT_EQUAL_INT64(100, status.offset_ns);
+    TEST_ASSERT_EQUAL_INT32(-60, status.freq_ppb);
+    TEST_ASSERT_EQUAL_UINT32(1, status.samples);
+    TEST_ASSERT_EQUAL_UINT32(0, status.steps);
+
+    // A clock running behind is sped up
+    measure(-100, &adj);
+    TEST_ASSERT_EQUAL_INT32(60, adj.freq_ppb);
+}
+
+TEST(FPGA_Clock, trim_is_limited_to_max_ppb)
+{
+    fpga_mst_clk_adj_t adj;
+
+    measure(50000, &adj);
+    TEST_ASSERT_EQUAL_INT32(-1000, adj.freq_ppb);
+    TEST_ASSERT_EQUAL_INT32(0, adj.step_ns);
+}
+
+TEST(FPGA_Clock, offset_past_the_threshold_is_stepped)
+{
+    fpga_mst_clk_adj_t  adj;
+    fpga_clock_status_t status;
+
+    measure(2000000, &adj);
+    TEST_ASSERT_EQUAL_INT32(0, adj.freq_ppb);
+    TEST_ASSERT_EQUAL_INT32(-2000000, adj.step_ns);
+
+    FPGA_Clock_GetStatus(&status);
+    TEST_ASSERT_EQUAL_UINT32(1, status.steps);
+}
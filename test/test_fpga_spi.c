@@ -0,0 +1,64 @@
+#include "unity.h"
+#include "unity_fixture.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include "fpga_interface.h"
+#include "fpga_spi.h"
+#include "qspi.h"
+
+static FlexSPI_Type *regs;
+
+TEST_GROUP(FPGA_SPI);
+
+TEST_SETUP(FPGA_SPI)
+{
+    regs = QSPI_InitSimulated();
+}
+
+TEST_TEAR_DOWN(FPGA_SPI)
+{
+    QSPI_DeInit();
+}
+
+TEST(FPGA_SPI, tx_only_transfer_is_framed_into_one_write)
+{
+    uint8_t             tx[] = {0xAA, 0xBB};
+    fpga_spi_transfer_t xfer = {.tx_buf = (uintptr_t)tx, .len = sizeof(tx), .cs_change = 1, .delay_usecs = 1000};
+
+    TEST_ASSERT_EQUAL_INT(2, FPGA_SPI_Transfer(FPGA_SPI_BUS2, &xfer, 1));
+
+    TEST_ASSERT_EQUAL_HEX32((FPGA_LUT_IDX_WR_SPI2 << 16) | 6, regs->IPCR1);
+    TEST_ASSERT_EQUAL_HEX32(0xFF010002, regs->TFDR[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x0000BBAA, regs->TFDR[1]);
+}
+
+TEST(FPGA_SPI, rx_of_a_batch_is_read_once_and_scattered)
+{
+    uint8_t             tx[] = {0x9F};
+    uint8_t             rx1[2], rx2[2];
+    fpga_spi_transfer_t xfers[] = {
+        {.tx_buf = (uintptr_t)tx,  .len = 1},
+        {.rx_buf = (uintptr_t)rx1, .len = 2},
+        {.rx_buf = (uintptr_t)rx2, .len = 2},
+    };
+
+    regs->RFDR[0] = 0x44332211;
+
+    TEST_ASSERT_EQUAL_INT(5, FPGA_SPI_Transfer(FPGA_SPI_BUS1, xfers, 3));
+
+    TEST_ASSERT_EQUAL_HEX32((FPGA_LUT_IDX_RD_SPI1 << 16) | 4, regs->IPCR1);
+    TEST_ASSERT_EQUAL_HEX8(0x11, rx1[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x22, rx1[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x33, rx2[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x44, rx2[1]);
+}
+
+TEST(FPGA_SPI, oversized_transfer_is_rejected)
+{
+    static uint8_t      tx[QSPI_MAX_TRANSFER_SIZE];
+    fpga_spi_transfer_t xfer = {.tx_buf = (uintptr_t)tx, .len = sizeof(tx)};
+
+    TEST_ASSERT_EQUAL_INT(-EMSGSIZE, FPGA_SPI_Transfer(FPGA_SPI_BUS1, &xfer, 1));
+}
@@ -3,6 +3,20 @@
 static void runAllTests(void)
 {
     RUN_TEST_GROUP(QSPI_Functional);
+    RUN_TEST_GROUP(FPGA_SPI);
+    RUN_TEST_GROUP(QSPI_Coalesce);
+    RUN_TEST_GROUP(QSPI_Sched);
+    RUN_TEST_GROUP(QSPI_Recorder);
+    RUN_TEST_GROUP(QSPI_Status);
+    RUN_TEST_GROUP(QSPI_Phase);
+    RUN_TEST_GROUP(QSPI_Metrics);
+    RUN_TEST_GROUP(QSPI_Perf);
+    RUN_TEST_GROUP(QSPI_Trace);
+    RUN_TEST_GROUP(QSPI_Sweep);
+    RUN_TEST_GROUP(QSPI_Watermark);
+    RUN_TEST_GROUP(FPGA_Clock);
+    RUN_TEST_GROUP(FPGA_Audio);
+    RUN_TEST_GROUP(Slog);
 }
 
 int main(int argc, const char *argv[]) {
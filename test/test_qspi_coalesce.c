@@ -0,0 +1,60 @@
+#include "unity.h"
+#include "unity_fixture.h"
+
+#include "qspi.h"
+#include "qspi_coalesce.h"
+
+static FlexSPI_Type *regs;
+
+TEST_GROUP(QSPI_Coalesce);
+
+TEST_SETUP(QSPI_Coalesce)
+{
+    qspi_coalesce_config_t cfg = {.window_us = 1000000, .max_bytes = QSPI_MAX_TRANSFER_SIZE};
+
+    regs = QSPI_InitSimulated();
+    QSPI_Coalesce_Config(&cfg);
+}
+
+TEST_TEAR_DOWN(QSPI_Coalesce)
+{
+    QSPI_Coalesce_Flush();
+    QSPI_DeInit();
+}
+
+TEST(QSPI_Coalesce, register_writes_keep_only_the_last_value)
+{
+    uint32_t first = 0x11111111, last = 0x22222222;
+
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Coalesce_Write(FPGA_LUT_IDX_WR_DCU_OUT, 0, (uint8_t *)&first, sizeof(first)));
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Coalesce_Write(FPGA_LUT_IDX_WR_DCU_OUT, 0, (uint8_t *)&last, sizeof(last)));
+    TEST_ASSERT_EQUAL_HEX32(0, regs->IPCR1);
+
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Coalesce_Flush());
+    TEST_ASSERT_EQUAL_HEX32((FPGA_LUT_IDX_WR_DCU_OUT << 16) | 4, regs->IPCR1);
+    TEST_ASSERT_EQUAL_HEX32(last, regs->TFDR[0]);
+}
+
+TEST(QSPI_Coalesce, command_writes_are_concatenated)
+{
+    uint32_t a = 0xAAAAAAAA, b = 0xBBBBBBBB;
+
+    QSPI_Coalesce_Write(FPGA_LUT_IDX_WR_GENERIC_CMD, 0, (uint8_t *)&a, sizeof(a));
+    QSPI_Coalesce_Write(FPGA_LUT_IDX_WR_GENERIC_CMD, 0, (uint8_t *)&b, sizeof(b));
+    QSPI_Coalesce_Flush();
+
+    TEST_ASSERT_EQUAL_HEX32((FPGA_LUT_IDX_WR_GENERIC_CMD << 16) | 8, regs->IPCR1);
+    TEST_ASSERT_EQUAL_HEX32(a, regs->TFDR[0]);
+    TEST_ASSERT_EQUAL_HEX32(b, regs->TFDR[1]);
+}
+
+TEST(QSPI_Coalesce, other_opcode_flushes_the_pending_write)
+{
+    uint32_t dcu = 0x12345678, cmd = 0x9ABCDEF0;
+
+    QSPI_Coalesce_Write(FPGA_LUT_IDX_WR_DCU_OUT, 0, (uint8_t *)&dcu, sizeof(dcu));
+    QSPI_Coalesce_Write(FPGA_LUT_IDX_WR_GENERIC_CMD, 0, (uint8_t *)&cmd, sizeof(cmd));
+
+    TEST_ASSERT_EQUAL_HEX32((FPGA_LUT_IDX_WR_DCU_OUT << 16) | 4, regs->IPCR1);
+    TEST_ASSERT_EQUAL_HEX32(dcu, regs->TFDR[0]);
+}
@@ -0,0 +1,130 @@
+#include "unity.h"
+#include "unity_fixture.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include "qspi.h"
+#include "qspi_metrics.h"
+
+TEST_GROUP(QSPI_Metrics);
+
+TEST_SETUP(QSPI_Metrics)
+{
+    QSPI_InitSimulated();
+    QSPI_Metrics_Reset();
+}
+
+TEST_TEAR_DOWN(QSPI_Metrics)
+{
+    QSPI_Metrics_SetStallThreshold(0);
+    QSPI_Metrics_Unpublish();
+    QSPI_DeInit();
+}
+
+TEST(QSPI_Metrics, transfers_are_counted_per_opcode)
+{
+    uint8_t data[40] = {0};
+
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Write(0, FPGA_LUT_IDX_WR_SPI2, data, sizeof(data)));
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Write(0, FPGA_LUT_IDX_WR_SPI2, data, 8));
+    TEST_ASSERT_EQUAL_INT(0, QSPI_ReadSample(0, data, 16));
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Write(0, 31, data, 4));
+
+    const qspi_metrics_op_t *spi2 = &qspi_metrics->op[FPGA_LUT_IDX_WR_SPI2];
+    TEST_ASSERT_EQUAL_UINT64(2, atomic_load(&spi2->commands));
+    TEST_ASSERT_EQUAL_UINT64(sizeof(data) + 8, atomic_load(&spi2->bytes));
+    TEST_ASSERT_EQUAL_UINT64(0, atomic_load(&spi2->errors));
+    TEST_ASSERT_EQUAL_UINT64(16, atomic_load(&qspi_metrics->op[FPGA_LUT_IDX_RD_SAMPLE].bytes));
+    TEST_ASSERT_EQUAL_UINT64(1, atomic_load(&qspi_metrics->op[QSPI_METRICS_OTHER].commands));
+}
+
+TEST(QSPI_Metrics, spin_waits_are_counted_per_site_and_flagged_as_stalls)
+{
+    uint8_t data[16] = {0};
+
+    QSPI_Metrics_SetStallThreshold(1);
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Write(0, FPGA_LUT_IDX_WR_SPI1, data, sizeof(data)));
+    TEST_ASSERT_EQUAL_INT(0, QSPI_ReadSample(0, data, 4));
+
+    // Both 8-byte TX chunks fit the empty FIFO at once, one RX chunk, one completion wait per command
+    const qspi_metrics_wait_t *wait = qspi_metrics->wait;
+    TEST_ASSERT_EQUAL_UINT64(1, atomic_load(&wait[QSPI_WAIT_TX_EMPTY].waits));
+    TEST_ASSERT_EQUAL_UINT64(1, atomic_load(&wait[QSPI_WAIT_RX_WATERMARK].waits));
+    TEST_ASSERT_EQUAL_UINT64(2, atomic_load(&wait[QSPI_WAIT_CMD_DONE].waits));
+
+    // The simulated flags are always set, no poll ever misses
+    TEST_ASSERT_EQUAL_UINT64(0, atomic_load(&wait[QSPI_WAIT_CMD_DONE].spins));
+    TEST_ASSERT_EQUAL_UINT64(2, atomic_load(&wait[QSPI_WAIT_CMD_DONE].stalls));
+    TEST_ASSERT_TRUE(atomic_load(&wait[QSPI_WAIT_CMD_DONE].max_cycles) > 0);
+
+    QSPI_Metrics_SetStallThreshold(0);
+    TEST_ASSERT_EQUAL_INT(0, QSPI_ReadSample(0, data, 4));
+    TEST_ASSERT_EQUAL_UINT64(2, atomic_load(&wait[QSPI_WAIT_CMD_DONE].stalls));
+}
+
+TEST(QSPI_Metrics, command_errors_fail_the_transfer_and_are_counted)
+{
+    uint8_t data[32] = {0};
+
+    QSPI_SimulateFault(1U << 3); // IPCMDERR
+    TEST_ASSERT_EQUAL_INT(-EIO, QSPI_Write(0, FPGA_LUT_IDX_WR_UART1, data, 8));
+    TEST_ASSERT_EQUAL_UINT64(1, atomic_load(&qspi_metrics->op[FPGA_LUT_IDX_WR_UART1].errors));
+
+    // Left pending for QSPI_Busy(), which reports it without counting it again
+    TEST_ASSERT_EQUAL_INT(-1, QSPI_Busy());
+    TEST_ASSERT_EQUAL_UINT64(1, atomic_load(&qspi_metrics->op[FPGA_LUT_IDX_WR_UART1].errors));
+
+    // Several RX watermark chunks, acknowledging them must not clear the error
+    TEST_ASSERT_EQUAL_INT(-EIO, QSPI_ReadSample(0, data, sizeof(data)));
+    TEST_ASSERT_EQUAL_UINT64(1, atomic_load(&qspi_metrics->op[FPGA_LUT_IDX_RD_SAMPLE].errors));
+
+    QSPI_SimulateFault(0);
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Write(0, FPGA_LUT_IDX_WR_UART1, data, 8));
+    TEST_ASSERT_EQUAL_INT(0, QSPI_ReadSample(0, data, sizeof(data)));
+    TEST_ASSERT_EQUAL_UINT64(2, atomic_load(&qspi_metrics->op[FPGA_LUT_IDX_WR_UART1].commands));
+    TEST_ASSERT_EQUAL_UINT64(1, atomic_load(&qspi_metrics->op[FPGA_LUT_IDX_WR_UART1].errors));
+    TEST_ASSERT_EQUAL_UINT64(1, atomic_load(&qspi_metrics->op[FPGA_LUT_IDX_RD_SAMPLE].errors));
+}
+
+TEST(QSPI_Metrics, error_raised_after_a_clean_transfer_is_counted_once_by_busy)
+{
+    FlexSPI_Type *regs    = QSPI_InitSimulated();
+    uint8_t       data[8] = {0};
+
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Write(0, FPGA_LUT_IDX_WR_UART1, data, sizeof(data)));
+    regs->INTR |= 1U << 3; // IPCMDERR, after the transfer has returned
+
+    TEST_ASSERT_EQUAL_INT(-1, QSPI_Busy());
+    TEST_ASSERT_EQUAL_INT(-1, QSPI_Busy());
+    TEST_ASSERT_EQUAL_UINT64(1, atomic_load(&qspi_metrics->op[FPGA_LUT_IDX_WR_UART1].errors));
+}
+
+TEST(QSPI_Metrics, published_block_is_readable_from_the_segment)
+{
+    uint8_t data[8] = {0};
+    char    text[16384];
+
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Write(0, FPGA_LUT_IDX_WR_UART1, data, sizeof(data)));
+    if (QSPI_Metrics_Publish() != 0)
+    {
+        TEST_IGNORE_MESSAGE("POSIX shared memory unavailable");
+    }
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Write(0, FPGA_LUT_IDX_WR_UART1, data, sizeof(data)));
+
+    const qspi_metrics_t *reader = QSPI_Metrics_Attach();
+    TEST_ASSERT_NOT_NULL(reader);
+    TEST_ASSERT_EQUAL_UINT64(2, atomic_load(&reader->op[FPGA_LUT_IDX_WR_UART1].commands));
+
+    FILE *out = tmpfile();
+    TEST_ASSERT_NOT_NULL(out);
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Metrics_WriteText(reader, out));
+    rewind(out);
+    text[fread(text, 1, sizeof(text) - 1, out)] = '\0';
+    fclose(out);
+    QSPI_Metrics_Detach(reader);
+
+    TEST_ASSERT_NOT_NULL(strstr(text, "qspi_bytes_total{opcode=\"WR_UART1\"} 16\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "# TYPE qspi_commands_total counter\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "qspi_wait_total{site=\"tx_empty\"} 2\n"));
+}
@@ -0,0 +1,141 @@
+#include "unity.h"
+#include "unity_fixture.h"
+
+#include "cycles.h"
+#include "fpga_interface.h"
+#include "qspi.h"
+#include "qspi_recorder.h"
+#include "slog.h"
+
+/*
+ * Cost budgets of the hot paths on the simulated backend.
+ *
+ * Register accesses and log calls are counted exactly, so a change that adds
+ * either fails here. Lower the budgets when an optimisation removes some.
+ * The time budgets are the best of PERF_RUNS calls and generous enough for
+ * loaded hosts and valgrind; they only catch gross regressions.
+ */
+
+#define PERF_RUNS 50
+
+#define SAMPLE_MMIO_BUDGET   55  // QSPI_ReadSample() of one fpga_sample_t
+#define ADAPTIVE_MMIO_BUDGET 37  // The same in QSPI_WATERMARK_ADAPTIVE, a single drain
+#define WRITE_MMIO_BUDGET    401 // QSPI_Write() of 1 KiB
+#define LUT_MMIO_BUDGET      84  // QSPI_SetupLut() of the FPGA LUT
+
+#define SAMPLE_LOG_BUDGET 6 // With every slog level enabled
+#define WRITE_LOG_BUDGET  3
+#define LUT_LOG_BUDGET    2
+
+#define SAMPLE_NS_BUDGET (1000 * 1000)
+#define WRITE_NS_BUDGET  (5 * 1000 * 1000)
+#define LUT_NS_BUDGET    (1000 * 1000)
+
+typedef void (*perf_op_t)(void);
+
+static uint8_t       payload[1024];
+static fpga_sample_t sample;
+static int           log_calls;
+
+static void op_sample_read(void)
+{
+    TEST_ASSERT_EQUAL_INT(0, QSPI_ReadSample(0, &sample, sizeof(sample)));
+}
+
+static void op_write_1k(void)
+{
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Write(0, FPGA_LUT_IDX_WR_SPI1, payload, sizeof(payload)));
+}
+
+static void op_lut_upload(void)
+{
+    QSPI_SetupLut((uint32_t *)fpga_lut, sizeof(fpga_lut));
+}
+
+static int count_log(const char *pLog, size_t nLength, slog_flag_t eFlag, void *pCtx)
+{
+    (void)pLog;
+    (void)nLength;
+    (void)eFlag;
+    (void)pCtx;
+    log_calls++;
+    return -1;
+}
+
+static uint64_t mmio_accesses(perf_op_t op)
+{
+    uint64_t head = atomic_load(&qspi_recorder_head);
+    op();
+    return atomic_load(&qspi_recorder_head) - head;
+}
+
+static int logs_emitted(perf_op_t op)
+{
+    slog_init("perf", SLOG_FLAGS_ALL, 0);
+    slog_callback_set(count_log, NULL);
+
+    slog_config_t cfg;
+    slog_config_get(&cfg);
+    cfg.nToScreen = 0;
+    slog_config_set(&cfg);
+
+    log_calls = 0;
+    op();
+    int calls = log_calls;
+
+    slog_destroy();
+    return calls;
+}
+
+static uint64_t best_ns(perf_op_t op)
+{
+    uint64_t best = UINT64_MAX;
+
+    for (int i = 0; i < PERF_RUNS; i++)
+    {
+        uint64_t start   = now_ns();
+        op();
+        uint64_t elapsed = now_ns() - start;
+        best             = elapsed < best ? elapsed : best;
+    }
+    return best;
+}
+
+TEST_GROUP(QSPI_Perf);
+
+TEST_SETUP(QSPI_Perf)
+{
+    QSPI_InitSimulated();
+}
+
+TEST_TEAR_DOWN(QSPI_Perf)
+{
+    QSPI_DeInit();
+}
+
+TEST(QSPI_Perf, register_accesses_stay_within_budget)
+{
+#ifdef QSPI_NO_RECORDER
+    TEST_IGNORE_MESSAGE("Register accesses are counted by the recorder");
+#endif
+    TEST_ASSERT_LESS_OR_EQUAL_UINT64(SAMPLE_MMIO_BUDGET, mmio_accesses(op_sample_read));
+    TEST_ASSERT_LESS_OR_EQUAL_UINT64(WRITE_MMIO_BUDGET, mmio_accesses(op_write_1k));
+    TEST_ASSERT_LESS_OR_EQUAL_UINT64(LUT_MMIO_BUDGET, mmio_accesses(op_lut_upload));
+
+    QSPI_SetWatermarkMode(QSPI_WATERMARK_ADAPTIVE);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT64(ADAPTIVE_MMIO_BUDGET, mmio_accesses(op_sample_read));
+}
+
+TEST(QSPI_Perf, log_calls_stay_within_budget)
+{
+    TEST_ASSERT_LESS_OR_EQUAL_INT(SAMPLE_LOG_BUDGET, logs_emitted(op_sample_read));
+    TEST_ASSERT_LESS_OR_EQUAL_INT(WRITE_LOG_BUDGET, logs_emitted(op_write_1k));
+    TEST_ASSERT_LESS_OR_EQUAL_INT(LUT_LOG_BUDGET, logs_emitted(op_lut_upload));
+}
+
+TEST(QSPI_Perf, latency_stays_within_budget)
+{
+    TEST_ASSERT_LESS_OR_EQUAL_UINT64(SAMPLE_NS_BUDGET, best_ns(op_sample_read));
+    TEST_ASSERT_LESS_OR_EQUAL_UINT64(WRITE_NS_BUDGET, best_ns(op_write_1k));
+    TEST_ASSERT_LESS_OR_EQUAL_UINT64(LUT_NS_BUDGET, best_ns(op_lut_upload));
+}
@@ -0,0 +1,58 @@
+#include "unity.h"
+#include "unity_fixture.h"
+
+#include "qspi.h"
+#include "qspi_phase.h"
+
+TEST_GROUP(QSPI_Phase);
+
+TEST_SETUP(QSPI_Phase)
+{
+    QSPI_InitSimulated();
+    QSPI_Phase_Reset();
+}
+
+TEST_TEAR_DOWN(QSPI_Phase)
+{
+    QSPI_DeInit();
+}
+
+TEST(QSPI_Phase, write_records_every_phase_and_one_sample_per_refill)
+{
+    uint8_t data[64] = {0};
+    qspi_phase_summary_t summary;
+
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Write(0, 0, data, sizeof(data)));
+
+    // The simulated TX FIFO is always empty, so all 8-byte chunks go in one refill
+    QSPI_Phase_Summary(QSPI_PHASE_FIFO_COPY, &summary);
+    TEST_ASSERT_EQUAL_UINT64(1, summary.count);
+    QSPI_Phase_Summary(QSPI_PHASE_FIFO_WAIT, &summary);
+    TEST_ASSERT_EQUAL_UINT64(1, summary.count);
+
+    QSPI_Phase_Summary(QSPI_PHASE_SETUP, &summary);
+    TEST_ASSERT_EQUAL_UINT64(1, summary.count);
+    QSPI_Phase_Summary(QSPI_PHASE_KICK, &summary);
+    TEST_ASSERT_EQUAL_UINT64(1, summary.count);
+    QSPI_Phase_Summary(QSPI_PHASE_DONE, &summary);
+    TEST_ASSERT_EQUAL_UINT64(1, summary.count);
+    QSPI_Phase_Summary(QSPI_PHASE_TOTAL, &summary);
+    TEST_ASSERT_EQUAL_UINT64(1, summary.count);
+    TEST_ASSERT_TRUE(summary.max > 0);
+}
+
+TEST(QSPI_Phase, percentiles_are_within_one_sub_bucket)
+{
+    for (uint64_t v = 1; v <= 1000; v++)
+    {
+        QSPI_Phase_Record(QSPI_PHASE_TOTAL, v * 100);
+    }
+
+    uint64_t p50 = QSPI_Phase_Percentile(QSPI_PHASE_TOTAL, 50);
+    uint64_t p99 = QSPI_Phase_Percentile(QSPI_PHASE_TOTAL, 99);
+
+    TEST_ASSERT_UINT64_WITHIN(50000 / QSPI_PHASE_SUB_BUCKETS, 50000, p50);
+    TEST_ASSERT_UINT64_WITHIN(99000 / QSPI_PHASE_SUB_BUCKETS, 99000, p99);
+    TEST_ASSERT_TRUE(p50 <= 50000 && p99 <= 99000);
+    TEST_ASSERT_EQUAL_UINT64(0, QSPI_Phase_Percentile(QSPI_PHASE_SETUP, 50));
+}
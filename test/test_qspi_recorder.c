@@ -0,0 +1,110 @@
+#include "unity.h"
+#include "unity_fixture.h"
+
+#include <pthread.h>
+#include <time.h>
+
+#include "qspi.h"
+#include "qspi_recorder.h"
+
+#define FSPI_ADDR(REG) (FLEXSPI_BASE + (uint32_t)offsetof(FlexSPI_Type, REG))
+
+static qspi_recorder_entry_t entries[QSPI_RECORDER_ENTRIES];
+
+TEST_GROUP(QSPI_Recorder);
+
+TEST_SETUP(QSPI_Recorder)
+{
+    QSPI_InitSimulated();
+    QSPI_Recorder_Reset();
+}
+
+TEST_TEAR_DOWN(QSPI_Recorder)
+{
+    QSPI_DeInit();
+}
+
+TEST(QSPI_Recorder, write_records_the_command_and_fifo_accesses)
+{
+    uint32_t data = 0xCAFEF00D;
+
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Write(0x1234, 0, (uint8_t *)&data, sizeof(data)));
+
+    size_t count = QSPI_Recorder_Snapshot(entries, QSPI_RECORDER_ENTRIES);
+    int    seen_addr = 0, seen_data = 0, seen_cmd = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (entries[i].dir != QSPI_RECORDER_WRITE)
+        {
+            continue;
+        }
+        seen_addr |= entries[i].addr == FSPI_ADDR(IPCR0) && entries[i].value == 0x1234;
+        seen_data |= entries[i].addr == FSPI_ADDR(TFDR[0]) && entries[i].value == data;
+        seen_cmd |= entries[i].addr == FSPI_ADDR(IPCMD) && seen_addr && !seen_data;
+    }
+
+    TEST_ASSERT_TRUE(seen_addr);
+    TEST_ASSERT_TRUE(seen_data);
+    TEST_ASSERT_TRUE(seen_cmd);
+}
+
+TEST(QSPI_Recorder, ring_keeps_the_newest_accesses)
+{
+    uint32_t data = 0;
+
+    uint64_t start = atomic_load(&qspi_recorder_head);
+    while (atomic_load(&qspi_recorder_head) - start < 2 * QSPI_RECORDER_ENTRIES)
+    {
+        QSPI_Write(0, 0, (uint8_t *)&data, sizeof(data));
+    }
+
+    size_t count = QSPI_Recorder_Snapshot(entries, QSPI_RECORDER_ENTRIES);
+    TEST_ASSERT_EQUAL_UINT(QSPI_RECORDER_ENTRIES, count);
+    TEST_ASSERT_EQUAL_UINT64(atomic_load(&qspi_recorder_head), atomic_load(&entries[count - 1].seq));
+    TEST_ASSERT_TRUE(entries[0].cycles <= entries[count - 1].cycles);
+}
+
+/* Lets the driver spin on an empty RX FIFO for a while, then fills it */
+static void *fill_rx_fifo(void *arg)
+{
+    FlexSPI_Type   *regs = arg;
+    struct timespec wait = {.tv_nsec = 5 * 1000 * 1000};
+
+    nanosleep(&wait, NULL);
+    *(volatile uint32_t *)&regs->IPRXFSTS = 16;
+    return NULL;
+}
+
+TEST(QSPI_Recorder, a_stalled_wait_is_a_single_entry)
+{
+    FlexSPI_Type *regs = QSPI_InitSimulated();
+    uint8_t       buffer[4]; // Below the RX watermark, waited for on IPRXFSTS
+    pthread_t     thread;
+
+    uint64_t head = atomic_load(&qspi_recorder_head);
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Read(0, buffer, sizeof(buffer)));
+    uint64_t idle = atomic_load(&qspi_recorder_head) - head;
+
+    regs->IPRXFSTS = 0;
+    QSPI_Recorder_Reset();
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&thread, NULL, fill_rx_fifo, regs));
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Read(0, buffer, sizeof(buffer)));
+    pthread_join(thread, NULL);
+
+    size_t count = QSPI_Recorder_Snapshot(entries, QSPI_RECORDER_ENTRIES);
+    TEST_ASSERT_EQUAL_UINT(idle, count);
+
+    size_t polls = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (entries[i].dir == QSPI_RECORDER_POLL && entries[i].addr == FSPI_ADDR(IPRXFSTS))
+        {
+            TEST_ASSERT_EQUAL_HEX32(0, entries[i].first);
+            TEST_ASSERT_EQUAL_HEX32(16, entries[i].value);
+            TEST_ASSERT_GREATER_THAN_UINT32(0, entries[i].spins);
+            polls++;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT(1, polls);
+}
@@ -0,0 +1,118 @@
+#include "unity.h"
+#include "unity_fixture.h"
+
+#include <string.h>
+#include <time.h>
+
+#include "fpga_interface.h"
+#include "qspi.h"
+#include "qspi_sched.h"
+
+static uint32_t         payload[QSPI_MAX_TRANSFER_SIZE / sizeof(uint32_t)];
+static qspi_sched_req_t order[4];
+static int              completed;
+
+static void record(qspi_sched_req_t *req, int result)
+{
+    (void)result;
+    order[completed++] = *req;
+}
+
+static void init_req(qspi_sched_req_t *req, qspi_sched_class_t cls, uint8_t seq, uint16_t size)
+{
+    memset(req, 0, sizeof(*req));
+    req->cls            = cls;
+    req->done           = record;
+    req->xfer.cmdType   = kFLEXSPI_Write;
+    req->xfer.seqIndex  = seq;
+    req->xfer.SeqNumber = 1;
+    req->xfer.data      = payload;
+    req->xfer.dataSize  = size;
+}
+
+TEST_GROUP(QSPI_Sched);
+
+TEST_SETUP(QSPI_Sched)
+{
+    qspi_sched_config_t cfg = {.guard_us = 100, .bytes_per_us = 1, .setup_us = 5};
+
+    QSPI_InitSimulated();
+    QSPI_Sched_Config(&cfg);
+    completed = 0;
+}
+
+TEST_TEAR_DOWN(QSPI_Sched)
+{
+    // The scheduler is process-wide, leave it empty and without a sample deadline
+    qspi_sched_config_t cfg = {.guard_us = 20, .bytes_per_us = 4, .setup_us = 5};
+    QSPI_Sched_Config(&cfg);
+    QSPI_Sched_Dispatch();
+    QSPI_DeInit();
+}
+
+TEST(QSPI_Sched, higher_class_is_dispatched_first)
+{
+    qspi_sched_req_t bulk, control;
+    init_req(&bulk, QSPI_SCHED_BULK, FPGA_LUT_IDX_WR_UART1, 64);
+    init_req(&control, QSPI_SCHED_CONTROL, FPGA_LUT_IDX_WR_DCU_OUT, 4);
+
+    QSPI_Sched_Submit(&bulk);
+    QSPI_Sched_Submit(&control);
+    TEST_ASSERT_EQUAL_UINT(2, QSPI_Sched_Depth());
+
+    TEST_ASSERT_EQUAL_INT(2, QSPI_Sched_Dispatch());
+    TEST_ASSERT_EQUAL_INT(FPGA_LUT_IDX_WR_DCU_OUT, order[0].xfer.seqIndex);
+    TEST_ASSERT_EQUAL_INT(FPGA_LUT_IDX_WR_UART1, order[1].xfer.seqIndex);
+    TEST_ASSERT_EQUAL_UINT(0, QSPI_Sched_Depth());
+}
+
+TEST(QSPI_Sched, transfer_that_would_miss_the_sample_deadline_waits)
+{
+    qspi_sched_config_t     cfg   = {.sample_period_us = 10000, .guard_us = 100, .bytes_per_us = 1, .setup_us = 5};
+    struct timespec         delay = {.tv_nsec = 9000 * 1000};
+    fpga_sample_t           sample;
+    static qspi_sched_req_t bulk;
+
+    QSPI_Sched_Config(&cfg);
+    init_req(&bulk, QSPI_SCHED_BULK, FPGA_LUT_IDX_WR_UART1, 1000);
+    QSPI_Sched_Submit(&bulk);
+
+    // 1105 us with the guard fit a period, but not the at most 1000 us left of it
+    QSPI_Sched_SampleRead(0, &sample, sizeof(sample));
+    nanosleep(&delay, NULL);
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Sched_Dispatch());
+    TEST_ASSERT_EQUAL_UINT(1, QSPI_Sched_Depth());
+
+    QSPI_Sched_SampleRead(0, &sample, sizeof(sample));
+    TEST_ASSERT_EQUAL_INT(1, QSPI_Sched_Dispatch());
+    TEST_ASSERT_EQUAL_INT(FPGA_LUT_IDX_WR_UART1, order[0].xfer.seqIndex);
+}
+
+TEST(QSPI_Sched, oversized_transfer_runs_right_after_a_sample_read)
+{
+    qspi_sched_config_t     cfg = {.sample_period_us = 1000, .guard_us = 100, .bytes_per_us = 1, .setup_us = 5};
+    fpga_sample_t           sample;
+    static qspi_sched_req_t bulk, budget, control;
+
+    cfg.budget_bytes[QSPI_SCHED_CONTROL] = 16;
+    QSPI_Sched_Config(&cfg);
+    init_req(&bulk, QSPI_SCHED_BULK, FPGA_LUT_IDX_WR_UART1, QSPI_MAX_TRANSFER_SIZE);
+    init_req(&budget, QSPI_SCHED_CONTROL, FPGA_LUT_IDX_WR_GENERIC_CMD, 32);
+    init_req(&control, QSPI_SCHED_CONTROL, FPGA_LUT_IDX_WR_DCU_OUT, 4);
+    QSPI_Sched_Submit(&bulk);
+    QSPI_Sched_Submit(&budget);
+    QSPI_Sched_Submit(&control);
+
+    // Neither ever passes the checks: 1129 us > 1000 us period, 32 bytes > 16 byte budget.
+    // One oversized request per period, the control write behind it is over budget then.
+    QSPI_Sched_SampleRead(0, &sample, sizeof(sample));
+    TEST_ASSERT_EQUAL_INT(1, QSPI_Sched_Dispatch());
+    TEST_ASSERT_EQUAL_INT(FPGA_LUT_IDX_WR_GENERIC_CMD, order[0].xfer.seqIndex);
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Sched_Dispatch());
+
+    QSPI_Sched_SampleRead(0, &sample, sizeof(sample));
+    TEST_ASSERT_EQUAL_INT(2, QSPI_Sched_Dispatch());
+    TEST_ASSERT_EQUAL_INT(FPGA_LUT_IDX_WR_UART1, order[1].xfer.seqIndex);
+    TEST_ASSERT_EQUAL_INT(FPGA_LUT_IDX_WR_DCU_OUT, order[2].xfer.seqIndex);
+    TEST_ASSERT_EQUAL_UINT(0, QSPI_Sched_Depth());
+}
@@ -0,0 +1,121 @@
+#include "unity.h"
+#include "unity_fixture.h"
+
+#include <stddef.h>
+
+#include "qspi.h"
+#include "qspi_recorder.h"
+#include "slog.h"
+
+#define FSPI_ADDR(REG) (FLEXSPI_BASE + (uint32_t)offsetof(FlexSPI_Type, REG))
+
+static FlexSPI_Type *regs;
+static int           calls;
+static qspi_status_t last;
+
+static void on_status(const qspi_status_t *cur, const qspi_status_t *prev, uint32_t changed, void *ctx)
+{
+    (void)prev;
+    (void)changed;
+    (*(int *)ctx)++;
+    last = *cur;
+}
+
+/* Unsubscribes itself, which deadlocked while callbacks ran under the subscriber lock */
+static void once(const qspi_status_t *cur, const qspi_status_t *prev, uint32_t changed, void *ctx)
+{
+    (void)cur;
+    (void)prev;
+    (void)changed;
+    (*(int *)ctx)++;
+    QSPI_Status_Unsubscribe(once, ctx);
+}
+
+static int quiet_log(const char *pLog, size_t nLength, slog_flag_t eFlag, void *pCtx)
+{
+    (void)pLog;
+    (void)nLength;
+    (void)eFlag;
+    (void)pCtx;
+    return -1;
+}
+
+TEST_GROUP(QSPI_Status);
+
+TEST_SETUP(QSPI_Status)
+{
+    regs  = QSPI_InitSimulated();
+    calls = 0;
+}
+
+TEST_TEAR_DOWN(QSPI_Status)
+{
+    QSPI_Status_Unsubscribe(on_status, &calls);
+    QSPI_DeInit();
+}
+
+TEST(QSPI_Status, subscribers_get_a_snapshot_after_each_transfer)
+{
+    uint32_t data = 0;
+
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Status_Subscribe(on_status, &calls));
+    regs->IPTXFSTS = 0x00010002;
+
+    QSPI_Write(0, 0, (uint8_t *)&data, sizeof(data));
+    QSPI_Read(0, (uint8_t *)&data, sizeof(data));
+
+    TEST_ASSERT_EQUAL_INT(2, calls);
+    TEST_ASSERT_EQUAL_HEX32(regs->INTR, last.intr);
+    TEST_ASSERT_EQUAL_HEX32(0x00010002, last.iptxfsts);
+
+    QSPI_Status_Unsubscribe(on_status, &calls);
+    QSPI_Write(0, 0, (uint8_t *)&data, sizeof(data));
+    TEST_ASSERT_EQUAL_INT(2, calls);
+}
+
+TEST(QSPI_Status, diff_reports_the_changed_registers)
+{
+    qspi_status_t a, b;
+
+    QSPI_Status_Read(&a);
+    regs->STS1     = 0x0000000F;
+    regs->IPRXFSTS = 0x00000004;
+    QSPI_Status_Read(&b);
+
+    TEST_ASSERT_EQUAL_HEX32(QSPI_STATUS_STS1 | QSPI_STATUS_IPRXFSTS, QSPI_Status_Diff(&a, &b));
+    TEST_ASSERT_EQUAL_HEX32(0, QSPI_Status_Diff(&b, &b));
+}
+
+TEST(QSPI_Status, callback_may_unsubscribe_itself)
+{
+    uint32_t data = 0;
+
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Status_Subscribe(once, &calls));
+    QSPI_Write(0, 0, (uint8_t *)&data, sizeof(data));
+    QSPI_Write(0, 0, (uint8_t *)&data, sizeof(data));
+    TEST_ASSERT_EQUAL_INT(1, calls);
+}
+
+TEST(QSPI_Status, block_is_not_read_without_subscribers_even_with_trace_logging)
+{
+    static qspi_recorder_entry_t entries[QSPI_RECORDER_ENTRIES];
+    uint32_t                     data = 0;
+    slog_config_t                cfg;
+
+    slog_init("status", SLOG_FLAGS_ALL, 0);
+    slog_callback_set(quiet_log, NULL);
+    slog_config_get(&cfg);
+    cfg.nToScreen = 0;
+    slog_config_set(&cfg);
+
+    QSPI_Recorder_Reset();
+    QSPI_Write(0, 0, (uint8_t *)&data, sizeof(data));
+    slog_destroy();
+
+    size_t count = QSPI_Recorder_Snapshot(entries, QSPI_RECORDER_ENTRIES);
+    TEST_ASSERT_GREATER_THAN(0, count);
+    for (size_t i = 0; i < count; i++)
+    {
+        TEST_ASSERT_NOT_EQUAL_UINT32(FSPI_ADDR(AHBSPNDSTS), entries[i].addr); // Only read for the status block
+    }
+}
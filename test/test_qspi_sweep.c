@@ -0,0 +1,94 @@
+#include "unity.h"
+#include "unity_fixture.h"
+
+#include <errno.h>
+
+#include "fpga_interface.h"
+#include "qspi.h"
+#include "qspi_sweep.h"
+
+static qspi_sweep_config_t cfg;
+static qspi_sweep_result_t results[16];
+
+TEST_GROUP(QSPI_Sweep);
+
+TEST_SETUP(QSPI_Sweep)
+{
+    QSPI_InitSimulated();
+
+    QSPI_Sweep_Defaults(&cfg);
+    cfg.iterations = 3;
+    cfg.wr_seq     = FPGA_LUT_IDX_WR_SPI1;
+    cfg.rd_seq     = FPGA_LUT_IDX_RD_SPI1;
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Sweep_ParseList("7,1", &cfg.post));
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Sweep_ParseList("1,16", &cfg.tx_wm));
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Sweep_ParseList("2", &cfg.rx_wm));
+}
+
+TEST_TEAR_DOWN(QSPI_Sweep)
+{
+    QSPI_DeInit();
+}
+
+TEST(QSPI_Sweep, settings_are_validated_and_restored_after_the_sweep)
+{
+    FlexSPI_Type *regs = QSPI_InitSimulated();
+    uint32_t      mux, pre, post, tx, rx;
+
+    TEST_ASSERT_EQUAL_INT(-EINVAL, QSPI_SetWatermarks(0, 1));
+    TEST_ASSERT_EQUAL_INT(-EINVAL, QSPI_SetWatermarks(1, QSPI_WATERMARK_MAX + 1));
+    TEST_ASSERT_EQUAL_INT(-EINVAL, QSPI_SetClock(8, 0, 7));
+    TEST_ASSERT_EQUAL_INT(-EINVAL, QSPI_Sweep_ParseList("1,,2", &cfg.mux));
+
+    qspi_sweep_config_t defaults;
+    QSPI_Sweep_Defaults(&defaults);
+    TEST_ASSERT_EQUAL_INT(-EINVAL, QSPI_Sweep_Run(&defaults, results, lengthof(results)));
+
+    TEST_ASSERT_EQUAL_INT(0, QSPI_SetWatermarks(4, 8));
+    TEST_ASSERT_EQUAL_HEX32(3 << 2, regs->IPTXFCR);
+    TEST_ASSERT_EQUAL_HEX32(7 << 2, regs->IPRXFCR);
+    TEST_ASSERT_EQUAL_INT(0, QSPI_SetClock(2, 1, 5));
+
+    TEST_ASSERT_EQUAL_INT(4, QSPI_Sweep_Run(&cfg, results, 16));
+
+    QSPI_GetWatermarks(&tx, &rx);
+    QSPI_GetClock(&mux, &pre, &post);
+    TEST_ASSERT_EQUAL_UINT32(4, tx);
+    TEST_ASSERT_EQUAL_UINT32(8, rx);
+    TEST_ASSERT_EQUAL_UINT32(2, mux);
+    TEST_ASSERT_EQUAL_UINT32(1, pre);
+    TEST_ASSERT_EQUAL_UINT32(5, post);
+}
+
+TEST(QSPI_Sweep, every_setting_runs_the_workload_and_mismatches_count_as_errors)
+{
+    TEST_ASSERT_EQUAL_size_t(4, QSPI_Sweep_Count(&cfg));
+    TEST_ASSERT_EQUAL_INT(4, QSPI_Sweep_Run(&cfg, results, 16));
+
+    TEST_ASSERT_EQUAL_UINT32(7, results[0].post);
+    TEST_ASSERT_EQUAL_UINT32(16, results[1].tx_wm);
+    TEST_ASSERT_EQUAL_UINT32(1, results[3].post);
+    for (int i = 0; i < 4; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(2, results[i].rx_wm);
+        TEST_ASSERT_EQUAL_UINT32(6, results[i].commands);
+        TEST_ASSERT_EQUAL_UINT32(0, results[i].errors);
+        TEST_ASSERT_TRUE(results[i].write_mbps > 0.0);
+    }
+
+    // Nothing loops back in the simulated block, so every read fails verification
+    cfg.verify = 1;
+    TEST_ASSERT_EQUAL_INT(2, QSPI_Sweep_Run(&cfg, results, 2));
+    TEST_ASSERT_EQUAL_UINT32(3, results[0].mismatches);
+    TEST_ASSERT_EQUAL_UINT32(3, results[0].errors);
+}
+
+TEST(QSPI_Sweep, command_errors_count_in_the_error_rate)
+{
+    QSPI_InitSimulated();
+    QSPI_SimulateFault(1U << 1); // IPCMDGE
+    TEST_ASSERT_EQUAL_INT(1, QSPI_Sweep_Run(&cfg, results, 1));
+    TEST_ASSERT_EQUAL_UINT32(6, results[0].commands);
+    TEST_ASSERT_EQUAL_UINT32(6, results[0].errors);
+    TEST_ASSERT_EQUAL_UINT32(0, results[0].mismatches);
+}
@@ -0,0 +1,84 @@
+#include "unity.h"
+#include "unity_fixture.h"
+
+#include <string.h>
+
+#include "fpga_interface.h"
+#include "qspi.h"
+#include "qspi_sched.h"
+#include "qspi_trace.h"
+
+static char json[16384];
+
+/* Renders the trace into json, returns its length */
+static size_t render(void)
+{
+    FILE *out = tmpfile();
+    TEST_ASSERT_NOT_NULL(out);
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Trace_Write(out));
+    rewind(out);
+    size_t len = fread(json, 1, sizeof(json) - 1, out);
+    json[len]  = '\0';
+    fclose(out);
+    return len;
+}
+
+TEST_GROUP(QSPI_Trace);
+
+TEST_SETUP(QSPI_Trace)
+{
+    QSPI_InitSimulated();
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Trace_Start(64));
+}
+
+TEST_TEAR_DOWN(QSPI_Trace)
+{
+    QSPI_Trace_Free();
+    QSPI_DeInit();
+}
+
+TEST(QSPI_Trace, scheduled_transfer_shows_depth_dispatch_and_opcode)
+{
+    uint8_t          data[16] = {0};
+    qspi_sched_req_t req;
+
+    memset(&req, 0, sizeof(req));
+    req.cls                = QSPI_SCHED_CONTROL;
+    req.xfer.port          = kFlexSPI_PortA1;
+    req.xfer.cmdType       = kFLEXSPI_Write;
+    req.xfer.seqIndex      = FPGA_LUT_IDX_WR_UART2;
+    req.xfer.SeqNumber     = 1;
+    req.xfer.data          = (uint32_t *)data;
+    req.xfer.dataSize      = sizeof(data);
+
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Sched_Submit(&req));
+    TEST_ASSERT_EQUAL_INT(1, QSPI_Sched_Dispatch());
+    QSPI_Trace_Stop();
+    render();
+
+    TEST_ASSERT_EQUAL_STRING_LEN("{\"displayTimeUnit\"", json, 18);
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"name\":\"queue_depth\",\"ph\":\"C\""));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"name\":\"dispatch\",\"cat\":\"sched\""));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"name\":\"WR_UART2\",\"cat\":\"transfer\",\"ph\":\"X\""));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"size\":16"));
+    TEST_ASSERT_EQUAL_STRING("\n]}\n", json + strlen(json) - 4);
+}
+
+TEST(QSPI_Trace, ring_keeps_the_newest_events_and_nothing_after_stop)
+{
+    uint8_t data[4] = {0};
+
+    // Only the transfers count towards the overwritten events, a preempted spin wait would add a stall
+    qspi_trace_stall_cycles = UINT64_MAX;
+    for (int i = 0; i < 100; i++)
+    {
+        QSPI_Write(0, (uint8_t)(i < 90 ? FPGA_LUT_IDX_WR_SPI1 : FPGA_LUT_IDX_WR_SPI2), data, sizeof(data));
+    }
+    QSPI_Trace_Stop();
+    QSPI_Write(0, FPGA_LUT_IDX_WR_UART1, data, sizeof(data));
+    render();
+
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"overwritten\":36"));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"name\":\"WR_SPI2\""));
+    TEST_ASSERT_NULL(strstr(json, "\"name\":\"WR_UART1\""));
+}
@@ -0,0 +1,156 @@
+#include "unity.h"
+#include "unity_fixture.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "fpga_interface.h"
+#include "qspi.h"
+#include "qspi_recorder.h"
+
+#define WTR(LEVEL) (((LEVEL) - 1U) << 2) // IPTXFCR/IPRXFCR watermark field
+
+#define FSPI_ADDR(REG)  (FLEXSPI_BASE + (uint32_t)offsetof(FlexSPI_Type, REG))
+#define TX_FIFO_ENTRIES (QSPI_MAX_TRANSFER_SIZE / 8U)
+
+/* Accesses of a write besides its FIFO refills: FLSHCR2, clearing INTR/STS0/STS1,
+   IPCR0, IPTXFCR, IPRXFCR, IPCR1, IPCMD, the IPCMDDONE poll and its acknowledge */
+#define WRITE_SETUP_ACCESSES 16U
+/* One IPTXFSTS poll per refill, then per level its TFDR words and the IPTXWE push */
+#define WRITE_ACCESSES(LEVELS, WM, REFILLS) (WRITE_SETUP_ACCESSES + (REFILLS) + (LEVELS) * (2U * (WM) + 1U))
+
+static FlexSPI_Type         *regs;
+static uint8_t               payload[1024];
+static qspi_recorder_entry_t entries[QSPI_RECORDER_ENTRIES];
+
+static uint64_t write_accesses(void)
+{
+    uint64_t head = atomic_load(&qspi_recorder_head);
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Write(0, FPGA_LUT_IDX_WR_SPI1, payload, sizeof(payload)));
+    return atomic_load(&qspi_recorder_head) - head;
+}
+
+TEST_GROUP(QSPI_Watermark);
+
+TEST_SETUP(QSPI_Watermark)
+{
+    regs = QSPI_InitSimulated();
+}
+
+TEST_TEAR_DOWN(QSPI_Watermark)
+{
+    QSPI_DeInit();
+}
+
+TEST(QSPI_Watermark, rx_chunks_are_whole_64bit_entries)
+{
+    uint8_t  buffer[20];
+    uint32_t words[5];
+
+    regs->RFDR[0] = 0x11111111;
+    regs->RFDR[1] = 0x22222222;
+    regs->RFDR[2] = 0x33333333;
+
+    // The simulated FIFO window never advances, so every chunk restarts at RFDR[0]
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Read(0, buffer, sizeof(buffer)));
+    memcpy(words, buffer, sizeof(words));
+    TEST_ASSERT_EQUAL_HEX32(0x11111111, words[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x22222222, words[1]);
+    TEST_ASSERT_EQUAL_HEX32(0x11111111, words[2]);
+    TEST_ASSERT_EQUAL_HEX32(0x22222222, words[3]);
+    TEST_ASSERT_EQUAL_HEX32(0x11111111, words[4]); // Tail below the watermark
+    TEST_ASSERT_EQUAL_HEX32(WTR(1) | 1U, regs->IPRXFCR);
+
+    TEST_ASSERT_EQUAL_INT(0, QSPI_SetWatermarks(2, 2));
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Read(0, buffer, sizeof(buffer)));
+    memcpy(words, buffer, sizeof(words));
+    TEST_ASSERT_EQUAL_HEX32(0x33333333, words[2]);
+    TEST_ASSERT_EQUAL_HEX32(0x11111111, words[4]);
+    TEST_ASSERT_EQUAL_HEX32(WTR(2) | 1U, regs->IPRXFCR);
+}
+
+TEST(QSPI_Watermark, adaptive_mode_follows_the_transfer_size)
+{
+    fpga_sample_t sample;
+    uint8_t       bulk[512];
+
+    // The simulated TX FIFO is always empty, each write is a single refill
+    TEST_ASSERT_EQUAL_INT(0, QSPI_SetWatermarks(1, 1));
+#ifndef QSPI_NO_RECORDER
+    TEST_ASSERT_EQUAL_UINT64(WRITE_ACCESSES(sizeof(payload) / 8U, 1U, 1U), write_accesses());
+#endif
+
+    QSPI_SetWatermarkMode(QSPI_WATERMARK_ADAPTIVE);
+    TEST_ASSERT_EQUAL_INT(QSPI_WATERMARK_ADAPTIVE, QSPI_GetWatermarkMode());
+
+#ifndef QSPI_NO_RECORDER
+    TEST_ASSERT_EQUAL_UINT64(WRITE_ACCESSES(sizeof(payload) / (8U * QSPI_WATERMARK_MAX), QSPI_WATERMARK_MAX, 1U), write_accesses());
+#else
+    write_accesses();
+#endif
+    TEST_ASSERT_EQUAL_HEX32(WTR(QSPI_WATERMARK_MAX) | 1U, regs->IPTXFCR);
+
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Write(0, FPGA_LUT_IDX_WR_SPI1, payload, 24));
+    TEST_ASSERT_EQUAL_HEX32(WTR(3) | 1U, regs->IPTXFCR);
+    // A partial entry rounds up, the write is still one level
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Write(0, FPGA_LUT_IDX_WR_SPI1, payload, sizeof(sample)));
+    TEST_ASSERT_EQUAL_HEX32(WTR((sizeof(sample) + 7U) / 8U) | 1U, regs->IPTXFCR);
+
+    TEST_ASSERT_EQUAL_INT(0, QSPI_ReadSample(0, &sample, sizeof(sample)));
+    TEST_ASSERT_EQUAL_HEX32(WTR((sizeof(sample) + 7U) / 8U) | 1U, regs->IPRXFCR);
+
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Read(0, bulk, sizeof(bulk)));
+    TEST_ASSERT_EQUAL_HEX32(WTR(QSPI_WATERMARK_MAX) | 1U, regs->IPRXFCR);
+
+    // Setting levels returns to the fixed mode
+    TEST_ASSERT_EQUAL_INT(0, QSPI_SetWatermarks(4, 4));
+    TEST_ASSERT_EQUAL_INT(QSPI_WATERMARK_FIXED, QSPI_GetWatermarkMode());
+    TEST_ASSERT_EQUAL_INT(0, QSPI_Write(0, FPGA_LUT_IDX_WR_SPI1, payload, 24));
+    TEST_ASSERT_EQUAL_HEX32(WTR(4) | 1U, regs->IPTXFCR);
+}
+
+TEST(QSPI_Watermark, tx_refill_pushes_only_the_levels_that_fit)
+{
+#ifndef QSPI_NO_RECORDER
+    const uint32_t wm     = 4;
+    const uint32_t fit    = 3;                                 // Levels the FIFO has room for
+    const uint32_t levels = sizeof(payload) / (8U * wm);       // 32
+    const uint32_t refill = (levels + fit - 1U) / fit;         // 11, the last one pushes 2
+
+    TEST_ASSERT_EQUAL_INT(0, QSPI_SetWatermarks(wm, 1));
+    regs->IPTXFSTS = TX_FIFO_ENTRIES - fit * wm - 1U; // Room for 3 levels and a bit, not 4
+    QSPI_Recorder_Reset();
+
+    TEST_ASSERT_EQUAL_UINT64(WRITE_ACCESSES(levels, wm, refill), write_accesses());
+
+    size_t   count   = QSPI_Recorder_Snapshot(entries, QSPI_RECORDER_ENTRIES);
+    uint32_t polls   = 0;
+    uint32_t pushes  = 0;
+    uint32_t pending = 0; // Pushes since the last IPTXFSTS poll
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (entries[i].dir == QSPI_RECORDER_POLL && entries[i].addr == FSPI_ADDR(IPTXFSTS))
+        {
+            if (polls > 0)
+            {
+                TEST_ASSERT_EQUAL_UINT32(fit, pending);
+            }
+            polls++;
+            pending = 0;
+        }
+        else if (entries[i].dir == QSPI_RECORDER_WRITE && entries[i].addr == FSPI_ADDR(INTR) && entries[i].value == (1U << 6))
+        {
+            pushes++;
+            pending++;
+        }
+    }
+
+    // The last IPTXWE write is the acknowledge after IPCMDDONE
+    TEST_ASSERT_EQUAL_UINT32(refill, polls);
+    TEST_ASSERT_EQUAL_UINT32(levels - (refill - 1U) * fit + 1U, pending);
+    TEST_ASSERT_EQUAL_UINT32(levels + 1U, pushes);
+#else
+    TEST_IGNORE_MESSAGE("Needs the register recorder");
+#endif
+}
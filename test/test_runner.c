@@ -5,3 +5,107 @@ TEST_GROUP_RUNNER(QSPI_Functional)
 {
     RUN_TEST_CASE(QSPI_Functional, QSPI_IsInitialized_before_initcall);
 }
+
+TEST_GROUP_RUNNER(FPGA_SPI)
+{
+    RUN_TEST_CASE(FPGA_SPI, tx_only_transfer_is_framed_into_one_write);
+    RUN_TEST_CASE(FPGA_SPI, rx_of_a_batch_is_read_once_and_scattered);
+    RUN_TEST_CASE(FPGA_SPI, oversized_transfer_is_rejected);
+}
+
+TEST_GROUP_RUNNER(QSPI_Coalesce)
+{
+    RUN_TEST_CASE(QSPI_Coalesce, register_writes_keep_only_the_last_value);
+    RUN_TEST_CASE(QSPI_Coalesce, command_writes_are_concatenated);
+    RUN_TEST_CASE(QSPI_Coalesce, other_opcode_flushes_the_pending_write);
+}
+
+TEST_GROUP_RUNNER(QSPI_Sched)
+{
+    RUN_TEST_CASE(QSPI_Sched, higher_class_is_dispatched_first);
+    RUN_TEST_CASE(QSPI_Sched, transfer_that_would_miss_the_sample_deadline_waits);
+    RUN_TEST_CASE(QSPI_Sched, oversized_transfer_runs_right_after_a_sample_read);
+}
+
+TEST_GROUP_RUNNER(QSPI_Recorder)
+{
+    RUN_TEST_CASE(QSPI_Recorder, write_records_the_command_and_fifo_accesses);
+    RUN_TEST_CASE(QSPI_Recorder, ring_keeps_the_newest_accesses);
+    RUN_TEST_CASE(QSPI_Recorder, a_stalled_wait_is_a_single_entry);
+}
+
+TEST_GROUP_RUNNER(QSPI_Status)
+{
+    RUN_TEST_CASE(QSPI_Status, subscribers_get_a_snapshot_after_each_transfer);
+    RUN_TEST_CASE(QSPI_Status, diff_reports_the_changed_registers);
+    RUN_TEST_CASE(QSPI_Status, callback_may_unsubscribe_itself);
+    RUN_TEST_CASE(QSPI_Status, block_is_not_read_without_subscribers_even_with_trace_logging);
+}
+
+TEST_GROUP_RUNNER(QSPI_Phase)
+{
+    RUN_TEST_CASE(QSPI_Phase, write_records_every_phase_and_one_sample_per_refill);
+    RUN_TEST_CASE(QSPI_Phase, percentiles_are_within_one_sub_bucket);
+}
+
+TEST_GROUP_RUNNER(QSPI_Metrics)
+{
+    RUN_TEST_CASE(QSPI_Metrics, transfers_are_counted_per_opcode);
+    RUN_TEST_CASE(QSPI_Metrics, spin_waits_are_counted_per_site_and_flagged_as_stalls);
+    RUN_TEST_CASE(QSPI_Metrics, command_errors_fail_the_transfer_and_are_counted);
+    RUN_TEST_CASE(QSPI_Metrics, error_raised_after_a_clean_transfer_is_counted_once_by_busy);
+    RUN_TEST_CASE(QSPI_Metrics, published_block_is_readable_from_the_segment);
+}
+
+TEST_GROUP_RUNNER(QSPI_Perf)
+{
+    RUN_TEST_CASE(QSPI_Perf, register_accesses_stay_within_budget);
+    RUN_TEST_CASE(QSPI_Perf, log_calls_stay_within_budget);
+    RUN_TEST_CASE(QSPI_Perf, latency_stays_within_budget);
+}
+
+TEST_GROUP_RUNNER(QSPI_Trace)
+{
+    RUN_TEST_CASE(QSPI_Trace, scheduled_transfer_shows_depth_dispatch_and_opcode);
+    RUN_TEST_CASE(QSPI_Trace, ring_keeps_the_newest_events_and_nothing_after_stop);
+}
+
+TEST_GROUP_RUNNER(QSPI_Sweep)
+{
+    RUN_TEST_CASE(QSPI_Sweep, settings_are_validated_and_restored_after_the_sweep);
+    RUN_TEST_CASE(QSPI_Sweep, every_setting_runs_the_workload_and_mismatches_count_as_errors);
+    RUN_TEST_CASE(QSPI_Sweep, command_errors_count_in_the_error_rate);
+}
+
+TEST_GROUP_RUNNER(QSPI_Watermark)
+{
+    RUN_TEST_CASE(QSPI_Watermark, rx_chunks_are_whole_64bit_entries);
+    RUN_TEST_CASE(QSPI_Watermark, adaptive_mode_follows_the_transfer_size);
+    RUN_TEST_CASE(QSPI_Watermark, tx_refill_pushes_only_the_levels_that_fit);
+}
+
+TEST_GROUP_RUNNER(FPGA_Clock)
+{
+    RUN_TEST_CASE(FPGA_Clock, rejects_settings_that_cannot_converge);
+    RUN_TEST_CASE(FPGA_Clock, small_offset_is_slewed_by_the_pi_terms);
+    RUN_TEST_CASE(FPGA_Clock, trim_is_limited_to_max_ppb);
+    RUN_TEST_CASE(FPGA_Clock, offset_past_the_threshold_is_stepped);
+}
+
+TEST_GROUP_RUNNER(FPGA_Audio)
+{
+    RUN_TEST_CASE(FPGA_Audio, frames_come_out_in_order_and_a_full_ring_drops);
+    RUN_TEST_CASE(FPGA_Audio, underrun_waits_for_the_full_latency_again);
+}
+
+TEST_GROUP_RUNNER(Slog)
+{
+    RUN_TEST_CASE(Slog, disabled_level_does_not_evaluate_its_arguments);
+    RUN_TEST_CASE(Slog, async_lines_come_out_in_time_order_and_drops_are_counted);
+    RUN_TEST_CASE(Slog, config_changes_wait_for_async_lines_being_rendered);
+    RUN_TEST_CASE(Slog, ratelimit_shows_a_burst_per_interval_and_reports_the_rest);
+    RUN_TEST_CASE(Slog, every_nth_shows_one_in_n_and_reports_the_rest);
+    RUN_TEST_CASE(Slog, limits_hold_across_threads_sharing_a_call_site);
+    RUN_TEST_CASE(Slog, binary_records_decode_to_the_printf_text);
+    RUN_TEST_CASE(Slog, file_sink_writes_long_lines_whole_and_follows_the_file_switch);
+}
@@ -0,0 +1,482 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "unity.h"
+#include "unity_fixture.h"
+
+#include <ctype.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "slog.h"
+#include "slog_bin.h"
+
+#define THREADS        6
+#define LINES          3000
+#define ASYNC_RECORDS  16
+
+/* What the callback saw, only touched by the thread that delivers the lines */
+typedef struct
+{
+    int      lines;
+    int      dropped;
+    int      out_of_order;
+    int      last[THREADS];
+    uint32_t last_ms;
+    int      limited;      // "limited" lines shown by the rate limited call sites
+    int      limited_last; // Argument of the last one
+    int      suppressed;   // Sum of the "similar messages suppressed" reports
+    int      torn;         // "seq" lines without one whole separator of SEPARATORS
+} log_capture_t;
+
+/* Separators switched while async lines are rendered, the first is the default after the tag */
+static const char *const SEPARATORS[] = {"> ", " [odd] ", " {even} "};
+
+static log_capture_t capture;
+
+static int capture_log(const char *pLog, size_t nLength, slog_flag_t eFlag, void *pCtx)
+{
+    (void)nLength;
+    (void)eFlag;
+    (void)pCtx;
+
+    unsigned    h, m, s, ms, count;
+    int         thread, seq;
+    const char *tag = strstr(pLog, "> ");
+    const char *msg = strstr(pLog, "seq ");
+    const char *sup = strstr(pLog, " similar messages suppressed");
+    const char *lim = strstr(pLog, "limited ");
+
+    if (sup != NULL)
+    {
+        while (sup > pLog && isdigit((unsigned char)sup[-1]))
+        {
+            sup--;
+        }
+        capture.suppressed += atoi(sup);
+        return 0;
+    }
+    if (lim != NULL)
+    {
+        capture.limited++;
+        capture.limited_last = atoi(lim + 8);
+        return 0;
+    }
+
+    if (strstr(pLog, "log messages dropped") != NULL && tag != NULL && sscanf(tag + 2, "%u", &count) == 1)
+    {
+        capture.dropped += (int)count;
+        return 0;
+    }
+    if (msg == NULL || sscanf(msg, "seq %d %d", &thread, &seq) != 2 || thread < 0 || thread >= THREADS)
+    {
+        return 0;
+    }
+
+    int whole = 0;
+    for (size_t i = 0; i < sizeof(SEPARATORS) / sizeof(SEPARATORS[0]); i++)
+    {
+        size_t length = strlen(SEPARATORS[i]);
+        whole |= (size_t)(msg - pLog) >= length && memcmp(msg - length, SEPARATORS[i], length) == 0;
+    }
+    capture.torn += !whole;
+
+    /* Printed time of day in ms, a line dated before the previous one came out of order */
+    if (sscanf(pLog, "%u:%u:%u.%u", &h, &m, &s, &ms) != 4)
+    {
+        capture.out_of_order++;
+        return 0;
+    }
+    uint32_t now = ((h * 60 + m) * 60 + s) * 1000 + ms;
+    if (now < capture.last_ms && capture.last_ms - now < 12 * 3600 * 1000)
+    {
+        capture.out_of_order++;
+    }
+    if (seq <= capture.last[thread])
+    {
+        capture.out_of_order++;
+    }
+    capture.last_ms      = now;
+    capture.last[thread] = seq;
+    capture.lines++;
+    return 0;
+}
+
+/* One call site each, their slog_limit_t lives across the calls */
+static void limited_burst(int i)
+{
+    slogw_limit(3, 100, "limited %d", i);
+}
+
+static void limited_every(int i)
+{
+    slogw_every(4, "limited %d", i);
+}
+
+static void limited_shared_burst(int i)
+{
+    slogw_limit(5, 60 * 1000, "limited %d", i);
+}
+
+static void limited_shared_every(int i)
+{
+    slogw_every(10, "limited %d", i);
+}
+
+static void *flood_limited(void *arg)
+{
+    void (*site)(int) = *(void (**)(int))arg;
+
+    for (int i = 0; i < LINES; i++)
+    {
+        site(i);
+    }
+    return NULL;
+}
+
+static void run_threads(void *(*fn)(void *), void *arg)
+{
+    pthread_t threads[THREADS];
+
+    for (int i = 0; i < THREADS; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, fn, arg));
+    }
+    for (int i = 0; i < THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+static void *log_lines(void *arg)
+{
+    int thread = (int)(intptr_t)arg;
+
+    for (int i = 1; i <= LINES; i++)
+    {
+        slogi("seq %d %d", thread, i);
+    }
+    return NULL;
+}
+
+#define BIN_MESSAGES_MAX 8
+
+/* Messages of a binary log rendered by slog_bin_render(), with their payload sizes */
+typedef struct
+{
+    char     text[BIN_MESSAGES_MAX][256];
+    uint16_t payload[BIN_MESSAGES_MAX];
+    int      count;
+} bin_log_t;
+
+static void decode_binary(const char *path, bin_log_t *log)
+{
+    static char       formats[BIN_MESSAGES_MAX + 1][256];
+    uint8_t           payload[UINT16_MAX];
+    char              magic[sizeof(SLOG_BIN_MAGIC) - 1];
+    slog_bin_header_t hdr;
+    FILE             *file = fopen(path, "rb");
+
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_size_t(sizeof(magic), fread(magic, 1, sizeof(magic), file));
+    TEST_ASSERT_EQUAL_MEMORY(SLOG_BIN_MAGIC, magic, sizeof(magic));
+    memset(log, 0, sizeof(*log));
+
+    while (fread(&hdr, sizeof(hdr), 1, file) == 1)
+    {
+        TEST_ASSERT_EQUAL_size_t(hdr.nPayload, fread(payload, 1, hdr.nPayload, file));
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(BIN_MESSAGES_MAX, hdr.nFormatId);
+
+        if (hdr.nType == SLOG_BIN_FORMAT)
+        {
+            TEST_ASSERT_LESS_THAN_UINT16(sizeof(formats[0]), hdr.nPayload);
+            memcpy(formats[hdr.nFormatId], payload, hdr.nPayload);
+            continue;
+        }
+
+        TEST_ASSERT_LESS_THAN_INT(BIN_MESSAGES_MAX, log->count);
+        FILE *out = tmpfile();
+        TEST_ASSERT_NOT_NULL(out);
+        slog_bin_render(out, formats[hdr.nFormatId], payload, hdr.nPayload);
+        rewind(out);
+        size_t n = fread(log->text[log->count], 1, sizeof(log->text[0]) - 1, out);
+        log->text[log->count][n] = '\0';
+        log->payload[log->count++] = hdr.nPayload;
+        fclose(out);
+    }
+    fclose(file);
+}
+
+/* Contents of the log file in dir whose name starts with prefix, NUL terminated */
+static char *read_log_file(const char *dir, const char *prefix)
+{
+    char           path[512];
+    struct dirent *entry;
+    DIR           *d    = opendir(dir);
+    char          *text = NULL;
+
+    TEST_ASSERT_NOT_NULL(d);
+    while ((entry = readdir(d)) != NULL)
+    {
+        if (strncmp(entry->d_name, prefix, strlen(prefix)) != 0)
+        {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        FILE *file = fopen(path, "rb");
+        TEST_ASSERT_NOT_NULL(file);
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        rewind(file);
+        text = malloc((size_t)size + 1);
+        TEST_ASSERT_NOT_NULL(text);
+        TEST_ASSERT_EQUAL_size_t((size_t)size, fread(text, 1, (size_t)size, file));
+        text[size] = '\0';
+        fclose(file);
+        unlink(path);
+        break;
+    }
+    closedir(d);
+    TEST_ASSERT_NOT_NULL_MESSAGE(text, prefix);
+    return text;
+}
+
+TEST_GROUP(Slog);
+
+TEST_SETUP(Slog)
+{
+    memset(&capture, 0, sizeof(capture));
+
+    slog_init("test", SLOG_FLAGS_ALL, 1);
+    slog_callback_set(capture_log, NULL);
+
+    slog_config_t cfg;
+    slog_config_get(&cfg);
+    cfg.nToScreen    = 0;
+    cfg.eColorFormat = SLOG_COLORING_DISABLE;
+    cfg.eDateControl = SLOG_TIME_ONLY;
+    slog_config_set(&cfg);
+}
+
+TEST_TEAR_DOWN(Slog)
+{
+    slog_destroy();
+}
+
+/* Counts its evaluations, to see whether a log call evaluated its arguments */
+static int evaluated;
+
+static int side_effect(void)
+{
+    return ++evaluated;
+}
+
+TEST(Slog, disabled_level_does_not_evaluate_its_arguments)
+{
+    slog_config_t cfg;
+
+    slog_config_get(&cfg);
+    cfg.nFlags = SLOG_FLAGS_ALL & ~SLOG_DEBUG;
+    slog_config_set(&cfg);
+
+    evaluated = 0;
+    slogd("seq %d", side_effect());
+    slogw_limit(1, 1000, "seq %d", side_effect()); // Enabled level, the argument is evaluated once
+    TEST_ASSERT_EQUAL_INT(1, evaluated);
+
+    cfg.nFlags = SLOG_FLAGS_ALL;
+    slog_config_set(&cfg);
+    slogd("seq %d", side_effect());
+    TEST_ASSERT_EQUAL_INT(2, evaluated);
+}
+
+TEST(Slog, async_lines_come_out_in_time_order_and_drops_are_counted)
+{
+    pthread_t threads[THREADS];
+
+    TEST_ASSERT_EQUAL_INT(0, slog_async_start(ASYNC_RECORDS));
+    for (int i = 0; i < THREADS; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, log_lines, (void *)(intptr_t)i));
+    }
+    for (int i = 0; i < THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    slog_async_stop();
+
+    TEST_ASSERT_EQUAL_INT(0, capture.out_of_order);
+    TEST_ASSERT_EQUAL_INT(THREADS * LINES, capture.lines + capture.dropped);
+    TEST_ASSERT_GREATER_THAN_INT(0, capture.lines);
+}
+
+TEST(Slog, config_changes_wait_for_async_lines_being_rendered)
+{
+    pthread_t     threads[THREADS];
+    slog_config_t cfg;
+
+    TEST_ASSERT_EQUAL_INT(0, slog_async_start(ASYNC_RECORDS));
+    for (int i = 0; i < THREADS; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, log_lines, (void *)(intptr_t)i));
+    }
+
+    // Lines logged during a change go synchronous, only their order is not kept
+    slog_config_get(&cfg);
+    for (int i = 0; i < 20000; i++)
+    {
+        snprintf(cfg.sSeparator, sizeof(cfg.sSeparator), "%s", SEPARATORS[1 + i % 2]);
+        slog_config_set(&cfg);
+    }
+
+    for (int i = 0; i < THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    slog_async_stop();
+
+    TEST_ASSERT_EQUAL_INT(0, capture.torn);
+    TEST_ASSERT_EQUAL_INT(THREADS * LINES, capture.lines + capture.dropped);
+}
+
+TEST(Slog, ratelimit_shows_a_burst_per_interval_and_reports_the_rest)
+{
+    struct timespec interval = {.tv_nsec = 150 * 1000 * 1000};
+
+    for (int i = 0; i < 10; i++)
+    {
+        limited_burst(i);
+    }
+    TEST_ASSERT_EQUAL_INT(3, capture.limited);
+    TEST_ASSERT_EQUAL_INT(2, capture.limited_last);
+    TEST_ASSERT_EQUAL_INT(0, capture.suppressed);
+
+    // The first message of the next interval carries the count of the previous one
+    nanosleep(&interval, NULL);
+    limited_burst(10);
+    TEST_ASSERT_EQUAL_INT(4, capture.limited);
+    TEST_ASSERT_EQUAL_INT(10, capture.limited_last);
+    TEST_ASSERT_EQUAL_INT(7, capture.suppressed);
+}
+
+TEST(Slog, every_nth_shows_one_in_n_and_reports_the_rest)
+{
+    for (int i = 0; i < 10; i++)
+    {
+        limited_every(i);
+    }
+    TEST_ASSERT_EQUAL_INT(3, capture.limited); // 0, 4 and 8
+    TEST_ASSERT_EQUAL_INT(8, capture.limited_last);
+    TEST_ASSERT_EQUAL_INT(6, capture.suppressed);
+}
+
+TEST(Slog, limits_hold_across_threads_sharing_a_call_site)
+{
+    void (*site)(int) = limited_shared_burst;
+    run_threads(flood_limited, &site);
+    TEST_ASSERT_EQUAL_INT(5, capture.limited);
+    TEST_ASSERT_EQUAL_INT(0, capture.suppressed);
+
+    memset(&capture, 0, sizeof(capture));
+    site = limited_shared_every;
+    run_threads(flood_limited, &site);
+    TEST_ASSERT_EQUAL_INT(THREADS * LINES / 10, capture.limited);
+    TEST_ASSERT_LESS_OR_EQUAL_INT(THREADS * LINES - capture.limited, capture.suppressed);
+}
+
+TEST(Slog, binary_records_decode_to_the_printf_text)
+{
+    const char name[3] = {'a', 'b', 'c'}; // Not NUL terminated, only read through a precision
+    char       format[32];
+    char       expected[256];
+    bin_log_t  log;
+    char       path[] = "/tmp/slog_bin_XXXXXX";
+    int        fd     = mkstemp(path);
+
+    TEST_ASSERT_NOT_EQUAL(-1, fd);
+    close(fd);
+    TEST_ASSERT_EQUAL_INT(0, slog_binary_open(path, SLOG_INFO, 0));
+
+    slogi("int %d %5u %-3x %lld %zu|", -7, 42U, 0xABU, -1234567890123LL, (size_t)99);
+    slogi("chr %c str %s %.3s %.*s %.*s|", 'q', "full", name, 2, "abcdef", -1, "neg");
+    slogi("flt %.2f %e %% %p|", 3.14159, 1e-3, (void *)0x1234);
+
+    // Same buffer, different text: each needs its own format id
+    strcpy(format, "dyn one %d");
+    slog_display(SLOG_INFO, 1, format, 1);
+    strcpy(format, "dyn two %s");
+    slog_display(SLOG_INFO, 1, format, "x");
+
+    slog_binary_close();
+    decode_binary(path, &log);
+    unlink(path);
+
+    TEST_ASSERT_EQUAL_INT(5, log.count);
+    snprintf(expected, sizeof(expected), "int %d %5u %-3x %lld %zu|", -7, 42U, 0xABU, -1234567890123LL, (size_t)99);
+    TEST_ASSERT_EQUAL_STRING(expected, log.text[0]);
+    TEST_ASSERT_EQUAL_STRING("chr q str full abc ab neg|", log.text[1]);
+    // 'q', "full", "abc", 2 and "ab", -1 and "neg": no byte past a precision is stored
+    TEST_ASSERT_EQUAL_UINT16(8 + (2 + 4) + (2 + 3) + 8 + (2 + 2) + 8 + (2 + 3), log.payload[1]);
+    snprintf(expected, sizeof(expected), "flt %.2f %e %% %p|", 3.14159, 1e-3, (void *)0x1234);
+    TEST_ASSERT_EQUAL_STRING(expected, log.text[2]);
+    TEST_ASSERT_EQUAL_STRING("dyn one 1", log.text[3]);
+    TEST_ASSERT_EQUAL_STRING("dyn two x", log.text[4]);
+}
+
+TEST(Slog, file_sink_writes_long_lines_whole_and_follows_the_file_switch)
+{
+    static char   line[6000];
+    char          dir[] = "/tmp/slog_sink_XXXXXX";
+    slog_config_t cfg;
+
+    TEST_ASSERT_NOT_NULL(mkdtemp(dir));
+    for (size_t i = 0; i < sizeof(line) - 1; i++)
+    {
+        line[i] = (char)('a' + i % 26);
+    }
+    line[sizeof(line) - 1] = '\0';
+
+    slog_config_get(&cfg);
+    cfg.nToFile = 1;
+    cfg.nRotate = 1;
+    snprintf(cfg.sFilePath, sizeof(cfg.sFilePath), "%s", dir);
+    snprintf(cfg.sFileName, sizeof(cfg.sFileName), "first");
+    slog_config_set(&cfg);
+
+    // Each line is several times the buffer, it used to be cut at the buffer size
+    TEST_ASSERT_EQUAL_INT(0, slog_file_sink_start(SLOG_INFO_MAX, 1000));
+    slogi("long %s end", line);
+    slogi("short one");
+
+    // A new file name takes the same handoff and reopen as the daily rotation
+    snprintf(cfg.sFileName, sizeof(cfg.sFileName), "second");
+    slog_config_set(&cfg);
+    slogi("long %s end", line);
+    slogi("short two");
+    slog_file_sink_stop();
+
+    char *first  = read_log_file(dir, "first-");
+    char *second = read_log_file(dir, "second-");
+    rmdir(dir);
+
+    const char *found = strstr(first, line);
+    TEST_ASSERT_NOT_NULL(found);
+    TEST_ASSERT_EQUAL_STRING_LEN(" end\n", found + strlen(line), 5);
+    TEST_ASSERT_NOT_NULL(strstr(first, "short one"));
+    TEST_ASSERT_NULL(strstr(first, "short two"));
+
+    found = strstr(second, line);
+    TEST_ASSERT_NOT_NULL(found);
+    TEST_ASSERT_EQUAL_STRING_LEN(" end\n", found + strlen(line), 5);
+    TEST_ASSERT_NOT_NULL(strstr(second, "short two"));
+    TEST_ASSERT_NULL(strstr(second, "short one"));
+
+    free(first);
+    free(second);
+}
@@ -0,0 +1,65 @@
+/*
+ * Per-message cost of the synchronous slog path.
+ *
+ * Output goes to a callback that drops the line, so the numbers cover the
+ * prefix rendering and formatting only, not the terminal or the file system.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "slog.h"
+
+#define BENCH_MESSAGES 1000000
+
+static int discard(const char *pLog, size_t nLength, slog_flag_t eFlag, void *pCtx)
+{
+    (void)pLog;
+    (void)eFlag;
+    *(size_t *)pCtx += nLength;
+    return -1;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void run(const char *pName, slog_date_ctrl_t eDate, uint8_t nTraceTid, slog_coloring_t eColor)
+{
+    slog_config_t cfg;
+    size_t        nBytes = 0;
+
+    slog_config_get(&cfg);
+    cfg.eDateControl = eDate;
+    cfg.nTraceTid    = nTraceTid;
+    cfg.eColorFormat = eColor;
+    cfg.nToScreen    = 0;
+    slog_config_set(&cfg);
+    slog_callback_set(discard, &nBytes);
+
+    double start = now_ns();
+    for (int i = 0; i < BENCH_MESSAGES; i++)
+    {
+        slogi("sample %d addr=0x%08X", i, 0x1000U + (unsigned)i);
+    }
+    double elapsed = now_ns() - start;
+
+    printf("%-24s %8.1f ns/msg (%zu bytes)\n", pName, elapsed / BENCH_MESSAGES, nBytes);
+}
+
+int main(void)
+{
+    slog_init("bench", SLOG_FLAGS_ALL, 1);
+
+    run("time only", SLOG_TIME_ONLY, 0, SLOG_COLORING_TAG);
+    run("full date", SLOG_DATE_FULL, 0, SLOG_COLORING_TAG);
+    run("full date + tid", SLOG_DATE_FULL, 1, SLOG_COLORING_TAG);
+    run("full date + tid + color", SLOG_DATE_FULL, 1, SLOG_COLORING_FULL);
+
+    slog_destroy();
+    return EXIT_SUCCESS;
+}
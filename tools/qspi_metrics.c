@@ -0,0 +1,61 @@
+/*
+ * Textfile exporter for the QSPI per-opcode counters (see src/qspi_metrics.h).
+ *
+ * Usage: qspi_metrics [-o <file.prom>] [-i <seconds>]
+ * Maps the shared-memory segment of the process that called
+ * QSPI_Metrics_Publish() read-only and prints the counters in the Prometheus
+ * text format, or writes them to a node_exporter textfile collector file,
+ * once or every -i seconds.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "qspi_metrics.h"
+
+int main(int argc, char *argv[])
+{
+    const char *path     = NULL;
+    unsigned    interval = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            path = argv[++i];
+        }
+        else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+        {
+            interval = (unsigned)strtoul(argv[++i], NULL, 0);
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [-o <file.prom>] [-i <seconds>]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    const qspi_metrics_t *metrics = QSPI_Metrics_Attach();
+    if (metrics == NULL)
+    {
+        fprintf(stderr, "%s: no QSPI metrics segment, is the driver running?\n", QSPI_METRICS_SHM_NAME);
+        return EXIT_FAILURE;
+    }
+
+    int ret = 0;
+    do
+    {
+        ret = path != NULL ? QSPI_Metrics_WriteTextfile(metrics, path) : QSPI_Metrics_WriteText(metrics, stdout);
+        if (ret != 0)
+        {
+            fprintf(stderr, "%s: write failed (%d)\n", path != NULL ? path : "stdout", ret);
+            break;
+        }
+        fflush(stdout);
+    } while (interval != 0 && sleep(interval) == 0);
+
+    QSPI_Metrics_Detach(metrics);
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
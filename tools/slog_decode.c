@@ -0,0 +1,150 @@
+/*
+ * Offline decoder for binary slog files (see src/slog_bin.h).
+ *
+ * Usage: slog_decode <file.bin>
+ * Prints one text line per message in the usual slog layout.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "slog.h"
+#include "slog_bin.h"
+
+typedef struct
+{
+    char   **formats;
+    uint32_t count;
+} format_table_t;
+
+static const char *tag_name(uint8_t flag)
+{
+    switch (flag)
+    {
+    case SLOG_NOTE:
+        return "<note> ";
+    case SLOG_INFO:
+        return "<info> ";
+    case SLOG_WARN:
+        return "<warn> ";
+    case SLOG_DEBUG:
+        return "<debug> ";
+    case SLOG_ERROR:
+        return "<error> ";
+    case SLOG_TRACE:
+        return "<trace> ";
+    case SLOG_FATAL:
+        return "<fatal> ";
+    default:
+        return "";
+    }
+}
+
+/* Ids run from 1 to SLOG_BIN_FORMATS_MAX, anything else is a corrupt record */
+static int store_format(format_table_t *table, uint32_t id, char *format)
+{
+    if (id == 0 || id > SLOG_BIN_FORMATS_MAX)
+    {
+        return -1;
+    }
+    if (id >= table->count)
+    {
+        uint32_t count   = id + 64 < SLOG_BIN_FORMATS_MAX + 1 ? id + 64 : SLOG_BIN_FORMATS_MAX + 1;
+        char   **formats = realloc(table->formats, count * sizeof(*formats));
+        if (formats == NULL)
+        {
+            return -1;
+        }
+        memset(formats + table->count, 0, (count - table->count) * sizeof(*formats));
+        table->formats = formats;
+        table->count   = count;
+    }
+
+    free(table->formats[id]);
+    table->formats[id] = format;
+    return 0;
+}
+
+static void print_prefix(const slog_bin_header_t *hdr)
+{
+    time_t    sec = (time_t)(hdr->nTime / 1000000000ULL);
+    struct tm tm_info;
+
+    localtime_r(&sec, &tm_info);
+    printf("%04d.%02d.%02d-%02d:%02d:%02d.%06llu (%u) %s", tm_info.tm_year + 1900, tm_info.tm_mon + 1, tm_info.tm_mday, tm_info.tm_hour, tm_info.tm_min,
+           tm_info.tm_sec, (unsigned long long)(hdr->nTime % 1000000000ULL) / 1000, hdr->nTid, tag_name(hdr->nFlag));
+}
+
+int main(int argc, char *argv[])
+{
+    format_table_t    table = {NULL, 0};
+    slog_bin_header_t hdr;
+    char              magic[sizeof(SLOG_BIN_MAGIC) - 1];
+    uint8_t           payload[UINT16_MAX];
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s <binary log>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE *file = fopen(argv[1], "rb");
+    if (file == NULL)
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, SLOG_BIN_MAGIC, sizeof(magic)) != 0)
+    {
+        fprintf(stderr, "%s: not a binary slog file\n", argv[1]);
+        fclose(file);
+        return EXIT_FAILURE;
+    }
+
+    while (fread(&hdr, sizeof(hdr), 1, file) == 1)
+    {
+        if (fread(payload, 1, hdr.nPayload, file) != hdr.nPayload)
+        {
+            fprintf(stderr, "%s: truncated record\n", argv[1]);
+            break;
+        }
+
+        if (hdr.nType == SLOG_BIN_FORMAT)
+        {
+            char *format = malloc(hdr.nPayload + 1U);
+            if (format == NULL || store_format(&table, hdr.nFormatId, format) != 0)
+            {
+                fprintf(stderr, "%s: bad format record %u\n", argv[1], hdr.nFormatId);
+                free(format);
+                break;
+            }
+            memcpy(format, payload, hdr.nPayload);
+            format[hdr.nPayload] = '\0';
+        }
+        else if (hdr.nType == SLOG_BIN_MESSAGE)
+        {
+            print_prefix(&hdr);
+            if (hdr.nFormatId < table.count && table.formats[hdr.nFormatId] != NULL)
+            {
+                slog_bin_render(stdout, table.formats[hdr.nFormatId], payload, hdr.nPayload);
+            }
+            else
+            {
+                printf("<unknown format %u>", hdr.nFormatId);
+            }
+            putchar('\n');
+        }
+    }
+
+    for (uint32_t i = 0; i < table.count; i++)
+    {
+        free(table.formats[i]);
+    }
+    free(table.formats);
+    fclose(file);
+    return EXIT_SUCCESS;
+}